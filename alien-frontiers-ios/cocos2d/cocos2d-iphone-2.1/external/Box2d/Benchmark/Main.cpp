@@ -0,0 +1,921 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "Test.h"
+#include <Box2D/Rope/b2Rope.h>
+#include <Box2D/Rope/b2RopeBatch.h>
+#include <cstdio>
+#include <cstring>
+using namespace std;
+
+#include "../Testbed/Tests/AddPair.h"
+#include "../Testbed/Tests/ApplyForce.h"
+#include "../Testbed/Tests/BodyTypes.h"
+#include "../Testbed/Tests/Breakable.h"
+#include "../Testbed/Tests/Bridge.h"
+#include "../Testbed/Tests/BulletStorm.h"
+#include "../Testbed/Tests/BulletTest.h"
+#include "../Testbed/Tests/Cantilever.h"
+#include "../Testbed/Tests/Car.h"
+#include "../Testbed/Tests/ContinuousTest.h"
+#include "../Testbed/Tests/Chain.h"
+#include "../Testbed/Tests/CharacterCollision.h"
+#include "../Testbed/Tests/CollisionFiltering.h"
+#include "../Testbed/Tests/CollisionProcessing.h"
+#include "../Testbed/Tests/CompoundShapes.h"
+#include "../Testbed/Tests/Confined.h"
+#include "../Testbed/Tests/DistanceTest.h"
+#include "../Testbed/Tests/Dominos.h"
+#include "../Testbed/Tests/DynamicTreeTest.h"
+#include "../Testbed/Tests/EdgeShapes.h"
+#include "../Testbed/Tests/EdgeTest.h"
+#include "../Testbed/Tests/Gears.h"
+#include "../Testbed/Tests/ManyPyramids.h"
+#include "../Testbed/Tests/OneSidedPlatform.h"
+#include "../Testbed/Tests/Pinball.h"
+#include "../Testbed/Tests/PolyCollision.h"
+#include "../Testbed/Tests/PolyShapes.h"
+#include "../Testbed/Tests/Prismatic.h"
+#include "../Testbed/Tests/Pulleys.h"
+#include "../Testbed/Tests/Pyramid.h"
+#include "../Testbed/Tests/RayCast.h"
+#include "../Testbed/Tests/Revolute.h"
+#include "../Testbed/Tests/RopeJoint.h"
+#include "../Testbed/Tests/SensorTest.h"
+#include "../Testbed/Tests/ShapeEditing.h"
+#include "../Testbed/Tests/SliderCrank.h"
+#include "../Testbed/Tests/SphereStack.h"
+#include "../Testbed/Tests/TheoJansen.h"
+#include "../Testbed/Tests/Tiles.h"
+#include "../Testbed/Tests/TimeOfImpact.h"
+#include "../Testbed/Tests/VaryingFriction.h"
+#include "../Testbed/Tests/VaryingRestitution.h"
+#include "../Testbed/Tests/VerticalStack.h"
+#include "../Testbed/Tests/Web.h"
+
+// Headless benchmark for b2World::Step. Each scene is a Testbed test that is
+// stepped at a fixed rate with debug drawing disabled. The per-step averages of
+// the b2Profile counters are written as CSV or JSON so runs can be diffed.
+//
+// With -hash every Testbed scene is run and the final world state is hashed
+// instead. Builds with B2_DETERMINISTIC must reproduce Determinism.csv:
+//   Benchmark -hash | diff - Determinism.csv
+//
+// With -trace the b2Profiler zones of all steps are written as a Chrome trace.
+// Configure with -DBOX2D_PROFILER=ON to record them.
+//
+// With -stability the VerticalStack columns are stepped for a while and the run
+// fails if any box slides off its column. Use it to check solver changes:
+//   Benchmark -wide -stability
+
+struct BenchmarkResult
+{
+	const char* name;
+	int32 stepCount;
+	int32 bodyCount;
+	int32 jointCount;
+	int32 contactCount;
+	int32 proxyCount;
+
+	// Totals over all steps, in milliseconds.
+	float64 step;
+	float64 collide;
+	float64 solve;
+	float64 solveInit;
+	float64 solveVelocity;
+	float64 solvePosition;
+	float64 broadphase;
+	float64 solveTOI;
+
+	// Hash of the body states after the last step.
+	uint32 hash;
+};
+
+typedef void BenchmarkRunFcn(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler);
+
+struct BenchmarkEntry
+{
+	const char* name;
+	BenchmarkRunFcn* runFcn;
+};
+
+// Gives the benchmark access to the world of a Testbed test.
+template <typename T>
+class BenchmarkScene : public T
+{
+public:
+	b2World* GetWorld()
+	{
+		return this->m_world;
+	}
+};
+
+// FNV-1a over the transform and velocity of every body, in body list order.
+static uint32 HashWorld(b2World* world)
+{
+	uint32 hash = 2166136261U;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		float32 state[6];
+		state[0] = b->GetPosition().x;
+		state[1] = b->GetPosition().y;
+		state[2] = b->GetAngle();
+		state[3] = b->GetLinearVelocity().x;
+		state[4] = b->GetLinearVelocity().y;
+		state[5] = b->GetAngularVelocity();
+
+		const uint8* bytes = (const uint8*)state;
+		for (int32 i = 0; i < int32(sizeof(state)); ++i)
+		{
+			hash = (hash ^ bytes[i]) * 16777619U;
+		}
+	}
+	return hash;
+}
+
+template <typename T>
+void RunScene(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler)
+{
+	BenchmarkScene<T>* scene = new BenchmarkScene<T>;
+	b2World* world = scene->GetWorld();
+	world->SetTaskScheduler(scheduler);
+	world->SetProfiler(profiler);
+
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		scene->Step(settings);
+
+		const b2Profile& p = world->GetProfile();
+		result->step += p.step;
+		result->collide += p.collide;
+		result->solve += p.solve;
+		result->solveInit += p.solveInit;
+		result->solveVelocity += p.solveVelocity;
+		result->solvePosition += p.solvePosition;
+		result->broadphase += p.broadphase;
+		result->solveTOI += p.solveTOI;
+	}
+
+	result->stepCount = stepCount;
+	result->bodyCount = world->GetBodyCount();
+	result->jointCount = world->GetJointCount();
+	result->contactCount = world->GetContactCount();
+	result->proxyCount = world->GetProxyCount();
+	result->hash = HashWorld(world);
+
+	delete scene;
+}
+
+// PolyShapes with a body of each kind dropped every other step, so circle,
+// polygon and edge contacts are mixed.
+class MixedShapes : public PolyShapes
+{
+public:
+	void Step(Settings* settings)
+	{
+		if (m_stepCount % 2 == 0)
+		{
+			Create((m_stepCount / 2) % 5);
+		}
+
+		PolyShapes::Step(settings);
+	}
+};
+
+// A cloth of boxes hung from the ground by its top row. Neighbours are joined by
+// revolute joints and each cell is braced by a distance joint. The boxes don't
+// collide, so nearly all of the solver time goes to joints.
+class JointGrid : public Test
+{
+public:
+
+	enum
+	{
+		e_columns = 30,
+		e_rows = 30
+	};
+
+	JointGrid()
+	{
+		b2PolygonShape shape;
+		shape.SetAsBox(0.25f, 0.25f);
+
+		b2FixtureDef fd;
+		fd.shape = &shape;
+		fd.density = 1.0f;
+		fd.filter.groupIndex = -1;
+
+		b2Body* bodies[e_rows][e_columns];
+		for (int32 i = 0; i < e_rows; ++i)
+		{
+			for (int32 j = 0; j < e_columns; ++j)
+			{
+				b2BodyDef bd;
+				bd.type = b2_dynamicBody;
+				bd.position.Set(-15.0f + 1.0f * j, 40.0f - 1.0f * i);
+				bodies[i][j] = m_world->CreateBody(&bd);
+				bodies[i][j]->CreateFixture(&fd);
+			}
+		}
+
+		b2RevoluteJointDef rjd;
+		b2DistanceJointDef djd;
+		for (int32 i = 0; i < e_rows; ++i)
+		{
+			for (int32 j = 0; j < e_columns; ++j)
+			{
+				b2Body* body = bodies[i][j];
+				b2Vec2 p = body->GetPosition();
+
+				if (i == 0)
+				{
+					rjd.Initialize(m_groundBody, body, p + b2Vec2(0.0f, 0.5f));
+					m_world->CreateJoint(&rjd);
+				}
+				else
+				{
+					rjd.Initialize(bodies[i - 1][j], body, p + b2Vec2(0.0f, 0.5f));
+					m_world->CreateJoint(&rjd);
+				}
+
+				if (j > 0)
+				{
+					rjd.Initialize(bodies[i][j - 1], body, p - b2Vec2(0.5f, 0.0f));
+					m_world->CreateJoint(&rjd);
+				}
+
+				if (i > 0 && j > 0)
+				{
+					b2Body* other = bodies[i - 1][j - 1];
+					djd.Initialize(other, body, other->GetPosition(), p);
+					m_world->CreateJoint(&djd);
+				}
+			}
+		}
+	}
+};
+
+// Ragdolls with limited revolute joints dropped in a pile. Joints at a limit are
+// solved one at a time and the others in batches, so the batches change from
+// step to step.
+class Ragdolls : public Test
+{
+public:
+
+	enum
+	{
+		e_columns = 8,
+		e_rows = 6
+	};
+
+	Ragdolls()
+	{
+		{
+			b2BodyDef bd;
+			b2Body* ground = m_world->CreateBody(&bd);
+
+			b2EdgeShape shape;
+			shape.Set(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+			ground->CreateFixture(&shape, 0.0f);
+		}
+
+		int32 group = 1;
+		for (int32 i = 0; i < e_rows; ++i)
+		{
+			for (int32 j = 0; j < e_columns; ++j)
+			{
+				CreateRagdoll(b2Vec2(-14.0f + 4.0f * j, 4.0f + 6.0f * i), -group);
+				++group;
+			}
+		}
+	}
+
+	b2Body* CreatePart(const b2Vec2& position, float32 hx, float32 hy, int16 groupIndex)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position = position;
+		b2Body* body = m_world->CreateBody(&bd);
+
+		b2PolygonShape shape;
+		shape.SetAsBox(hx, hy);
+
+		b2FixtureDef fd;
+		fd.shape = &shape;
+		fd.density = 1.0f;
+		fd.friction = 0.6f;
+		fd.filter.groupIndex = groupIndex;
+		body->CreateFixture(&fd);
+		return body;
+	}
+
+	void Connect(b2Body* bodyA, b2Body* bodyB, const b2Vec2& anchor, float32 lower, float32 upper)
+	{
+		b2RevoluteJointDef jd;
+		jd.Initialize(bodyA, bodyB, anchor);
+		jd.enableLimit = true;
+		jd.lowerAngle = lower;
+		jd.upperAngle = upper;
+		m_world->CreateJoint(&jd);
+	}
+
+	void CreateRagdoll(const b2Vec2& p, int16 groupIndex)
+	{
+		b2Body* torso = CreatePart(p + b2Vec2(0.0f, 1.5f), 0.3f, 0.6f, groupIndex);
+		b2Body* head = CreatePart(p + b2Vec2(0.0f, 2.45f), 0.25f, 0.25f, groupIndex);
+		Connect(torso, head, p + b2Vec2(0.0f, 2.1f), -0.5f, 0.5f);
+
+		for (int32 side = -1; side <= 1; side += 2)
+		{
+			float32 x = 0.2f * side;
+			b2Body* thigh = CreatePart(p + b2Vec2(x, 0.6f), 0.12f, 0.3f, groupIndex);
+			b2Body* shin = CreatePart(p + b2Vec2(x, 0.0f), 0.1f, 0.3f, groupIndex);
+			Connect(torso, thigh, p + b2Vec2(x, 0.9f), -1.5f, 0.3f);
+			Connect(thigh, shin, p + b2Vec2(x, 0.3f), 0.0f, 2.0f);
+
+			float32 ax = 0.45f * side;
+			b2Body* upperArm = CreatePart(p + b2Vec2(ax, 1.8f), 0.1f, 0.25f, groupIndex);
+			b2Body* lowerArm = CreatePart(p + b2Vec2(ax, 1.3f), 0.08f, 0.25f, groupIndex);
+			Connect(torso, upperArm, p + b2Vec2(ax, 2.05f), -2.5f, 2.5f);
+			Connect(upperArm, lowerArm, p + b2Vec2(ax, 1.55f), -2.0f, 0.0f);
+		}
+	}
+};
+
+// Cables released from the horizontal. Ropes steps each b2Rope on its own and
+// RopeBatch steps them together in a b2RopeBatch. Both report the rope time as
+// the step and solve time and the rope vertices as bodies.
+const int32 k_ropeCount = 64;
+const int32 k_ropeVertexCount = 80;
+
+static void GetRopeDef(b2RopeDef* def, int32 index, b2Vec2* vertices, float32* masses)
+{
+	for (int32 i = 0; i < k_ropeVertexCount; ++i)
+	{
+		vertices[i].Set(0.25f * i, 2.0f * index);
+		masses[i] = 1.0f;
+	}
+	masses[0] = 0.0f;
+
+	def->vertices = vertices;
+	def->count = k_ropeVertexCount;
+	def->masses = masses;
+	def->gravity.Set(0.0f, -10.0f);
+	def->damping = 0.1f;
+	def->k2 = 1.0f;
+	def->k3 = 0.5f;
+}
+
+static void RunRopes(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler)
+{
+	B2_NOT_USED(scheduler);
+	B2_NOT_USED(profiler);
+
+	b2Vec2 vertices[k_ropeVertexCount];
+	float32 masses[k_ropeVertexCount];
+
+	b2Rope* ropes = new b2Rope[k_ropeCount];
+	for (int32 i = 0; i < k_ropeCount; ++i)
+	{
+		b2RopeDef def;
+		GetRopeDef(&def, i, vertices, masses);
+		ropes[i].Initialize(&def);
+	}
+
+	float32 timeStep = settings->hz > 0.0f ? 1.0f / settings->hz : 0.0f;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		b2Timer timer;
+		for (int32 j = 0; j < k_ropeCount; ++j)
+		{
+			ropes[j].Step(timeStep, settings->positionIterations);
+		}
+
+		float32 elapsed = timer.GetMilliseconds();
+		result->step += elapsed;
+		result->solve += elapsed;
+	}
+
+	result->stepCount = stepCount;
+	result->bodyCount = k_ropeCount * k_ropeVertexCount;
+
+	delete [] ropes;
+}
+
+static void RunRopeBatch(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler)
+{
+	B2_NOT_USED(profiler);
+
+	b2Vec2 vertices[k_ropeVertexCount];
+	float32 masses[k_ropeVertexCount];
+
+	b2RopeBatch batch;
+	batch.SetTaskScheduler(scheduler);
+	for (int32 i = 0; i < k_ropeCount; ++i)
+	{
+		b2RopeDef def;
+		GetRopeDef(&def, i, vertices, masses);
+		batch.AddRope(&def);
+	}
+
+	float32 timeStep = settings->hz > 0.0f ? 1.0f / settings->hz : 0.0f;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		b2Timer timer;
+		batch.Step(timeStep, settings->positionIterations);
+
+		float32 elapsed = timer.GetMilliseconds();
+		result->step += elapsed;
+		result->solve += elapsed;
+	}
+
+	result->stepCount = stepCount;
+	result->bodyCount = k_ropeCount * k_ropeVertexCount;
+}
+
+// Waves of debris replaced every k_debrisPeriod steps. Spawn creates and
+// destroys the bodies one at a time and BulkSpawn with b2World::CreateBodies
+// and DestroyBodies. The step time includes the spawning.
+const int32 k_debrisCount = 4000;
+const int32 k_debrisPeriod = 50;
+
+static void RunDebris(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler, bool bulk)
+{
+	b2World* world = new b2World(b2Vec2(0.0f, -10.0f));
+	world->SetTaskScheduler(scheduler);
+	world->SetProfiler(profiler);
+	world->SetWarmStarting(settings->enableWarmStarting > 0);
+	world->SetContinuousPhysics(settings->enableContinuous > 0);
+	world->SetSubStepping(settings->enableSubStepping > 0);
+	world->SetWideContactSolver(settings->enableWideContactSolver > 0);
+	world->SetWideJointSolver(settings->enableWideJointSolver > 0);
+	world->SetBodyStateArrays(settings->enableBodyStateArrays > 0);
+
+	{
+		b2BodyDef bd;
+		b2Body* ground = world->CreateBody(&bd);
+
+		b2EdgeShape shape;
+		shape.Set(b2Vec2(-60.0f, 0.0f), b2Vec2(60.0f, 0.0f));
+		ground->CreateFixture(&shape, 0.0f);
+	}
+
+	b2PolygonShape box;
+	box.SetAsBox(0.125f, 0.125f);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.125f;
+
+	b2BodyDef* defs = new b2BodyDef[k_debrisCount];
+	b2FixtureDef* fixtureDefs = new b2FixtureDef[k_debrisCount];
+	int32* fixtureCounts = new int32[k_debrisCount];
+	b2Body** bodies = new b2Body*[k_debrisCount];
+	for (int32 i = 0; i < k_debrisCount; ++i)
+	{
+		defs[i].type = b2_dynamicBody;
+		defs[i].position.Set(-50.0f + 0.5f * (i % 200), 2.0f + 0.5f * (i / 200));
+		fixtureDefs[i].shape = (i & 1) ? (b2Shape*)&circle : (b2Shape*)&box;
+		fixtureDefs[i].density = 1.0f;
+		fixtureCounts[i] = 1;
+	}
+
+	float32 timeStep = settings->hz > 0.0f ? 1.0f / settings->hz : 0.0f;
+	bool spawned = false;
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		b2Timer timer;
+		if (i % k_debrisPeriod == 0)
+		{
+			if (bulk)
+			{
+				if (spawned)
+				{
+					world->DestroyBodies(bodies, k_debrisCount);
+				}
+				world->CreateBodies(bodies, defs, k_debrisCount, fixtureDefs, fixtureCounts);
+			}
+			else
+			{
+				for (int32 j = 0; spawned && j < k_debrisCount; ++j)
+				{
+					world->DestroyBody(bodies[j]);
+				}
+				for (int32 j = 0; j < k_debrisCount; ++j)
+				{
+					bodies[j] = world->CreateBody(defs + j);
+					bodies[j]->CreateFixture(fixtureDefs + j);
+				}
+			}
+			spawned = true;
+		}
+
+		world->Step(timeStep, settings->velocityIterations, settings->positionIterations);
+		result->step += timer.GetMilliseconds();
+
+		const b2Profile& p = world->GetProfile();
+		result->collide += p.collide;
+		result->solve += p.solve;
+		result->solveInit += p.solveInit;
+		result->solveVelocity += p.solveVelocity;
+		result->solvePosition += p.solvePosition;
+		result->broadphase += p.broadphase;
+		result->solveTOI += p.solveTOI;
+	}
+
+	result->stepCount = stepCount;
+	result->bodyCount = world->GetBodyCount();
+	result->jointCount = world->GetJointCount();
+	result->contactCount = world->GetContactCount();
+	result->proxyCount = world->GetProxyCount();
+	result->hash = HashWorld(world);
+
+	delete [] bodies;
+	delete [] fixtureCounts;
+	delete [] fixtureDefs;
+	delete [] defs;
+	delete world;
+}
+
+static void RunSpawn(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler)
+{
+	RunDebris(result, settings, stepCount, scheduler, profiler, false);
+}
+
+static void RunBulkSpawn(BenchmarkResult* result, Settings* settings, int32 stepCount, b2TaskScheduler* scheduler, b2Profiler* profiler)
+{
+	RunDebris(result, settings, stepCount, scheduler, profiler, true);
+}
+
+// The VerticalStack columns must stay standing. The scalar solver keeps every
+// box within about 0.02 of where it started.
+const float32 k_stabilitySeconds = 25.0f;
+const float32 k_stabilityTolerance = 0.05f;
+
+static bool CheckStability(Settings* settings, b2TaskScheduler* scheduler)
+{
+	const int32 boxCount = VerticalStack::e_columnCount * VerticalStack::e_rowCount;
+
+	BenchmarkScene<VerticalStack>* scene = new BenchmarkScene<VerticalStack>;
+	scene->GetWorld()->SetTaskScheduler(scheduler);
+
+	float32 xs[boxCount];
+	for (int32 i = 0; i < boxCount; ++i)
+	{
+		xs[i] = scene->m_bodies[i]->GetPosition().x;
+	}
+
+	int32 stepCount = int32(k_stabilitySeconds * settings->hz);
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		scene->Step(settings);
+	}
+
+	float32 maxDrift = 0.0f;
+	int32 failCount = 0;
+	for (int32 i = 0; i < boxCount; ++i)
+	{
+		float32 drift = b2Abs(scene->m_bodies[i]->GetPosition().x - xs[i]);
+		maxDrift = b2Max(maxDrift, drift);
+		if (drift > k_stabilityTolerance)
+		{
+			++failCount;
+		}
+	}
+
+	delete scene;
+
+	printf("scene,steps,max_drift,moved,result\n");
+	printf("VerticalStack,%d,%.4f,%d,%s\n", stepCount, maxDrift, failCount, failCount == 0 ? "pass" : "fail");
+	return failCount == 0;
+}
+
+BenchmarkEntry g_benchmarkEntries[] =
+{
+	{"Pyramid", RunScene<Pyramid>},
+	{"ManyPyramids", RunScene<ManyPyramids>},
+	{"VerticalStack", RunScene<VerticalStack>},
+	{"Tiles", RunScene<Tiles>},
+	{"Web", RunScene<Web>},
+	{"Dominos", RunScene<Dominos>},
+	{"Bridge", RunScene<Bridge>},
+	{"Cantilever", RunScene<Cantilever>},
+	{"Car", RunScene<Car>},
+	{"Chain", RunScene<Chain>},
+	{"SphereStack", RunScene<SphereStack>},
+	{"TheoJansen", RunScene<TheoJansen>},
+	{"AddPair", RunScene<AddPair>},
+	{"BulletStorm", RunScene<BulletStorm>},
+	{"MixedShapes", RunScene<MixedShapes>},
+	{"JointGrid", RunScene<JointGrid>},
+	{"Ragdolls", RunScene<Ragdolls>},
+	{"Ropes", RunRopes},
+	{"RopeBatch", RunRopeBatch},
+	{"Spawn", RunSpawn},
+	{"BulkSpawn", RunBulkSpawn},
+	{NULL, NULL}
+};
+
+// All Testbed scenes, in the Testbed order.
+BenchmarkEntry g_hashEntries[] =
+{
+	{"Gears", RunScene<Gears>},
+	{"CharacterCollision", RunScene<CharacterCollision>},
+	{"EdgeTest", RunScene<EdgeTest>},
+	{"BodyTypes", RunScene<BodyTypes>},
+	{"ShapeEditing", RunScene<ShapeEditing>},
+	{"Tiles", RunScene<Tiles>},
+	{"Car", RunScene<Car>},
+	{"ApplyForce", RunScene<ApplyForce>},
+	{"Prismatic", RunScene<Prismatic>},
+	{"VerticalStack", RunScene<VerticalStack>},
+	{"SphereStack", RunScene<SphereStack>},
+	{"Revolute", RunScene<Revolute>},
+	{"Pulleys", RunScene<Pulleys>},
+	{"PolyShapes", RunScene<PolyShapes>},
+	{"Web", RunScene<Web>},
+	{"RopeJoint", RunScene<RopeJoint>},
+	{"OneSidedPlatform", RunScene<OneSidedPlatform>},
+	{"Pinball", RunScene<Pinball>},
+	{"BulletTest", RunScene<BulletTest>},
+	{"BulletStorm", RunScene<BulletStorm>},
+	{"ContinuousTest", RunScene<ContinuousTest>},
+	{"TimeOfImpact", RunScene<TimeOfImpact>},
+	{"RayCast", RunScene<RayCast>},
+	{"Confined", RunScene<Confined>},
+	{"Pyramid", RunScene<Pyramid>},
+	{"ManyPyramids", RunScene<ManyPyramids>},
+	{"VaryingRestitution", RunScene<VaryingRestitution>},
+	{"TheoJansen", RunScene<TheoJansen>},
+	{"EdgeShapes", RunScene<EdgeShapes>},
+	{"PolyCollision", RunScene<PolyCollision>},
+	{"Cantilever", RunScene<Cantilever>},
+	{"Bridge", RunScene<Bridge>},
+	{"Breakable", RunScene<Breakable>},
+	{"Chain", RunScene<Chain>},
+	{"CollisionFiltering", RunScene<CollisionFiltering>},
+	{"CollisionProcessing", RunScene<CollisionProcessing>},
+	{"CompoundShapes", RunScene<CompoundShapes>},
+	{"DistanceTest", RunScene<DistanceTest>},
+	{"Dominos", RunScene<Dominos>},
+	{"DynamicTreeTest", RunScene<DynamicTreeTest>},
+	{"SensorTest", RunScene<SensorTest>},
+	{"SliderCrank", RunScene<SliderCrank>},
+	{"VaryingFriction", RunScene<VaryingFriction>},
+	{"AddPair", RunScene<AddPair>},
+	{NULL, NULL}
+};
+
+enum OutputFormat
+{
+	e_csvFormat,
+	e_jsonFormat,
+	e_hashFormat
+};
+
+// Convert a total in milliseconds to an average per step in nanoseconds.
+static float64 PerStep(float64 totalMilliseconds, int32 stepCount)
+{
+	return stepCount > 0 ? 1.0e6 * totalMilliseconds / stepCount : 0.0;
+}
+
+static void PrintResult(const BenchmarkResult* r, OutputFormat format, bool first)
+{
+	int32 n = r->stepCount;
+
+	if (format == e_hashFormat)
+	{
+		printf("%s,%d,%08x\n", r->name, n, r->hash);
+		return;
+	}
+
+	if (format == e_csvFormat)
+	{
+		printf("%s,%d,%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f\n",
+			r->name, n, r->bodyCount, r->jointCount, r->contactCount, r->proxyCount,
+			PerStep(r->step, n), PerStep(r->collide, n), PerStep(r->solve, n),
+			PerStep(r->solveInit, n), PerStep(r->solveVelocity, n), PerStep(r->solvePosition, n),
+			PerStep(r->broadphase, n), PerStep(r->solveTOI, n));
+		return;
+	}
+
+	printf("%s\n    {\"scene\": \"%s\", \"steps\": %d, \"bodies\": %d, \"joints\": %d, \"contacts\": %d, \"proxies\": %d,\n",
+		first ? "" : ",", r->name, n, r->bodyCount, r->jointCount, r->contactCount, r->proxyCount);
+	printf("     \"ns_per_step\": %.0f, \"collide_ns\": %.0f, \"solve_ns\": %.0f, \"solve_init_ns\": %.0f,\n",
+		PerStep(r->step, n), PerStep(r->collide, n), PerStep(r->solve, n), PerStep(r->solveInit, n));
+	printf("     \"solve_velocity_ns\": %.0f, \"solve_position_ns\": %.0f, \"broadphase_ns\": %.0f, \"solve_toi_ns\": %.0f}",
+		PerStep(r->solveVelocity, n), PerStep(r->solvePosition, n), PerStep(r->broadphase, n), PerStep(r->solveTOI, n));
+}
+
+static void PrintUsage()
+{
+	printf("usage: Benchmark [-steps N] [-hz HZ] [-threads N] [-wide] [-widejoints] [-state] [-format csv|json] [-hash] [-stability] [-trace FILE] [-list] [scene ...]\n");
+}
+
+int main(int argc, char** argv)
+{
+	int32 stepCount = 1000;
+	int32 threadCount = 0;
+	OutputFormat format = e_csvFormat;
+	BenchmarkEntry* entries = g_benchmarkEntries;
+	const char* traceFileName = NULL;
+	bool stability = false;
+
+	Settings settings;
+	settings.drawShapes = 0;
+	settings.drawJoints = 0;
+
+	const char* names[64];
+	int32 nameCount = 0;
+
+	for (int32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+		{
+			stepCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+		{
+			threadCount = b2Clamp(atoi(argv[++i]), 0, b2_maxThreads);
+		}
+		else if (strcmp(argv[i], "-wide") == 0)
+		{
+			settings.enableWideContactSolver = 1;
+		}
+		else if (strcmp(argv[i], "-widejoints") == 0)
+		{
+			settings.enableWideJointSolver = 1;
+		}
+		else if (strcmp(argv[i], "-state") == 0)
+		{
+			settings.enableBodyStateArrays = 1;
+		}
+		else if (strcmp(argv[i], "-hz") == 0 && i + 1 < argc)
+		{
+			settings.hz = float32(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "-format") == 0 && i + 1 < argc)
+		{
+			++i;
+			if (strcmp(argv[i], "json") == 0)
+			{
+				format = e_jsonFormat;
+			}
+			else if (strcmp(argv[i], "csv") == 0)
+			{
+				format = e_csvFormat;
+			}
+			else
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-hash") == 0)
+		{
+			format = e_hashFormat;
+			entries = g_hashEntries;
+		}
+		else if (strcmp(argv[i], "-stability") == 0)
+		{
+			stability = true;
+		}
+		else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc)
+		{
+			traceFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-list") == 0)
+		{
+			for (BenchmarkEntry* e = entries; e->name; ++e)
+			{
+				printf("%s\n", e->name);
+			}
+			return 0;
+		}
+		else if (argv[i][0] != '-' && nameCount < 64)
+		{
+			names[nameCount++] = argv[i];
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	// Check the scene names before running anything.
+	for (int32 i = 0; i < nameCount; ++i)
+	{
+		bool found = false;
+		for (BenchmarkEntry* e = entries; e->name; ++e)
+		{
+			found = found || strcmp(e->name, names[i]) == 0;
+		}
+
+		if (found == false)
+		{
+			fprintf(stderr, "unknown scene: %s\n", names[i]);
+			return 1;
+		}
+	}
+
+	// Zero threads keeps the serial island solver.
+	b2ThreadPool* threadPool = NULL;
+	if (threadCount > 0)
+	{
+		threadPool = new b2ThreadPool(threadCount);
+	}
+
+	if (stability)
+	{
+		bool stable = CheckStability(&settings, threadPool);
+		delete threadPool;
+		return stable ? 0 : 1;
+	}
+
+	// The trace is empty unless Box2D is built with B2_PROFILER.
+	b2Profiler* profiler = NULL;
+	if (traceFileName != NULL)
+	{
+		profiler = new b2Profiler;
+	}
+
+	if (format == e_hashFormat)
+	{
+		printf("scene,steps,hash\n");
+	}
+	else if (format == e_csvFormat)
+	{
+		printf("scene,steps,bodies,joints,contacts,proxies,ns_per_step,collide_ns,solve_ns,"
+			"solve_init_ns,solve_velocity_ns,solve_position_ns,broadphase_ns,solve_toi_ns\n");
+	}
+	else
+	{
+		printf("{\"version\": \"%d.%d.%d\", \"hz\": %g, \"threads\": %d, \"wide\": %s, \"wide_joints\": %s, \"state\": %s, \"results\": [",
+			b2_version.major, b2_version.minor, b2_version.revision, settings.hz, threadCount,
+			settings.enableWideContactSolver ? "true" : "false", settings.enableWideJointSolver ? "true" : "false",
+			settings.enableBodyStateArrays ? "true" : "false");
+	}
+
+	bool first = true;
+	for (BenchmarkEntry* e = entries; e->name; ++e)
+	{
+		bool selected = nameCount == 0;
+		for (int32 i = 0; i < nameCount; ++i)
+		{
+			selected = selected || strcmp(e->name, names[i]) == 0;
+		}
+
+		if (selected == false)
+		{
+			continue;
+		}
+
+		BenchmarkResult result;
+		memset(&result, 0, sizeof(BenchmarkResult));
+		result.name = e->name;
+
+		// Some scenes use rand, so every scene starts from the same seed.
+		srand(0);
+		e->runFcn(&result, &settings, stepCount, threadPool, profiler);
+
+		PrintResult(&result, format, first);
+		fflush(stdout);
+		first = false;
+	}
+
+	if (format == e_jsonFormat)
+	{
+		printf("\n]}\n");
+	}
+
+	delete threadPool;
+
+	if (profiler != NULL)
+	{
+		bool written = profiler->WriteChromeTrace(traceFileName);
+		delete profiler;
+
+		if (written == false)
+		{
+			fprintf(stderr, "cannot write %s\n", traceFileName);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -18,18 +18,71 @@
 
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <new>
+#include <cstring>
+using namespace std;
+
+b2PolygonShape::b2PolygonShape(const b2PolygonShape& polygon)
+{
+	m_vertices = m_inlineVertices;
+	m_normals = m_inlineVertices;
+	m_vertexCount = 0;
+	*this = polygon;
+}
+
+b2PolygonShape& b2PolygonShape::operator=(const b2PolygonShape& polygon)
+{
+	if (this == &polygon)
+	{
+		return *this;
+	}
+
+	m_type = polygon.m_type;
+	m_radius = polygon.m_radius;
+	m_centroid = polygon.m_centroid;
+
+	SetVertexCount(polygon.m_vertexCount);
+	memcpy(m_vertices, polygon.m_vertices, m_vertexCount * sizeof(b2Vec2));
+	memcpy(m_normals, polygon.m_normals, m_vertexCount * sizeof(b2Vec2));
+	return *this;
+}
 
 b2Shape* b2PolygonShape::Clone(b2BlockAllocator* allocator) const
 {
 	void* mem = allocator->Allocate(sizeof(b2PolygonShape));
-	b2PolygonShape* clone = new (mem) b2PolygonShape;
-	*clone = *this;
+	b2PolygonShape* clone = new (mem) b2PolygonShape(*this);
 	return clone;
 }
 
+void b2PolygonShape::SetVertexCount(int32 count)
+{
+	b2Assert(0 <= count && count <= b2_maxPolygonVertices);
+
+	if (count == m_vertexCount)
+	{
+		return;
+	}
+
+	if (m_vertices != m_inlineVertices)
+	{
+		b2Free(m_vertices);
+	}
+
+	if (count <= b2_inlinePolygonVertices)
+	{
+		m_vertices = m_inlineVertices;
+	}
+	else
+	{
+		m_vertices = (b2Vec2*)b2Alloc(2 * count * sizeof(b2Vec2));
+	}
+
+	m_normals = m_vertices + count;
+	m_vertexCount = count;
+}
+
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 {
-	m_vertexCount = 4;
+	SetVertexCount(4);
 	m_vertices[0].Set(-hx, -hy);
 	m_vertices[1].Set( hx, -hy);
 	m_vertices[2].Set( hx,  hy);
@@ -43,7 +96,7 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, float32 angle)
 {
-	m_vertexCount = 4;
+	SetVertexCount(4);
 	m_vertices[0].Set(-hx, -hy);
 	m_vertices[1].Set( hx, -hy);
 	m_vertices[2].Set( hx,  hy);
@@ -120,13 +173,12 @@ static b2Vec2 ComputeCentroid(const b2Vec2* vs, int32 count)
 void b2PolygonShape::Set(const b2Vec2* vertices, int32 count)
 {
 	b2Assert(3 <= count && count <= b2_maxPolygonVertices);
-	m_vertexCount = count;
 
-	// Copy vertices.
-	for (int32 i = 0; i < m_vertexCount; ++i)
-	{
-		m_vertices[i] = vertices[i];
-	}
+	// Copy vertices. They may be our own, so copy them before the storage changes.
+	b2Vec2 ps[b2_maxPolygonVertices];
+	memcpy(ps, vertices, count * sizeof(b2Vec2));
+	SetVertexCount(count);
+	memcpy(m_vertices, ps, count * sizeof(b2Vec2));
 
 	// Compute normals. Ensure the edges have non-zero length.
 	for (int32 i = 0; i < m_vertexCount; ++i)
@@ -21,15 +21,27 @@
 
 #include <Box2D/Collision/Shapes/b2Shape.h>
 
+/// Polygons with up to this many vertices keep them inside the shape. Larger
+/// polygons allocate storage for exactly their vertex count using b2Alloc.
+const int32 b2_inlinePolygonVertices = 4;
+
 /// A convex polygon. It is assumed that the interior of the polygon is to
 /// the left of each edge.
 /// Polygons have a maximum number of vertices equal to b2_maxPolygonVertices.
 /// In most cases you should not need many vertices for a convex polygon.
+/// The normals directly follow the vertices in memory.
 class b2PolygonShape : public b2Shape
 {
 public:
 	b2PolygonShape();
 
+	/// Copies the vertices.
+	b2PolygonShape(const b2PolygonShape& polygon);
+	b2PolygonShape& operator=(const b2PolygonShape& polygon);
+
+	/// The destructor frees the vertices if they were allocated.
+	~b2PolygonShape();
+
 	/// Implement b2Shape.
 	b2Shape* Clone(b2BlockAllocator* allocator) const;
 
@@ -72,20 +84,39 @@ public:
 	/// Get a vertex by index.
 	const b2Vec2& GetVertex(int32 index) const;
 
+	/// Make room for count vertices and normals without setting them. This is
+	/// for filling m_vertices and m_normals directly.
+	void SetVertexCount(int32 count);
+
 	b2Vec2 m_centroid;
-	b2Vec2 m_vertices[b2_maxPolygonVertices];
-	b2Vec2 m_normals[b2_maxPolygonVertices];
+	b2Vec2* m_vertices;
+	b2Vec2* m_normals;
 	int32 m_vertexCount;
+
+private:
+
+	// The vertices followed by the normals of small polygons.
+	b2Vec2 m_inlineVertices[2 * b2_inlinePolygonVertices];
 };
 
 inline b2PolygonShape::b2PolygonShape()
 {
 	m_type = e_polygon;
 	m_radius = b2_polygonRadius;
+	m_vertices = m_inlineVertices;
+	m_normals = m_inlineVertices;
 	m_vertexCount = 0;
 	m_centroid.SetZero();
 }
 
+inline b2PolygonShape::~b2PolygonShape()
+{
+	if (m_vertices != m_inlineVertices)
+	{
+		b2Free(m_vertices);
+	}
+}
+
 inline const b2Vec2& b2PolygonShape::GetVertex(int32 index) const
 {
 	b2Assert(0 <= index && index < m_vertexCount);
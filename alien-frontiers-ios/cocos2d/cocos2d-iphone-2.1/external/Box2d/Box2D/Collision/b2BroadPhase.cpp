@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <cstring>
 using namespace std;
 
@@ -24,6 +25,23 @@ b2BroadPhase::b2BroadPhase()
 {
 	m_proxyCount = 0;
 
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_treeProxyCounts[i] = 0;
+	}
+	m_staticChangeCount = 0;
+
+	m_proxyCapacity = 16;
+	m_proxies = (b2BroadPhaseProxy*)b2Alloc(m_proxyCapacity * sizeof(b2BroadPhaseProxy));
+	m_freeProxy = b2_nullNode;
+	for (int32 i = m_proxyCapacity - 1; i >= 0; --i)
+	{
+		m_proxies[i].userData = NULL;
+		m_proxies[i].next = m_freeProxy;
+		m_proxies[i].tree = e_nullTree;
+		m_freeProxy = i;
+	}
+
 	m_pairCapacity = 16;
 	m_pairCount = 0;
 	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
@@ -37,28 +55,224 @@ b2BroadPhase::~b2BroadPhase()
 {
 	b2Free(m_moveBuffer);
 	b2Free(m_pairBuffer);
+	b2Free(m_proxies);
 }
 
-int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+void b2BroadPhase::Reset()
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].Reset();
+		m_treeProxyCounts[i] = 0;
+	}
+	m_staticChangeCount = 0;
+
+	m_freeProxy = b2_nullNode;
+	for (int32 i = m_proxyCapacity - 1; i >= 0; --i)
+	{
+		m_proxies[i].userData = NULL;
+		m_proxies[i].next = m_freeProxy;
+		m_proxies[i].tree = e_nullTree;
+		m_freeProxy = i;
+	}
+
+	m_proxyCount = 0;
+	m_moveCount = 0;
+	m_moveSet.Clear();
+	m_pairCount = 0;
+}
+
+// Take a proxy id from the free list, growing the proxy pool as needed.
+int32 b2BroadPhase::AllocateProxy()
+{
+	if (m_freeProxy == b2_nullNode)
+	{
+		b2BroadPhaseProxy* oldProxies = m_proxies;
+		int32 oldCapacity = m_proxyCapacity;
+		m_proxyCapacity *= 2;
+		m_proxies = (b2BroadPhaseProxy*)b2Alloc(m_proxyCapacity * sizeof(b2BroadPhaseProxy));
+		memcpy(m_proxies, oldProxies, oldCapacity * sizeof(b2BroadPhaseProxy));
+		b2Free(oldProxies);
+
+		for (int32 i = m_proxyCapacity - 1; i >= oldCapacity; --i)
+		{
+			m_proxies[i].userData = NULL;
+			m_proxies[i].next = m_freeProxy;
+			m_proxies[i].tree = e_nullTree;
+			m_freeProxy = i;
+		}
+	}
+
+	int32 proxyId = m_freeProxy;
+	m_freeProxy = m_proxies[proxyId].next;
 	++m_proxyCount;
+	return proxyId;
+}
+
+void b2BroadPhase::FreeProxy(int32 proxyId)
+{
+	b2Assert(0 < m_proxyCount);
+	m_proxies[proxyId].userData = NULL;
+	m_proxies[proxyId].next = m_freeProxy;
+	m_proxies[proxyId].tree = e_nullTree;
+	m_freeProxy = proxyId;
+	--m_proxyCount;
+}
+
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData, int32 tree)
+{
+	b2Assert(0 <= tree && tree < e_treeCount);
+
+	int32 proxyId = AllocateProxy();
+	b2BroadPhaseProxy* proxy = m_proxies + proxyId;
+	proxy->userData = userData;
+	proxy->treeProxyId = m_trees[tree].CreateProxy(aabb, (void*)size_t(proxyId));
+	proxy->tree = tree;
+	++m_treeProxyCounts[tree];
+
+	if (tree == e_staticTree)
+	{
+		++m_staticChangeCount;
+	}
+
 	BufferMove(proxyId);
 	return proxyId;
 }
 
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2BroadPhaseProxy* proxy = m_proxies + proxyId;
+	b2Assert(proxy->tree != e_nullTree);
+
 	UnBufferMove(proxyId);
-	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
+	m_trees[proxy->tree].DestroyProxy(proxy->treeProxyId);
+	--m_treeProxyCounts[proxy->tree];
+	FreeProxy(proxyId);
+}
+
+void b2BroadPhase::CreateProxies(int32* proxyIds, const b2AABB* aabbs, void* const* userData, int32 count, int32 tree)
+{
+	b2Assert(0 <= tree && tree < e_treeCount);
+
+	if (b2_bulkRebuildFactor * count < m_treeProxyCounts[tree])
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			proxyIds[i] = CreateProxy(aabbs[i], userData[i], tree);
+		}
+		return;
+	}
+
+	int32* treeProxyIds = (int32*)b2Alloc(count * sizeof(int32));
+	void** treeUserData = (void**)b2Alloc(count * sizeof(void*));
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateProxy();
+		m_proxies[proxyId].userData = userData[i];
+		m_proxies[proxyId].tree = tree;
+		proxyIds[i] = proxyId;
+		treeUserData[i] = (void*)size_t(proxyId);
+	}
+
+	m_trees[tree].CreateProxies(treeProxyIds, aabbs, treeUserData, count);
+	m_treeProxyCounts[tree] += count;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_proxies[proxyIds[i]].treeProxyId = treeProxyIds[i];
+		BufferMove(proxyIds[i]);
+	}
+
+	// The static tree was just rebuilt.
+	if (tree == e_staticTree)
+	{
+		m_staticChangeCount = 0;
+	}
+
+	b2Free(treeUserData);
+	b2Free(treeProxyIds);
+}
+
+void b2BroadPhase::DestroyProxies(const int32* proxyIds, int32 count)
+{
+	// Group the proxies by tree.
+	int32 removeCounts[e_treeCount];
+	int32 removeStarts[e_treeCount];
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		removeCounts[i] = 0;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Assert(0 <= proxyIds[i] && proxyIds[i] < m_proxyCapacity);
+		b2Assert(m_proxies[proxyIds[i]].tree != e_nullTree);
+		++removeCounts[m_proxies[proxyIds[i]].tree];
+	}
+
+	int32 start = 0;
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		removeStarts[i] = start;
+		start += removeCounts[i];
+	}
+
+	int32* treeProxyIds = (int32*)b2Alloc(count * sizeof(int32));
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2BroadPhaseProxy* proxy = m_proxies + proxyIds[i];
+		treeProxyIds[removeStarts[proxy->tree]++] = proxy->treeProxyId;
+		FreeProxy(proxyIds[i]);
+	}
+
+	start = 0;
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		int32 removeCount = removeCounts[i];
+		if (b2_bulkRebuildFactor * removeCount < m_treeProxyCounts[i])
+		{
+			for (int32 j = 0; j < removeCount; ++j)
+			{
+				m_trees[i].DestroyProxy(treeProxyIds[start + j]);
+			}
+		}
+		else
+		{
+			m_trees[i].DestroyProxies(treeProxyIds + start, removeCount);
+		}
+
+		m_treeProxyCounts[i] -= removeCount;
+		start += removeCount;
+	}
+
+	b2Free(treeProxyIds);
+
+	// Drop the moves of the freed proxies in one pass instead of searching
+	// the move buffer for each.
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 proxyId = m_moveBuffer[i];
+		if (proxyId != e_nullProxy && m_proxies[proxyId].tree == e_nullTree)
+		{
+			m_moveBuffer[i] = e_nullProxy;
+		}
+	}
 }
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2BroadPhaseProxy* proxy = m_proxies + proxyId;
+
+	bool buffer = m_trees[proxy->tree].MoveProxy(proxy->treeProxyId, aabb, displacement);
 	if (buffer)
 	{
+		if (proxy->tree == e_staticTree)
+		{
+			++m_staticChangeCount;
+		}
+
 		BufferMove(proxyId);
 	}
 }
@@ -68,6 +282,122 @@ void b2BroadPhase::TouchProxy(int32 proxyId)
 	BufferMove(proxyId);
 }
 
+void b2BroadPhase::SetProxyTree(int32 proxyId, int32 tree, const b2AABB& aabb)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(0 <= tree && tree < e_treeCount);
+	b2BroadPhaseProxy* proxy = m_proxies + proxyId;
+	if (proxy->tree == tree)
+	{
+		return;
+	}
+
+	m_trees[proxy->tree].DestroyProxy(proxy->treeProxyId);
+	--m_treeProxyCounts[proxy->tree];
+
+	proxy->treeProxyId = m_trees[tree].CreateProxy(aabb, (void*)size_t(proxyId));
+	proxy->tree = tree;
+	++m_treeProxyCounts[tree];
+
+	if (tree == e_staticTree)
+	{
+		++m_staticChangeCount;
+	}
+}
+
+// The static tree is only modified by static proxies, which are rarely created
+// or moved. Rebuilding gives a better tree than inserting them one at a time.
+void b2BroadPhase::UpdateStaticTree()
+{
+	b2DynamicTree* tree = m_trees + e_staticTree;
+
+	if (m_staticChangeCount > 0 && b2_staticRebuildFactor * m_staticChangeCount >= m_treeProxyCounts[e_staticTree])
+	{
+		tree->Rebuild();
+		m_staticChangeCount = 0;
+	}
+
+	if (tree->HasWideNodes() == false && m_treeProxyCounts[e_staticTree] > 0)
+	{
+		tree->BuildWideNodes();
+	}
+}
+
+void b2BroadPhase::RebuildTree()
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].Rebuild();
+		m_trees[i].BuildWideNodes();
+	}
+	m_staticChangeCount = 0;
+}
+
+void b2BroadPhase::Save(b2Snapshot* snapshot) const
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].Save(snapshot);
+		snapshot->Write(m_treeProxyCounts[i]);
+	}
+	snapshot->Write(m_staticChangeCount);
+
+	snapshot->Write(m_proxyCapacity);
+	snapshot->Write(m_freeProxy);
+	snapshot->Write(m_proxies, m_proxyCapacity * sizeof(b2BroadPhaseProxy));
+
+	snapshot->Write(m_proxyCount);
+	snapshot->Write(m_moveCount);
+	snapshot->Write(m_moveBuffer, m_moveCount * sizeof(int32));
+}
+
+void b2BroadPhase::Load(b2SnapshotReader* reader)
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].Load(reader);
+		reader->Read(&m_treeProxyCounts[i]);
+	}
+	reader->Read(&m_staticChangeCount);
+
+	// The capacity decides when the pool grows, so it must match.
+	int32 proxyCapacity;
+	reader->Read(&proxyCapacity);
+	reader->Read(&m_freeProxy);
+	if (proxyCapacity != m_proxyCapacity)
+	{
+		b2Free(m_proxies);
+		m_proxyCapacity = proxyCapacity;
+		m_proxies = (b2BroadPhaseProxy*)b2Alloc(m_proxyCapacity * sizeof(b2BroadPhaseProxy));
+	}
+	reader->Read(m_proxies, m_proxyCapacity * sizeof(b2BroadPhaseProxy));
+
+	// Point the tree leaves back at the proxies. The client sets the user data.
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		b2BroadPhaseProxy* proxy = m_proxies + i;
+		proxy->userData = NULL;
+		if (proxy->tree != e_nullTree)
+		{
+			m_trees[proxy->tree].SetUserData(proxy->treeProxyId, (void*)size_t(i));
+		}
+	}
+
+	reader->Read(&m_proxyCount);
+	reader->Read(&m_moveCount);
+
+	if (m_moveCount > m_moveCapacity)
+	{
+		b2Free(m_moveBuffer);
+		m_moveCapacity = m_moveCount;
+		m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+	}
+
+	reader->Read(m_moveBuffer, m_moveCount * sizeof(int32));
+	m_moveSet.Clear();
+	m_pairCount = 0;
+}
+
 void b2BroadPhase::BufferMove(int32 proxyId)
 {
 	if (m_moveCount == m_moveCapacity)
@@ -96,14 +426,22 @@ void b2BroadPhase::UnBufferMove(int32 proxyId)
 }
 
 // This is called from b2DynamicTree::Query when we are gathering pairs.
-bool b2BroadPhase::QueryCallback(int32 proxyId)
+bool b2BroadPhase::QueryCallback(int32 treeProxyId)
 {
+	int32 proxyId = GetTreeLeafProxyId(m_trees[m_queryTree].GetUserData(treeProxyId));
+
 	// A proxy cannot form a pair with itself.
 	if (proxyId == m_queryProxyId)
 	{
 		return true;
 	}
 
+	// Both proxies are moving. The query of the smaller proxy reports the pair.
+	if (proxyId < m_queryProxyId && m_moveSet.Contains(uint64(proxyId) + 1))
+	{
+		return true;
+	}
+
 	// Grow the pair buffer as needed.
 	if (m_pairCount == m_pairCapacity)
 	{
@@ -22,8 +22,23 @@
 #include <Box2D/Common/b2Settings.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2HashSet.h>
 #include <algorithm>
 
+/// UpdatePairs builds the wide tree nodes when the number of moved proxies
+/// times this factor reaches the proxy count.
+const int32 b2_wideQueryFactor = 8;
+
+/// UpdatePairs rebuilds the static tree when the number of static proxies
+/// created or moved since the last rebuild times this factor reaches the
+/// static proxy count.
+const int32 b2_staticRebuildFactor = 4;
+
+/// CreateProxies and DestroyProxies rebuild a tree in one pass when the number of
+/// proxies they add or remove times this factor reaches the proxy count of the
+/// tree. Otherwise the proxies are inserted or removed one at a time.
+const int32 b2_bulkRebuildFactor = 2;
+
 struct b2Pair
 {
 	int32 proxyIdA;
@@ -31,9 +46,30 @@ struct b2Pair
 	int32 next;
 };
 
+/// A broad-phase proxy. The proxy is a leaf of one of the trees.
+struct b2BroadPhaseProxy
+{
+	void* userData;
+
+	union
+	{
+		int32 treeProxyId;
+		int32 next;
+	};
+
+	// The tree holding the proxy, e_nullTree for a free proxy.
+	int32 tree;
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
+///
+/// The proxies are split into three trees. Static proxies never pair with each other.
+/// Their tree is rebuilt in one pass once enough of it has changed and is read-only
+/// otherwise. Sleeping proxies rarely move, so their tree keeps its wide nodes. The
+/// awake tree holds everything else. Proxy ids do not change when a proxy moves to
+/// another tree.
 class b2BroadPhase
 {
 public:
@@ -43,16 +79,35 @@ public:
 		e_nullProxy = -1
 	};
 
+	enum
+	{
+		e_nullTree = -1,
+		e_staticTree,
+		e_sleepingTree,
+		e_awakeTree,
+		e_treeCount
+	};
+
 	b2BroadPhase();
 	~b2BroadPhase();
 
-	/// Create a proxy with an initial AABB. Pairs are not reported until
-	/// UpdatePairs is called.
-	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	/// Destroy all proxies at once. No pairs are reported for them.
+	void Reset();
+
+	/// Create a proxy with an initial AABB in the given tree. Pairs are not
+	/// reported until UpdatePairs is called.
+	int32 CreateProxy(const b2AABB& aabb, void* userData, int32 tree);
 
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
+	/// Create many proxies in the given tree, like calling CreateProxy for each.
+	/// The ids are written to proxyIds.
+	void CreateProxies(int32* proxyIds, const b2AABB* aabbs, void* const* userData, int32 count, int32 tree);
+
+	/// Destroy many proxies, like calling DestroyProxy for each.
+	void DestroyProxies(const int32* proxyIds, int32 count);
+
 	/// Call MoveProxy as many times as you like, then when you are done
 	/// call UpdatePairs to finalized the proxy pairs (for your time step).
 	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
@@ -60,18 +115,34 @@ public:
 	/// Call to trigger a re-processing of it's pairs on the next call to UpdatePairs.
 	void TouchProxy(int32 proxyId);
 
+	/// Move a proxy into another tree. The fat AABB is computed again from aabb.
+	/// This does not report pairs.
+	void SetProxyTree(int32 proxyId, int32 tree, const b2AABB& aabb);
+
+	/// Get the tree holding a proxy.
+	int32 GetProxyTree(int32 proxyId) const;
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
 	/// Get user data from a proxy. Returns NULL if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Set the user data of a proxy.
+	void SetUserData(int32 proxyId, void* userData);
+
 	/// Test overlap of fat AABBs.
 	bool TestOverlap(int32 proxyIdA, int32 proxyIdB) const;
 
 	/// Get the number of proxies.
 	int32 GetProxyCount() const;
 
+	/// Get the number of proxies in one tree.
+	int32 GetProxyCount(int32 tree) const;
+
+	/// Get the number of proxies that moved since the last UpdatePairs.
+	int32 GetMoveCount() const;
+
 	/// Update the pairs. This results in pair callbacks. This can only add pairs.
 	template <typename T>
 	void UpdatePairs(T* callback);
@@ -91,25 +162,50 @@ public:
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Get the height of the embedded tree.
+	/// Get the height of the tallest embedded tree.
 	int32 GetTreeHeight() const;
 
-	/// Get the balance of the embedded tree.
+	/// Get the largest balance of the embedded trees.
 	int32 GetTreeBalance() const;
 
-	/// Get the quality metric of the embedded tree.
+	/// Get the worst quality metric of the embedded trees.
 	float32 GetTreeQuality() const;
 
+	/// Rebuild the embedded trees in one pass. See b2DynamicTree::Rebuild.
+	void RebuildTree();
+
+	/// Write the trees and the buffered moves to a snapshot.
+	void Save(b2Snapshot* snapshot) const;
+
+	/// Replace the proxies with ones written by Save. See b2DynamicTree::Load.
+	void Load(b2SnapshotReader* reader);
+
+	/// The trees store the proxy id as the user data of their leaves.
+	static int32 GetTreeLeafProxyId(const void* treeUserData);
+
 private:
 
 	friend class b2DynamicTree;
 
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
-	bool QueryCallback(int32 proxyId);
+	void UpdateStaticTree();
 
-	b2DynamicTree m_tree;
+	bool QueryCallback(int32 treeProxyId);
+
+	b2DynamicTree m_trees[e_treeCount];
+	int32 m_treeProxyCounts[e_treeCount];
+
+	// Static proxies created or moved since the static tree was last rebuilt.
+	int32 m_staticChangeCount;
+
+	b2BroadPhaseProxy* m_proxies;
+	int32 m_proxyCapacity;
+	int32 m_freeProxy;
 
 	int32 m_proxyCount;
 
@@ -117,11 +213,48 @@ private:
 	int32 m_moveCapacity;
 	int32 m_moveCount;
 
+	// The proxies in the move buffer, filled by UpdatePairs.
+	b2HashSet m_moveSet;
+
 	b2Pair* m_pairBuffer;
 	int32 m_pairCapacity;
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+	int32 m_queryTree;
+};
+
+/// Passes the tree callbacks of b2BroadPhase::Query and b2BroadPhase::RayCast on
+/// with proxy ids. The ray clip fraction carries over from one tree to the next.
+template <typename T>
+struct b2BroadPhaseCallback
+{
+	bool QueryCallback(int32 treeProxyId)
+	{
+		int32 proxyId = b2BroadPhase::GetTreeLeafProxyId(tree->GetUserData(treeProxyId));
+		proceed = callback->QueryCallback(proxyId);
+		return proceed;
+	}
+
+	float32 RayCastCallback(const b2RayCastInput& input, int32 treeProxyId)
+	{
+		int32 proxyId = b2BroadPhase::GetTreeLeafProxyId(tree->GetUserData(treeProxyId));
+		float32 value = callback->RayCastCallback(input, proxyId);
+		if (value == 0.0f)
+		{
+			proceed = false;
+		}
+		else if (value > 0.0f)
+		{
+			maxFraction = value;
+		}
+		return value;
+	}
+
+	const b2DynamicTree* tree;
+	T* callback;
+	float32 maxFraction;
+	bool proceed;
 };
 
 /// This is used to sort pairs.
@@ -140,21 +273,54 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
+/// Get a key for a pair of proxies that does not depend on their order.
+inline uint64 b2PairKey(int32 proxyIdA, int32 proxyIdB)
+{
+	uint64 a = uint64(b2Min(proxyIdA, proxyIdB));
+	uint64 b = uint64(b2Max(proxyIdA, proxyIdB));
+	return (a << 32) | b;
+}
+
+inline int32 b2BroadPhase::GetTreeLeafProxyId(const void* treeUserData)
+{
+	return int32(size_t(treeUserData));
+}
+
 inline void* b2BroadPhase::GetUserData(int32 proxyId) const
 {
-	return m_tree.GetUserData(proxyId);
+	if (proxyId < 0 || proxyId >= m_proxyCapacity)
+	{
+		return NULL;
+	}
+
+	return m_proxies[proxyId].userData;
+}
+
+inline void b2BroadPhase::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert(m_proxies[proxyId].tree != e_nullTree);
+	m_proxies[proxyId].userData = userData;
 }
 
 inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
 {
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
 	return b2TestOverlap(aabbA, aabbB);
 }
 
 inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
 {
-	return m_tree.GetFatAABB(proxyId);
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	const b2BroadPhaseProxy* proxy = m_proxies + proxyId;
+	return m_trees[proxy->tree].GetFatAABB(proxy->treeProxyId);
+}
+
+inline int32 b2BroadPhase::GetProxyTree(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].tree;
 }
 
 inline int32 b2BroadPhase::GetProxyCount() const
@@ -162,19 +328,45 @@ inline int32 b2BroadPhase::GetProxyCount() const
 	return m_proxyCount;
 }
 
+inline int32 b2BroadPhase::GetProxyCount(int32 tree) const
+{
+	b2Assert(0 <= tree && tree < e_treeCount);
+	return m_treeProxyCounts[tree];
+}
+
+inline int32 b2BroadPhase::GetMoveCount() const
+{
+	return m_moveCount;
+}
+
 inline int32 b2BroadPhase::GetTreeHeight() const
 {
-	return m_tree.GetHeight();
+	int32 height = 0;
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		height = b2Max(height, m_trees[i].GetHeight());
+	}
+	return height;
 }
 
 inline int32 b2BroadPhase::GetTreeBalance() const
 {
-	return m_tree.GetMaxBalance();
+	int32 balance = 0;
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		balance = b2Max(balance, m_trees[i].GetMaxBalance());
+	}
+	return balance;
 }
 
 inline float32 b2BroadPhase::GetTreeQuality() const
 {
-	return m_tree.GetAreaRatio();
+	float32 quality = 0.0f;
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		quality = b2Max(quality, m_trees[i].GetAreaRatio());
+	}
+	return quality;
 }
 
 template <typename T>
@@ -183,6 +375,30 @@ void b2BroadPhase::UpdatePairs(T* callback)
 	// Reset pair buffer
 	m_pairCount = 0;
 
+	UpdateStaticTree();
+
+	// The wide nodes cost a pass over the tree, so only build them
+	// when there are enough queries to pay for it.
+	for (int32 i = e_sleepingTree; i < e_treeCount; ++i)
+	{
+		b2DynamicTree* tree = m_trees + i;
+		if (tree->HasWideNodes() == false && b2_wideQueryFactor * m_moveCount >= m_treeProxyCounts[i])
+		{
+			tree->BuildWideNodes();
+		}
+	}
+
+	// A pair of moving proxies is reported by the query of the smaller proxy.
+	// This needs the set of moving proxies. A proxy may be buffered twice.
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 proxyId = m_moveBuffer[i];
+		if (proxyId != e_nullProxy && m_moveSet.Add(uint64(proxyId) + 1) == false)
+		{
+			m_moveBuffer[i] = e_nullProxy;
+		}
+	}
+
 	// Perform tree queries for all moving proxies.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
@@ -194,39 +410,34 @@ void b2BroadPhase::UpdatePairs(T* callback)
 
 		// We have to query the tree with the fat AABB so that
 		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
+		const b2AABB& fatAABB = GetFatAABB(m_queryProxyId);
+		bool isStatic = m_proxies[m_queryProxyId].tree == e_staticTree;
 
-		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
+		// Query the trees, create pairs and add them pair buffer.
+		for (m_queryTree = 0; m_queryTree < e_treeCount; ++m_queryTree)
+		{
+			if (m_treeProxyCounts[m_queryTree] == 0 || (isStatic && m_queryTree == e_staticTree))
+			{
+				continue;
+			}
+
+			m_trees[m_queryTree].Query(this, fatAABB);
+		}
 	}
 
 	// Reset move buffer
 	m_moveCount = 0;
+	m_moveSet.Clear();
 
-	// Sort the pair buffer to expose duplicates.
-	std::sort(m_pairBuffer, m_pairBuffer + m_pairCount, b2PairLessThan);
-
-	// Send the pairs back to the client.
-	int32 i = 0;
-	while (i < m_pairCount)
+	// Send the pairs back to the client. The pairs are unique, so they don't
+	// need sorting. The client checks for existing pairs.
+	for (int32 i = 0; i < m_pairCount; ++i)
 	{
-		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
+		b2Pair* pair = m_pairBuffer + i;
+		void* userDataA = m_proxies[pair->proxyIdA].userData;
+		void* userDataB = m_proxies[pair->proxyIdB].userData;
 
 		callback->AddPair(userDataA, userDataB);
-		++i;
-
-		// Skip any duplicate pairs.
-		while (i < m_pairCount)
-		{
-			b2Pair* pair = m_pairBuffer + i;
-			if (pair->proxyIdA != primaryPair->proxyIdA || pair->proxyIdB != primaryPair->proxyIdB)
-			{
-				break;
-			}
-			++i;
-		}
 	}
 
 	// Try to keep the tree balanced.
@@ -236,13 +447,39 @@ void b2BroadPhase::UpdatePairs(T* callback)
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2BroadPhaseCallback<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.proceed = true;
+
+	for (int32 i = 0; i < e_treeCount && wrapper.proceed; ++i)
+	{
+		if (m_treeProxyCounts[i] > 0)
+		{
+			wrapper.tree = m_trees + i;
+			m_trees[i].Query(&wrapper, aabb);
+		}
+	}
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2BroadPhaseCallback<T> wrapper;
+	wrapper.callback = callback;
+	wrapper.maxFraction = input.maxFraction;
+	wrapper.proceed = true;
+
+	b2RayCastInput treeInput = input;
+
+	for (int32 i = 0; i < e_treeCount && wrapper.proceed; ++i)
+	{
+		if (m_treeProxyCounts[i] > 0)
+		{
+			wrapper.tree = m_trees + i;
+			treeInput.maxFraction = wrapper.maxFraction;
+			m_trees[i].RayCast(&wrapper, treeInput);
+		}
+	}
 }
 
 #endif
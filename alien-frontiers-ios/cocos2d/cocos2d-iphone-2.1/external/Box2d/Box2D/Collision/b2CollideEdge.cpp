@@ -19,28 +19,79 @@
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 
+// The segment vertex1-vertex2 with optional neighbors vertex0 and vertex3. Edges
+// and chains both collide through this so chains need not build child edges.
+struct b2EdgeSegment
+{
+	// The neighbors are NULL when there is no adjacent edge.
+	void Set(const b2EdgeShape* edge)
+	{
+		vertex0 = edge->m_hasVertex0 ? &edge->m_vertex0 : NULL;
+		vertex1 = &edge->m_vertex1;
+		vertex2 = &edge->m_vertex2;
+		vertex3 = edge->m_hasVertex3 ? &edge->m_vertex3 : NULL;
+		radius = edge->m_radius;
+	}
+
+	// Reads the vertices of the child edge from the chain's vertex buffer.
+	void Set(const b2ChainShape* chain, int32 index)
+	{
+		b2Assert(0 <= index && index < chain->m_count - 1);
+		const b2Vec2* vertices = chain->m_vertices + index;
+
+		if (index > 0)
+		{
+			vertex0 = vertices - 1;
+		}
+		else
+		{
+			vertex0 = chain->m_hasPrevVertex ? &chain->m_prevVertex : NULL;
+		}
+
+		vertex1 = vertices;
+		vertex2 = vertices + 1;
+
+		if (index < chain->m_count - 2)
+		{
+			vertex3 = vertices + 2;
+		}
+		else
+		{
+			vertex3 = chain->m_hasNextVertex ? &chain->m_nextVertex : NULL;
+		}
+
+		radius = chain->m_radius;
+	}
+
+	const b2Vec2* vertex0;
+	const b2Vec2* vertex1;
+	const b2Vec2* vertex2;
+	const b2Vec2* vertex3;
+	float32 radius;
+};
 
 // Compute contact points for edge versus circle.
 // This accounts for edge connectivity.
-void b2CollideEdgeAndCircle(b2Manifold* manifold,
-							const b2EdgeShape* edgeA, const b2Transform& xfA,
-							const b2CircleShape* circleB, const b2Transform& xfB)
+static void b2CollideSegmentAndCircle(b2Manifold* manifold,
+									  const b2EdgeSegment& edgeA, const b2Transform& xfA,
+									  const b2CircleShape* circleB, const b2Transform& xfB)
 {
 	manifold->pointCount = 0;
 
 	// Compute circle in frame of edge
 	b2Vec2 Q = b2MulT(xfA, b2Mul(xfB, circleB->m_p));
 
-	b2Vec2 A = edgeA->m_vertex1, B = edgeA->m_vertex2;
+	b2Vec2 A = *edgeA.vertex1, B = *edgeA.vertex2;
 	b2Vec2 e = B - A;
 
 	// Barycentric coordinates
 	float32 u = b2Dot(e, B - Q);
 	float32 v = b2Dot(e, Q - A);
 
-	float32 radius = edgeA->m_radius + circleB->m_radius;
+	float32 radius = edgeA.radius + circleB->m_radius;
 
 	b2ContactFeature cf;
 	cf.indexB = 0;
@@ -58,9 +109,9 @@ void b2CollideEdgeAndCircle(b2Manifold* manifold,
 		}
 
 		// Is there an edge connected to A?
-		if (edgeA->m_hasVertex0)
+		if (edgeA.vertex0)
 		{
-			b2Vec2 A1 = edgeA->m_vertex0;
+			b2Vec2 A1 = *edgeA.vertex0;
 			b2Vec2 B1 = A;
 			b2Vec2 e1 = B1 - A1;
 			float32 u1 = b2Dot(e1, B1 - Q);
@@ -96,9 +147,9 @@ void b2CollideEdgeAndCircle(b2Manifold* manifold,
 		}
 
 		// Is there an edge connected to B?
-		if (edgeA->m_hasVertex3)
+		if (edgeA.vertex3)
 		{
-			b2Vec2 B2 = edgeA->m_vertex3;
+			b2Vec2 B2 = *edgeA.vertex3;
 			b2Vec2 A2 = B;
 			b2Vec2 e2 = B2 - A2;
 			float32 v2 = b2Dot(e2, Q - A2);
@@ -151,6 +202,24 @@ void b2CollideEdgeAndCircle(b2Manifold* manifold,
 	manifold->points[0].localPoint = circleB->m_p;
 }
 
+void b2CollideEdgeAndCircle(b2Manifold* manifold,
+							const b2EdgeShape* edgeA, const b2Transform& xfA,
+							const b2CircleShape* circleB, const b2Transform& xfB)
+{
+	b2EdgeSegment segment;
+	segment.Set(edgeA);
+	b2CollideSegmentAndCircle(manifold, segment, xfA, circleB, xfB);
+}
+
+void b2CollideChainAndCircle(b2Manifold* manifold,
+							 const b2ChainShape* chainA, int32 childIndex, const b2Transform& xfA,
+							 const b2CircleShape* circleB, const b2Transform& xfB)
+{
+	b2EdgeSegment segment;
+	segment.Set(chainA, childIndex);
+	b2CollideSegmentAndCircle(manifold, segment, xfA, circleB, xfB);
+}
+
 // This structure is used to keep track of the best separating axis.
 struct b2EPAxis
 {
@@ -193,7 +262,7 @@ struct b2ReferenceFace
 // This class collides and edge and a polygon, taking into account edge adjacency.
 struct b2EPCollider
 {
-	void Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
+	void Collide(b2Manifold* manifold, const b2EdgeSegment& edgeA, const b2Transform& xfA,
 				 const b2PolygonShape* polygonB, const b2Transform& xfB);
 	b2EPAxis ComputeEdgeSeparation();
 	b2EPAxis ComputePolygonSeparation();
@@ -227,20 +296,20 @@ struct b2EPCollider
 // 6. Visit each separating axes, only accept axes within the range
 // 7. Return if _any_ axis indicates separation
 // 8. Clip
-void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeShape* edgeA, const b2Transform& xfA,
+void b2EPCollider::Collide(b2Manifold* manifold, const b2EdgeSegment& edgeA, const b2Transform& xfA,
 						   const b2PolygonShape* polygonB, const b2Transform& xfB)
 {
 	m_xf = b2MulT(xfA, xfB);
 
 	m_centroidB = b2Mul(m_xf, polygonB->m_centroid);
 
-	m_v0 = edgeA->m_vertex0;
-	m_v1 = edgeA->m_vertex1;
-	m_v2 = edgeA->m_vertex2;
-	m_v3 = edgeA->m_vertex3;
+	bool hasVertex0 = edgeA.vertex0 != NULL;
+	bool hasVertex3 = edgeA.vertex3 != NULL;
 
-	bool hasVertex0 = edgeA->m_hasVertex0;
-	bool hasVertex3 = edgeA->m_hasVertex3;
+	m_v0 = hasVertex0 ? *edgeA.vertex0 : b2Vec2_zero;
+	m_v1 = *edgeA.vertex1;
+	m_v2 = *edgeA.vertex2;
+	m_v3 = hasVertex3 ? *edgeA.vertex3 : b2Vec2_zero;
 
 	b2Vec2 edge1 = m_v2 - m_v1;
 	edge1.Normalize();
@@ -693,6 +762,18 @@ void b2CollideEdgeAndPolygon(	b2Manifold* manifold,
 							 const b2EdgeShape* edgeA, const b2Transform& xfA,
 							 const b2PolygonShape* polygonB, const b2Transform& xfB)
 {
+	b2EdgeSegment segment;
+	segment.Set(edgeA);
+	b2EPCollider collider;
+	collider.Collide(manifold, segment, xfA, polygonB, xfB);
+}
+
+void b2CollideChainAndPolygon(b2Manifold* manifold,
+							  const b2ChainShape* chainA, int32 childIndex, const b2Transform& xfA,
+							  const b2PolygonShape* polygonB, const b2Transform& xfB)
+{
+	b2EdgeSegment segment;
+	segment.Set(chainA, childIndex);
 	b2EPCollider collider;
-	collider.Collide(manifold, edgeA, xfA, polygonB, xfB);
+	collider.Collide(manifold, segment, xfA, polygonB, xfB);
 }
@@ -28,6 +28,7 @@
 
 class b2Shape;
 class b2CircleShape;
+class b2ChainShape;
 class b2EdgeShape;
 class b2PolygonShape;
 
@@ -239,6 +240,18 @@ void b2CollideEdgeAndPolygon(b2Manifold* manifold,
 							   const b2EdgeShape* edgeA, const b2Transform& xfA,
 							   const b2PolygonShape* circleB, const b2Transform& xfB);
 
+/// Compute the collision manifold between a chain child edge and a circle.
+/// This reads the chain vertices directly instead of building the child edge.
+void b2CollideChainAndCircle(b2Manifold* manifold,
+							 const b2ChainShape* chainA, int32 childIndex, const b2Transform& xfA,
+							 const b2CircleShape* circleB, const b2Transform& xfB);
+
+/// Compute the collision manifold between a chain child edge and a polygon.
+/// This reads the chain vertices directly instead of building the child edge.
+void b2CollideChainAndPolygon(b2Manifold* manifold,
+							  const b2ChainShape* chainA, int32 childIndex, const b2Transform& xfA,
+							  const b2PolygonShape* polygonB, const b2Transform& xfB);
+
 /// Clipping for contact manifolds.
 int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 							const b2Vec2& normal, float32 offset, int32 vertexIndexA);
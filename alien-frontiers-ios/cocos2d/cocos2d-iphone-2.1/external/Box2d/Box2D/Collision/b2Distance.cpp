@@ -444,7 +444,24 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
+	b2DistanceCounters counters;
+	counters.calls = 0;
+	counters.iters = 0;
+	counters.maxIters = 0;
+
+	b2Distance(output, cache, input, &counters);
+
+	b2_gjkCalls += counters.calls;
+	b2_gjkIters += counters.iters;
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, counters.maxIters);
+}
+
+void b2Distance(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input,
+				b2DistanceCounters* counters)
+{
+	++counters->calls;
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -541,7 +558,7 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
+		++counters->iters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -564,7 +581,7 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	counters->maxIters = b2Max(counters->maxIters, iter);
 
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
@@ -90,6 +90,22 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input);
 
+/// Iteration counts of b2Distance, for profiling.
+struct b2DistanceCounters
+{
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+};
+
+/// Same as above, but adds to the given counters instead of the global
+/// b2_gjkCalls, b2_gjkIters and b2_gjkMaxIters. Threads that call this at
+/// the same time must use their own counters.
+void b2Distance(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input,
+				b2DistanceCounters* counters);
+
 
 //////////////////////////////////////////////////////////////////////////
 
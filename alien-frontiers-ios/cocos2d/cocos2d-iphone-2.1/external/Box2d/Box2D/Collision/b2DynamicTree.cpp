@@ -17,8 +17,10 @@
 */
 
 #include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <cstring>
 #include <cfloat>
+#include <algorithm>
 using namespace std;
 
 
@@ -44,12 +46,41 @@ b2DynamicTree::b2DynamicTree()
 	m_path = 0;
 
 	m_insertionCount = 0;
+
+	m_wideNodes = NULL;
+	m_wideNodeCount = 0;
+	m_wideNodeCapacity = 0;
+	m_wideRoot = b2_nullNode;
 }
 
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
 	b2Free(m_nodes);
+	b2Free(m_wideNodes);
+}
+
+void b2DynamicTree::Reset()
+{
+	m_root = b2_nullNode;
+	m_nodeCount = 0;
+
+	// Rebuild the free list over the whole pool.
+	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_freeList = 0;
+
+	m_path = 0;
+
+	m_insertionCount = 0;
+
+	m_wideNodeCount = 0;
+	m_wideRoot = b2_nullNode;
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -130,6 +161,44 @@ void b2DynamicTree::DestroyProxy(int32 proxyId)
 	FreeNode(proxyId);
 }
 
+void b2DynamicTree::CreateProxies(int32* proxyIds, const b2AABB* aabbs, void* const* userData, int32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		proxyIds[i] = proxyId;
+	}
+
+	Rebuild();
+}
+
+void b2DynamicTree::DestroyProxies(const int32* proxyIds, int32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = proxyIds[i];
+		b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+		b2Assert(m_nodes[proxyId].IsLeaf());
+		FreeNode(proxyId);
+	}
+
+	Rebuild();
+}
+
 bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -179,6 +248,7 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 void b2DynamicTree::InsertLeaf(int32 leaf)
 {
 	++m_insertionCount;
+	m_wideRoot = b2_nullNode;
 
 	if (m_root == b2_nullNode)
 	{
@@ -318,6 +388,8 @@ void b2DynamicTree::InsertLeaf(int32 leaf)
 
 void b2DynamicTree::RemoveLeaf(int32 leaf)
 {
+	m_wideRoot = b2_nullNode;
+
 	if (leaf == m_root)
 	{
 		m_root = b2_nullNode;
@@ -696,6 +768,8 @@ int32 b2DynamicTree::GetMaxBalance() const
 
 void b2DynamicTree::RebuildBottomUp()
 {
+	m_wideRoot = b2_nullNode;
+
 	int32* nodes = (int32*)b2Alloc(m_nodeCount * sizeof(int32));
 	int32 count = 0;
 
@@ -769,3 +843,272 @@ void b2DynamicTree::RebuildBottomUp()
 
 	Validate();
 }
+
+struct b2MortonLeaf
+{
+	uint32 code;
+	int32 index;
+};
+
+inline bool b2MortonLessThan(const b2MortonLeaf& leaf1, const b2MortonLeaf& leaf2)
+{
+	return leaf1.code < leaf2.code;
+}
+
+// Spread the lower 16 bits so that there is a zero bit between each.
+inline uint32 b2SpreadBits(uint32 x)
+{
+	x &= 0x0000ffff;
+	x = (x | (x << 8)) & 0x00ff00ff;
+	x = (x | (x << 4)) & 0x0f0f0f0f;
+	x = (x | (x << 2)) & 0x33333333;
+	x = (x | (x << 1)) & 0x55555555;
+	return x;
+}
+
+void b2DynamicTree::Rebuild()
+{
+	m_wideRoot = b2_nullNode;
+
+	// Free the internal nodes and find the bounds of the leaves.
+	b2AABB bounds;
+	bounds.lowerBound.Set(b2_maxFloat, b2_maxFloat);
+	bounds.upperBound.Set(-b2_maxFloat, -b2_maxFloat);
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			bounds.Combine(m_nodes[i].aabb);
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	if (m_nodeCount == 0)
+	{
+		m_root = b2_nullNode;
+		return;
+	}
+
+	b2Vec2 extents = bounds.upperBound - bounds.lowerBound;
+	b2Vec2 scale;
+	scale.x = extents.x > 0.0f ? 65535.0f / extents.x : 0.0f;
+	scale.y = extents.y > 0.0f ? 65535.0f / extents.y : 0.0f;
+
+	b2MortonLeaf* leaves = (b2MortonLeaf*)b2Alloc(m_nodeCount * sizeof(b2MortonLeaf));
+	int32 count = 0;
+
+	// Build array of leaves.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		b2Vec2 c = m_nodes[i].aabb.GetCenter() - bounds.lowerBound;
+		uint32 x = uint32(b2Clamp(scale.x * c.x, 0.0f, 65535.0f));
+		uint32 y = uint32(b2Clamp(scale.y * c.y, 0.0f, 65535.0f));
+
+		m_nodes[i].parent = b2_nullNode;
+		leaves[count].code = b2SpreadBits(x) | (b2SpreadBits(y) << 1);
+		leaves[count].index = i;
+		++count;
+	}
+
+	std::sort(leaves, leaves + count, b2MortonLessThan);
+
+	int32* nodes = (int32*)b2Alloc(count * sizeof(int32));
+	for (int32 i = 0; i < count; ++i)
+	{
+		nodes[i] = leaves[i].index;
+	}
+
+	b2Free(leaves);
+
+	// Pair neighbors along the curve, one level at a time. An odd node
+	// out moves up to the next level.
+	while (count > 1)
+	{
+		int32 parentCount = 0;
+		for (int32 i = 0; i + 1 < count; i += 2)
+		{
+			int32 index1 = nodes[i];
+			int32 index2 = nodes[i + 1];
+
+			int32 parentIndex = AllocateNode();
+			b2TreeNode* child1 = m_nodes + index1;
+			b2TreeNode* child2 = m_nodes + index2;
+			b2TreeNode* parent = m_nodes + parentIndex;
+			parent->child1 = index1;
+			parent->child2 = index2;
+			parent->height = 1 + b2Max(child1->height, child2->height);
+			parent->aabb.Combine(child1->aabb, child2->aabb);
+			parent->parent = b2_nullNode;
+
+			child1->parent = parentIndex;
+			child2->parent = parentIndex;
+
+			nodes[parentCount++] = parentIndex;
+		}
+
+		if (count & 1)
+		{
+			nodes[parentCount++] = nodes[count - 1];
+		}
+
+		count = parentCount;
+	}
+
+	m_root = nodes[0];
+	b2Free(nodes);
+
+	Validate();
+}
+
+void b2DynamicTree::BuildWideNodes()
+{
+	if (m_root == b2_nullNode)
+	{
+		m_wideRoot = b2_nullNode;
+		return;
+	}
+
+	// Every wide node other than the root consumes at least one internal node.
+	if (m_wideNodeCapacity < m_nodeCount)
+	{
+		b2Free(m_wideNodes);
+		m_wideNodeCapacity = m_nodeCapacity;
+		m_wideNodes = (b2WideTreeNode*)b2Alloc(m_wideNodeCapacity * sizeof(b2WideTreeNode));
+	}
+
+	m_wideNodeCount = 0;
+	m_wideRoot = BuildWideNode(m_root);
+}
+
+// Collapse the sub-tree at nodeId into a wide node. The largest internal
+// child is opened until there are four children.
+int32 b2DynamicTree::BuildWideNode(int32 nodeId)
+{
+	int32 children[4];
+	int32 count = 0;
+
+	const b2TreeNode* node = m_nodes + nodeId;
+	if (node->IsLeaf())
+	{
+		children[count++] = nodeId;
+	}
+	else
+	{
+		children[count++] = node->child1;
+		children[count++] = node->child2;
+	}
+
+	while (count < 4)
+	{
+		int32 bestIndex = -1;
+		float32 bestPerimeter = -1.0f;
+		for (int32 i = 0; i < count; ++i)
+		{
+			const b2TreeNode* child = m_nodes + children[i];
+			if (child->IsLeaf() == false && child->aabb.GetPerimeter() > bestPerimeter)
+			{
+				bestIndex = i;
+				bestPerimeter = child->aabb.GetPerimeter();
+			}
+		}
+
+		if (bestIndex == -1)
+		{
+			break;
+		}
+
+		const b2TreeNode* child = m_nodes + children[bestIndex];
+		children[bestIndex] = child->child1;
+		children[count++] = child->child2;
+	}
+
+	b2Assert(m_wideNodeCount < m_wideNodeCapacity);
+	int32 wideIndex = m_wideNodeCount++;
+	b2WideTreeNode* wideNode = m_wideNodes + wideIndex;
+	wideNode->childCount = count;
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (i >= count)
+		{
+			// Empty bounds never overlap.
+			wideNode->lowerX[i] = b2_maxFloat;
+			wideNode->lowerY[i] = b2_maxFloat;
+			wideNode->upperX[i] = -b2_maxFloat;
+			wideNode->upperY[i] = -b2_maxFloat;
+			wideNode->children[i] = b2_nullNode;
+			continue;
+		}
+
+		const b2TreeNode* child = m_nodes + children[i];
+		wideNode->lowerX[i] = child->aabb.lowerBound.x;
+		wideNode->lowerY[i] = child->aabb.lowerBound.y;
+		wideNode->upperX[i] = child->aabb.upperBound.x;
+		wideNode->upperY[i] = child->aabb.upperBound.y;
+		wideNode->children[i] = child->IsLeaf() ? ~children[i] : BuildWideNode(children[i]);
+	}
+
+	return wideIndex;
+}
+
+void b2DynamicTree::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_root);
+	snapshot->Write(m_nodeCount);
+	snapshot->Write(m_nodeCapacity);
+	snapshot->Write(m_freeList);
+	snapshot->Write(m_path);
+	snapshot->Write(m_insertionCount);
+	snapshot->Write(HasWideNodes());
+	snapshot->Write(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+}
+
+void b2DynamicTree::Load(b2SnapshotReader* reader)
+{
+	int32 nodeCapacity;
+	bool hasWideNodes;
+	reader->Read(&m_root);
+	reader->Read(&m_nodeCount);
+	reader->Read(&nodeCapacity);
+	reader->Read(&m_freeList);
+	reader->Read(&m_path);
+	reader->Read(&m_insertionCount);
+	reader->Read(&hasWideNodes);
+
+	// The capacity decides when the pool grows, so it must match.
+	if (nodeCapacity != m_nodeCapacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = nodeCapacity;
+		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	}
+
+	reader->Read(m_nodes, m_nodeCapacity * sizeof(b2TreeNode));
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		m_nodes[i].userData = NULL;
+	}
+
+	// Queries visit proxies in a different order through the wide nodes.
+	m_wideNodeCount = 0;
+	m_wideRoot = b2_nullNode;
+	if (hasWideNodes)
+	{
+		BuildWideNodes();
+	}
+}
@@ -21,9 +21,13 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2GrowableStack.h>
+#include <Box2D/Common/b2Simd.h>
 
 #define b2_nullNode (-1)
 
+class b2Snapshot;
+class b2SnapshotReader;
+
 /// A node in the dynamic tree. The client does not interact with this directly.
 struct b2TreeNode
 {
@@ -50,6 +54,19 @@ struct b2TreeNode
 	int32 height;
 };
 
+/// A node of the four wide tree built by b2DynamicTree::BuildWideNodes. The child
+/// bounds are stored by component so they can be tested together. Leaf children
+/// store ~proxyId. Unused lanes have empty bounds.
+struct b2WideTreeNode
+{
+	float32 lowerX[4];
+	float32 lowerY[4];
+	float32 upperX[4];
+	float32 upperY[4];
+	int32 children[4];
+	int32 childCount;
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -67,12 +84,22 @@ public:
 	/// Destroy the tree, freeing the node pool.
 	~b2DynamicTree();
 
+	/// Destroy all proxies at once. The node pool keeps its capacity.
+	void Reset();
+
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
+	/// Create many proxies and rebuild the tree once instead of inserting them
+	/// one at a time. The ids are written to proxyIds.
+	void CreateProxies(int32* proxyIds, const b2AABB* aabbs, void* const* userData, int32 count);
+
+	/// Destroy many proxies and rebuild the tree from the rest.
+	void DestroyProxies(const int32* proxyIds, int32 count);
+
 	/// Move a proxy with a swepted AABB. If the proxy has moved outside of its fattened AABB,
 	/// then the proxy is removed from the tree and re-inserted. Otherwise
 	/// the function returns immediately.
@@ -83,6 +110,9 @@ public:
 	/// @return the proxy user data or 0 if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
 
+	/// Set proxy user data.
+	void SetUserData(int32 proxyId, void* userData);
+
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
@@ -118,6 +148,27 @@ public:
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Rebuild the tree in O(N log N) time. The leaves are sorted along a Morton
+	/// curve and neighbors are paired bottom-up. This gives a good tree for static
+	/// geometry that was inserted one proxy at a time. Proxy ids do not change.
+	/// The leaves don't need to be linked into the tree.
+	void Rebuild();
+
+	/// Collapse the tree into four wide nodes. Query and RayCast use the wide nodes
+	/// until the tree is next modified, because they test four children at a time.
+	void BuildWideNodes();
+
+	/// Are the wide nodes up to date?
+	bool HasWideNodes() const;
+
+	/// Write the node pool to a snapshot.
+	void Save(b2Snapshot* snapshot) const;
+
+	/// Replace the tree with one written by Save. Proxy ids and the free list are
+	/// preserved, so later proxies get the same ids. The user data of every proxy
+	/// is NULL, use SetUserData.
+	void Load(b2SnapshotReader* reader);
+
 private:
 
 	int32 AllocateNode();
@@ -134,6 +185,14 @@ private:
 	void ValidateStructure(int32 index) const;
 	void ValidateMetrics(int32 index) const;
 
+	int32 BuildWideNode(int32 nodeId);
+
+	template <typename T>
+	void QueryWide(T* callback, const b2AABB& aabb) const;
+
+	template <typename T>
+	void RayCastWide(T* callback, const b2RayCastInput& input) const;
+
 	int32 m_root;
 
 	b2TreeNode* m_nodes;
@@ -146,6 +205,12 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	/// Wide nodes, valid while m_wideRoot is not null.
+	b2WideTreeNode* m_wideNodes;
+	int32 m_wideNodeCount;
+	int32 m_wideNodeCapacity;
+	int32 m_wideRoot;
 };
 
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
@@ -154,15 +219,33 @@ inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 	return m_nodes[proxyId].userData;
 }
 
+inline void b2DynamicTree::SetUserData(int32 proxyId, void* userData)
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	b2Assert(m_nodes[proxyId].IsLeaf());
+	m_nodes[proxyId].userData = userData;
+}
+
 inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
 	return m_nodes[proxyId].aabb;
 }
 
+inline bool b2DynamicTree::HasWideNodes() const
+{
+	return m_wideRoot != b2_nullNode;
+}
+
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
+	if (m_wideRoot != b2_nullNode)
+	{
+		QueryWide(callback, aabb);
+		return;
+	}
+
 	b2GrowableStack<int32, 256> stack;
 	stack.Push(m_root);
 
@@ -198,6 +281,12 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 template <typename T>
 inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) const
 {
+	if (m_wideRoot != b2_nullNode)
+	{
+		RayCastWide(callback, input);
+		return;
+	}
+
 	b2Vec2 p1 = input.p1;
 	b2Vec2 p2 = input.p2;
 	b2Vec2 r = p2 - p1;
@@ -281,4 +370,148 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 	}
 }
 
+template <typename T>
+inline void b2DynamicTree::QueryWide(T* callback, const b2AABB& aabb) const
+{
+	b2FloatW lowerX = b2SplatW(aabb.lowerBound.x);
+	b2FloatW lowerY = b2SplatW(aabb.lowerBound.y);
+	b2FloatW upperX = b2SplatW(aabb.upperBound.x);
+	b2FloatW upperY = b2SplatW(aabb.upperBound.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_wideRoot);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_wideNodes + stack.Pop();
+
+		// Same test as b2TestOverlap for all four children.
+		b2FloatW overlap = b2AndW(
+			b2AndW(b2LessEqualW(b2LoadW(node->lowerX), upperX), b2LessEqualW(b2LoadW(node->lowerY), upperY)),
+			b2AndW(b2LessEqualW(lowerX, b2LoadW(node->upperX)), b2LessEqualW(lowerY, b2LoadW(node->upperY))));
+
+		int32 mask = b2MoveMaskW(overlap) & ((1 << node->childCount) - 1);
+		for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+		{
+			if ((mask & 1) == 0)
+			{
+				continue;
+			}
+
+			int32 child = node->children[i];
+			if (child >= 0)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			bool proceed = callback->QueryCallback(~child);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2DynamicTree::RayCastWide(T* callback, const b2RayCastInput& input) const
+{
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2FloatW zero = b2ZeroW();
+	b2FloatW half = b2SplatW(0.5f);
+	b2FloatW p1X = b2SplatW(p1.x);
+	b2FloatW p1Y = b2SplatW(p1.y);
+	b2FloatW vX = b2SplatW(v.x);
+	b2FloatW vY = b2SplatW(v.y);
+	b2FloatW absVX = b2SplatW(abs_v.x);
+	b2FloatW absVY = b2SplatW(abs_v.y);
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_wideRoot);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_wideNodes + stack.Pop();
+
+		b2FloatW nodeLowerX = b2LoadW(node->lowerX);
+		b2FloatW nodeLowerY = b2LoadW(node->lowerY);
+		b2FloatW nodeUpperX = b2LoadW(node->upperX);
+		b2FloatW nodeUpperY = b2LoadW(node->upperY);
+
+		b2FloatW overlap = b2AndW(
+			b2AndW(b2LessEqualW(nodeLowerX, b2SplatW(segmentAABB.upperBound.x)), b2LessEqualW(nodeLowerY, b2SplatW(segmentAABB.upperBound.y))),
+			b2AndW(b2LessEqualW(b2SplatW(segmentAABB.lowerBound.x), nodeUpperX), b2LessEqualW(b2SplatW(segmentAABB.lowerBound.y), nodeUpperY)));
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2FloatW cX = b2MulW(half, b2AddW(nodeLowerX, nodeUpperX));
+		b2FloatW cY = b2MulW(half, b2AddW(nodeLowerY, nodeUpperY));
+		b2FloatW hX = b2MulW(half, b2SubW(nodeUpperX, nodeLowerX));
+		b2FloatW hY = b2MulW(half, b2SubW(nodeUpperY, nodeLowerY));
+		b2FloatW d = b2DotW(vX, vY, b2SubW(p1X, cX), b2SubW(p1Y, cY));
+		b2FloatW absD = b2MaxW(d, b2SubW(zero, d));
+		b2FloatW separation = b2SubW(absD, b2DotW(absVX, absVY, hX, hY));
+
+		overlap = b2AndW(overlap, b2LessEqualW(separation, zero));
+
+		int32 mask = b2MoveMaskW(overlap) & ((1 << node->childCount) - 1);
+		for (int32 i = 0; mask != 0; ++i, mask >>= 1)
+		{
+			if ((mask & 1) == 0)
+			{
+				continue;
+			}
+
+			int32 child = node->children[i];
+			if (child >= 0)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, ~child);
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+	}
+}
+
 #endif
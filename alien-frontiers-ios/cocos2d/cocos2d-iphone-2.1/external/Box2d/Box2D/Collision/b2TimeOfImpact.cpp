@@ -28,6 +28,32 @@ using namespace std;
 int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
 int32 b2_toiRootIters, b2_toiMaxRootIters;
 
+extern int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+
+void b2ClearTOICounters(b2TOICounters* counters)
+{
+	counters->calls = 0;
+	counters->iters = 0;
+	counters->maxIters = 0;
+	counters->rootIters = 0;
+	counters->maxRootIters = 0;
+	counters->distance.calls = 0;
+	counters->distance.iters = 0;
+	counters->distance.maxIters = 0;
+}
+
+void b2AddTOICounters(const b2TOICounters& counters)
+{
+	b2_toiCalls += counters.calls;
+	b2_toiIters += counters.iters;
+	b2_toiMaxIters = b2Max(b2_toiMaxIters, counters.maxIters);
+	b2_toiRootIters += counters.rootIters;
+	b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, counters.maxRootIters);
+	b2_gjkCalls += counters.distance.calls;
+	b2_gjkIters += counters.distance.iters;
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, counters.distance.maxIters);
+}
+
 struct b2SeparationFunction
 {
 	enum Type
@@ -256,7 +282,15 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	++b2_toiCalls;
+	b2TOICounters counters;
+	b2ClearTOICounters(&counters);
+	b2TimeOfImpact(output, input, &counters);
+	b2AddTOICounters(counters);
+}
+
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2TOICounters* counters)
+{
+	++counters->calls;
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
@@ -304,7 +338,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		distanceInput.transformA = xfA;
 		distanceInput.transformB = xfB;
 		b2DistanceOutput distanceOutput;
-		b2Distance(&distanceOutput, &cache, &distanceInput);
+		b2Distance(&distanceOutput, &cache, &distanceInput, &counters->distance);
 
 		// If the shapes are overlapped, we give up on continuous collision.
 		if (distanceOutput.distance <= 0.0f)
@@ -444,7 +478,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
+				++counters->rootIters;
 
 				if (rootIterCount == 50)
 				{
@@ -452,7 +486,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			counters->maxRootIters = b2Max(counters->maxRootIters, rootIterCount);
 
 			++pushBackIter;
 
@@ -463,7 +497,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
+		++counters->iters;
 
 		if (done)
 		{
@@ -479,5 +513,5 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	counters->maxIters = b2Max(counters->maxIters, iter);
 }
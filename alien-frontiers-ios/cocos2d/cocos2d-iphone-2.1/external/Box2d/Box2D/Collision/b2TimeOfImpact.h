@@ -55,4 +55,26 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Iteration counts of b2TimeOfImpact, for profiling.
+struct b2TOICounters
+{
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+	int32 rootIters;
+	int32 maxRootIters;
+	b2DistanceCounters distance;
+};
+
+/// Same as above, but adds to the given counters instead of the global
+/// b2_toi and b2_gjk counters. Threads that call this at the same time
+/// must use their own counters.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2TOICounters* counters);
+
+/// Zero the counters.
+void b2ClearTOICounters(b2TOICounters* counters);
+
+/// Add the counters to the global b2_toi and b2_gjk counters.
+void b2AddTOICounters(const b2TOICounters& counters);
+
 #endif
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Math.h>
 #include <cstdlib>
 #include <climits>
 #include <cstring>
@@ -64,6 +65,7 @@ b2BlockAllocator::b2BlockAllocator()
 
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(&m_stats, 0, sizeof(b2BlockAllocatorStats));
 
 	if (s_blockSizeLookupInitialized == false)
 	{
@@ -105,12 +107,17 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
+		m_stats.liveBytes += size;
+		m_stats.peakBytes = b2Max(m_stats.peakBytes, m_stats.liveBytes);
 		return b2Alloc(size);
 	}
 
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	m_stats.liveBytes += s_blockSizes[index];
+	m_stats.peakBytes = b2Max(m_stats.peakBytes, m_stats.liveBytes);
+
 	if (m_freeLists[index])
 	{
 		b2Block* block = m_freeLists[index];
@@ -149,6 +156,7 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 		m_freeLists[index] = chunk->blocks->next;
 		++m_chunkCount;
+		m_stats.chunkCount = m_chunkCount;
 
 		return chunk->blocks;
 	}
@@ -165,6 +173,7 @@ void b2BlockAllocator::Free(void* p, int32 size)
 
 	if (size > b2_maxBlockSize)
 	{
+		m_stats.liveBytes -= size;
 		b2Free(p);
 		return;
 	}
@@ -172,6 +181,8 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	m_stats.liveBytes -= s_blockSizes[index];
+
 #ifdef _DEBUG
 	// Verify the memory address and size is valid.
 	int32 blockSize = s_blockSizes[index];
@@ -214,4 +225,7 @@ void b2BlockAllocator::Clear()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	m_stats.liveBytes = 0;
+	m_stats.chunkCount = 0;
 }
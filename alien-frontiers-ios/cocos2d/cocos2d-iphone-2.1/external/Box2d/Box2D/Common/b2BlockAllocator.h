@@ -29,8 +29,18 @@ const int32 b2_chunkArrayIncrement = 128;
 struct b2Block;
 struct b2Chunk;
 
+/// Memory use of a block allocator. Small blocks count the size of their
+/// size class, larger blocks count the requested size.
+struct b2BlockAllocatorStats
+{
+	int32 liveBytes;	///< bytes handed out and not freed
+	int32 peakBytes;	///< the largest liveBytes seen, kept by Clear
+	int32 chunkCount;	///< chunks of b2_chunkSize bytes held
+};
+
 /// This is a small object allocator used for allocating small
 /// objects that persist for more than one time step.
+/// This is not thread-safe. Tasks run by b2World use per-thread stack allocators.
 /// See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
 class b2BlockAllocator
 {
@@ -44,8 +54,13 @@ public:
 	/// Free memory. This will use b2Free if the size is larger than b2_maxBlockSize.
 	void Free(void* p, int32 size);
 
+	/// Free all chunks in O(chunk count). All blocks become invalid. Blocks
+	/// larger than b2_maxBlockSize are not tracked and must be freed first.
 	void Clear();
 
+	/// Get the memory statistics.
+	const b2BlockAllocatorStats& GetStats() const;
+
 private:
 
 	b2Chunk* m_chunks;
@@ -54,9 +69,16 @@ private:
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	b2BlockAllocatorStats m_stats;
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
 };
 
+inline const b2BlockAllocatorStats& b2BlockAllocator::GetStats() const
+{
+	return m_stats;
+}
+
 #endif
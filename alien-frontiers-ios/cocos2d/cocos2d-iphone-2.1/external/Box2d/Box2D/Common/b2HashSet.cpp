@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2HashSet.h>
+#include <cstring>
+
+// Zero marks an empty slot.
+#define b2_emptyKey 0
+
+// Mix the key bits (MurmurHash3 finalizer).
+inline uint32 b2HashKey(uint64 key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	key ^= key >> 33;
+	return uint32(key);
+}
+
+b2HashSet::b2HashSet()
+{
+	m_capacity = 16;
+	m_count = 0;
+	m_keys = (uint64*)b2Alloc(m_capacity * sizeof(uint64));
+	memset(m_keys, 0, m_capacity * sizeof(uint64));
+}
+
+b2HashSet::~b2HashSet()
+{
+	b2Free(m_keys);
+}
+
+// Find the slot holding the key or the empty slot where it would go.
+// The capacity is a power of two.
+int32 b2HashSet::FindSlot(uint64 key) const
+{
+	uint32 mask = uint32(m_capacity - 1);
+	uint32 index = b2HashKey(key) & mask;
+	while (m_keys[index] != b2_emptyKey && m_keys[index] != key)
+	{
+		index = (index + 1) & mask;
+	}
+	return int32(index);
+}
+
+void b2HashSet::Grow()
+{
+	uint64* oldKeys = m_keys;
+	int32 oldCapacity = m_capacity;
+
+	m_capacity *= 2;
+	m_keys = (uint64*)b2Alloc(m_capacity * sizeof(uint64));
+	memset(m_keys, 0, m_capacity * sizeof(uint64));
+
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldKeys[i] != b2_emptyKey)
+		{
+			m_keys[FindSlot(oldKeys[i])] = oldKeys[i];
+		}
+	}
+
+	b2Free(oldKeys);
+}
+
+bool b2HashSet::Add(uint64 key)
+{
+	b2Assert(key != b2_emptyKey);
+
+	// Keep the load factor at or below one half.
+	if (2 * (m_count + 1) > m_capacity)
+	{
+		Grow();
+	}
+
+	int32 index = FindSlot(key);
+	if (m_keys[index] == key)
+	{
+		return false;
+	}
+
+	m_keys[index] = key;
+	++m_count;
+	return true;
+}
+
+bool b2HashSet::Remove(uint64 key)
+{
+	b2Assert(key != b2_emptyKey);
+
+	int32 index = FindSlot(key);
+	if (m_keys[index] != key)
+	{
+		return false;
+	}
+
+	// Shift later entries of the probe run back into the hole so that
+	// lookups never stop early.
+	uint32 mask = uint32(m_capacity - 1);
+	uint32 hole = uint32(index);
+	uint32 next = (hole + 1) & mask;
+	while (m_keys[next] != b2_emptyKey)
+	{
+		uint32 home = b2HashKey(m_keys[next]) & mask;
+
+		// Move the entry if its home slot is not in (hole, next].
+		if (((next - home) & mask) >= ((next - hole) & mask))
+		{
+			m_keys[hole] = m_keys[next];
+			hole = next;
+		}
+
+		next = (next + 1) & mask;
+	}
+
+	m_keys[hole] = b2_emptyKey;
+	--m_count;
+	return true;
+}
+
+bool b2HashSet::Contains(uint64 key) const
+{
+	b2Assert(key != b2_emptyKey);
+	return m_keys[FindSlot(key)] == key;
+}
+
+void b2HashSet::Clear()
+{
+	if (m_count > 0)
+	{
+		memset(m_keys, 0, m_capacity * sizeof(uint64));
+		m_count = 0;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_HASH_SET_H
+#define B2_HASH_SET_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A set of non-zero 64 bit keys with open addressing and linear probing.
+/// Insert, lookup and removal are O(1) on average. Removal shifts entries
+/// back, so there are no tombstones and lookups stay short.
+class b2HashSet
+{
+public:
+	b2HashSet();
+	~b2HashSet();
+
+	/// Add a key.
+	/// @return false if the key was already in the set.
+	bool Add(uint64 key);
+
+	/// Remove a key.
+	/// @return false if the key was not in the set.
+	bool Remove(uint64 key);
+
+	/// Is the key in the set?
+	bool Contains(uint64 key) const;
+
+	/// Remove all keys. This keeps the memory.
+	void Clear();
+
+	/// Get the number of keys.
+	int32 GetCount() const;
+
+private:
+
+	int32 FindSlot(uint64 key) const;
+	void Grow();
+
+	uint64* m_keys;
+	int32 m_capacity;
+	int32 m_count;
+};
+
+inline int32 b2HashSet::GetCount() const
+{
+	return m_count;
+}
+
+#endif
@@ -92,3 +92,149 @@ void b2Mat33::GetSymInverse33(b2Mat33* M) const
 	M->ez.y = M->ey.z;
 	M->ez.z = det * (a11 * a22 - a12 * a12);
 }
+
+#if defined(B2_DETERMINISTIC)
+
+// These are the single precision kernels of the Cephes library. Every operation is
+// written out so the result only depends on IEEE arithmetic. The angle is reduced by
+// multiples of pi/4 that are split in three parts, so the products are exact.
+
+static const float32 b2_fourOverPi = 1.27323954473516f;
+static const float32 b2_quarterPi1 = 0.78515625f;
+static const float32 b2_quarterPi2 = 2.4187564849853515625e-4f;
+static const float32 b2_quarterPi3 = 3.77489497744594108e-8f;
+
+// Reduce |x| to [-pi/4, pi/4] and return the octant in [0, 8).
+static int32 b2ReduceAngle(float32* reduced, float32 x)
+{
+	// This avoids converting huge values to integers.
+	float32 y = floorf(x * b2_fourOverPi);
+	int32 octant = int32(y - 8.0f * floorf(0.125f * y));
+
+	// Map zeros to origins.
+	if (octant & 1)
+	{
+		octant += 1;
+		y += 1.0f;
+	}
+
+	*reduced = ((x - y * b2_quarterPi1) - y * b2_quarterPi2) - y * b2_quarterPi3;
+	return octant & 7;
+}
+
+static float32 b2SinKernel(float32 x)
+{
+	float32 z = x * x;
+	return ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+}
+
+static float32 b2CosKernel(float32 x)
+{
+	float32 z = x * x;
+	return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+}
+
+float32 b2Sin(float32 x)
+{
+	float32 sign = 1.0f;
+	if (x < 0.0f)
+	{
+		x = -x;
+		sign = -1.0f;
+	}
+
+	float32 r;
+	int32 octant = b2ReduceAngle(&r, x);
+	if (octant > 3)
+	{
+		sign = -sign;
+		octant -= 4;
+	}
+
+	float32 s = (octant == 1 || octant == 2) ? b2CosKernel(r) : b2SinKernel(r);
+	return sign * s;
+}
+
+float32 b2Cos(float32 x)
+{
+	float32 sign = 1.0f;
+	if (x < 0.0f)
+	{
+		x = -x;
+	}
+
+	float32 r;
+	int32 octant = b2ReduceAngle(&r, x);
+	if (octant > 3)
+	{
+		sign = -sign;
+		octant -= 4;
+	}
+
+	if (octant > 1)
+	{
+		sign = -sign;
+	}
+
+	float32 c = (octant == 1 || octant == 2) ? b2SinKernel(r) : b2CosKernel(r);
+	return sign * c;
+}
+
+static float32 b2Atan(float32 x)
+{
+	float32 sign = 1.0f;
+	if (x < 0.0f)
+	{
+		x = -x;
+		sign = -1.0f;
+	}
+
+	// Reduce to |x| <= tan(pi / 8).
+	float32 y;
+	if (x > 2.414213562373095f)
+	{
+		y = 0.5f * b2_pi;
+		x = -1.0f / x;
+	}
+	else if (x > 0.4142135623730950f)
+	{
+		y = 0.25f * b2_pi;
+		x = (x - 1.0f) / (x + 1.0f);
+	}
+	else
+	{
+		y = 0.0f;
+	}
+
+	float32 z = x * x;
+	y += (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * x + x;
+	return sign * y;
+}
+
+float32 b2Atan2(float32 y, float32 x)
+{
+	if (x == 0.0f)
+	{
+		if (y > 0.0f)
+		{
+			return 0.5f * b2_pi;
+		}
+
+		if (y < 0.0f)
+		{
+			return -0.5f * b2_pi;
+		}
+
+		return 0.0f;
+	}
+
+	float32 angle = b2Atan(y / x);
+	if (x < 0.0f)
+	{
+		angle += y < 0.0f ? -b2_pi : b2_pi;
+	}
+
+	return angle;
+}
+
+#endif
@@ -57,8 +57,20 @@ inline float32 b2InvSqrt(float32 x)
 	return x;
 }
 
+// IEEE 754 requires a correctly rounded square root, so this is deterministic.
 #define	b2Sqrt(x)	std::sqrt(x)
+
+#if defined(B2_DETERMINISTIC)
+/// Sine, cosine and arc tangent that only use basic arithmetic, so that they give the
+/// same results everywhere. These are accurate to a few ulp for angles below 8192.
+float32 b2Sin(float32 x);
+float32 b2Cos(float32 x);
+float32 b2Atan2(float32 y, float32 x);
+#else
+#define	b2Sin(x)	sinf(x)
+#define	b2Cos(x)	cosf(x)
 #define	b2Atan2(y, x)	std::atan2(y, x)
+#endif
 
 /// A 2D column vector.
 struct b2Vec2
@@ -315,16 +327,16 @@ struct b2Rot
 	explicit b2Rot(float32 angle)
 	{
 		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		s = b2Sin(angle);
+		c = b2Cos(angle);
 	}
 
 	/// Set using an angle in radians.
 	void Set(float32 angle)
 	{
 		/// TODO_ERIN optimize
-		s = sinf(angle);
-		c = cosf(angle);
+		s = b2Sin(angle);
+		c = b2Cos(angle);
 	}
 
 	/// Set to the identity rotation
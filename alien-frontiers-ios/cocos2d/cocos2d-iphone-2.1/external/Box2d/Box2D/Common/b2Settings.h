@@ -31,9 +31,28 @@ typedef signed int int32;
 typedef unsigned char uint8;
 typedef unsigned short uint16;
 typedef unsigned int uint32;
+typedef unsigned long long uint64;
 typedef float float32;
 typedef double float64;
 
+/// Define B2_DETERMINISTIC to make stepping bitwise identical across compilers and
+/// optimization levels on targets with IEEE single precision math, such as x86-64
+/// and ARM64. Box2D then uses its own sine, cosine and arc tangent instead of libm.
+/// The compiler must not fuse multiplies and adds (-ffp-contract=off) and must keep
+/// IEEE semantics (no -ffast-math). Thread count does not change the results.
+#if defined(B2_DETERMINISTIC)
+#include <cfloat>
+#if defined(__FAST_MATH__)
+#error "B2_DETERMINISTIC does not work with -ffast-math."
+#endif
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+#error "B2_DETERMINISTIC needs single precision float evaluation, such as SSE2 math on x86."
+#endif
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
+
 #define	b2_maxFloat		FLT_MAX
 #define	b2_epsilon		FLT_EPSILON
 #define b2_pi			3.14159265359f
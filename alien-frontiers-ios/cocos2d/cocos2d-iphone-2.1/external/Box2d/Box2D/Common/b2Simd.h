@@ -0,0 +1,191 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include <Box2D/Common/b2Math.h>
+
+/// Four wide float math for the solvers and the broad-phase. This uses SSE2 or
+/// NEON when the compiler targets them and plain C++ otherwise. Comparisons return
+/// lane masks that are all ones or all zeros and are consumed by b2BlendW.
+/// Loads and stores do not require alignment. ARMv7 NEON estimates division and
+/// square roots, so deterministic builds use plain C++ there.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define B2_SIMD_SSE2
+#include <emmintrin.h>
+typedef __m128 b2FloatW;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && (defined(__aarch64__) || !defined(B2_DETERMINISTIC))
+#define B2_SIMD_NEON
+#include <arm_neon.h>
+typedef float32x4_t b2FloatW;
+#else
+#define B2_SIMD_NONE
+struct b2FloatW
+{
+	float32 v[4];
+};
+#endif
+
+const int32 b2_simdWidth = 4;
+
+#if defined(B2_SIMD_SSE2)
+
+inline b2FloatW b2ZeroW() { return _mm_setzero_ps(); }
+inline b2FloatW b2SplatW(float32 a) { return _mm_set1_ps(a); }
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return _mm_div_ps(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return _mm_sqrt_ps(a); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return _mm_cmpgt_ps(a, b); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { return _mm_cmple_ps(a, b); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm_or_ps(a, b); }
+
+/// Select a where the mask is set and b elsewhere.
+inline b2FloatW b2BlendW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Get one bit per lane, lane 0 in the lowest bit.
+inline int32 b2MoveMaskW(b2FloatW mask) { return _mm_movemask_ps(mask); }
+
+#elif defined(B2_SIMD_NEON)
+
+inline b2FloatW b2ZeroW() { return vdupq_n_f32(0.0f); }
+inline b2FloatW b2SplatW(float32 a) { return vdupq_n_f32(a); }
+inline b2FloatW b2LoadW(const float32* p) { return vld1q_f32(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { vst1q_f32(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return vaddq_f32(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return vsubq_f32(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return vmulq_f32(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return vminq_f32(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return vmaxq_f32(a, b); }
+
+#if defined(__aarch64__)
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return vdivq_f32(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return vsqrtq_f32(a); }
+#else
+// ARMv7 has no vector divide. Refine the reciprocal estimate twice.
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b)
+{
+	b2FloatW r = vrecpeq_f32(b);
+	r = vmulq_f32(vrecpsq_f32(b, r), r);
+	r = vmulq_f32(vrecpsq_f32(b, r), r);
+	return vmulq_f32(a, r);
+}
+
+inline b2FloatW b2SqrtW(b2FloatW a)
+{
+	b2FloatW r = vrsqrteq_f32(a);
+	r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+	r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a, r), r), r);
+	b2FloatW s = vmulq_f32(a, r);
+	return vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(a, vdupq_n_f32(0.0f)), vreinterpretq_u32_f32(s)));
+}
+#endif
+
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vcleq_f32(a, b)); }
+
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b)
+{
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b)
+{
+	return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+/// Select a where the mask is set and b elsewhere.
+inline b2FloatW b2BlendW(b2FloatW mask, b2FloatW a, b2FloatW b)
+{
+	return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+
+/// Get one bit per lane, lane 0 in the lowest bit.
+inline int32 b2MoveMaskW(b2FloatW mask)
+{
+	uint32 m[4];
+	vst1q_u32(m, vreinterpretq_u32_f32(mask));
+	return int32((m[0] & 1) | (m[1] & 2) | (m[2] & 4) | (m[3] & 8));
+}
+
+#else
+
+#define B2_SIMD_LANES(expr) b2FloatW r; for (int32 i = 0; i < 4; ++i) { r.v[i] = (expr); } return r
+
+inline b2FloatW b2ZeroW() { B2_SIMD_LANES(0.0f); }
+inline b2FloatW b2SplatW(float32 a) { B2_SIMD_LANES(a); }
+inline b2FloatW b2LoadW(const float32* p) { B2_SIMD_LANES(p[i]); }
+inline void b2StoreW(float32* p, b2FloatW a) { for (int32 i = 0; i < 4; ++i) { p[i] = a.v[i]; } }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] + b.v[i]); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] - b.v[i]); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] * b.v[i]); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] / b.v[i]); }
+inline b2FloatW b2SqrtW(b2FloatW a) { B2_SIMD_LANES(b2Sqrt(a.v[i])); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+
+// Masks are stored as 1 or 0 so they never form NaNs.
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] > b.v[i] ? 1.0f : 0.0f); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] >= b.v[i] ? 1.0f : 0.0f); }
+inline b2FloatW b2LessEqualW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] <= b.v[i] ? 1.0f : 0.0f); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] != 0.0f && b.v[i] != 0.0f ? 1.0f : 0.0f); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { B2_SIMD_LANES(a.v[i] != 0.0f || b.v[i] != 0.0f ? 1.0f : 0.0f); }
+
+/// Select a where the mask is set and b elsewhere.
+inline b2FloatW b2BlendW(b2FloatW mask, b2FloatW a, b2FloatW b) { B2_SIMD_LANES(mask.v[i] != 0.0f ? a.v[i] : b.v[i]); }
+
+/// Get one bit per lane, lane 0 in the lowest bit.
+inline int32 b2MoveMaskW(b2FloatW mask)
+{
+	int32 m = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		m |= mask.v[i] != 0.0f ? (1 << i) : 0;
+	}
+	return m;
+}
+
+#undef B2_SIMD_LANES
+
+#endif
+
+/// Dot and cross products of vectors given by their components.
+inline b2FloatW b2DotW(b2FloatW ax, b2FloatW ay, b2FloatW bx, b2FloatW by)
+{
+	return b2AddW(b2MulW(ax, bx), b2MulW(ay, by));
+}
+
+inline b2FloatW b2CrossW(b2FloatW ax, b2FloatW ay, b2FloatW bx, b2FloatW by)
+{
+	return b2SubW(b2MulW(ax, by), b2MulW(ay, bx));
+}
+
+#endif
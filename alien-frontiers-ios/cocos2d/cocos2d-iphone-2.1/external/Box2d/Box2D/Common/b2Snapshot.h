@@ -0,0 +1,142 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SNAPSHOT_H
+#define B2_SNAPSHOT_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <cstring>
+
+/// A growable byte buffer holding the binary state of a world, see b2World::Save.
+/// The library does not rely on any pointer in the bytes, so they may be copied
+/// with memcpy and restored by another world. Values are stored in the memory
+/// layout of the platform, so a snapshot must be restored by the same build.
+class b2Snapshot
+{
+public:
+	b2Snapshot();
+	~b2Snapshot();
+
+	/// Remove all bytes. This keeps the memory.
+	void Clear();
+
+	/// Append bytes.
+	void Write(const void* data, int32 size);
+
+	/// Append a value that has a plain memory layout.
+	template <typename T>
+	void Write(const T& value);
+
+	/// Replace the contents with a copy of the given bytes.
+	void SetData(const void* data, int32 size);
+
+	/// Get the bytes.
+	const void* GetData() const;
+
+	/// Get the number of bytes.
+	int32 GetSize() const;
+
+private:
+
+	// Copy the bytes instead.
+	b2Snapshot(const b2Snapshot&);
+	b2Snapshot& operator=(const b2Snapshot&);
+
+	void Reserve(int32 capacity);
+
+	char* m_data;
+	int32 m_size;
+	int32 m_capacity;
+};
+
+/// Reads the values of a snapshot in the order they were written.
+class b2SnapshotReader
+{
+public:
+	b2SnapshotReader(const b2Snapshot& snapshot);
+
+	/// Read bytes.
+	void Read(void* data, int32 size);
+
+	/// Read a value that has a plain memory layout.
+	template <typename T>
+	void Read(T* value);
+
+	/// Is everything read?
+	bool IsDone() const;
+
+private:
+
+	const char* m_data;
+	int32 m_size;
+	int32 m_index;
+};
+
+inline void b2Snapshot::Write(const void* data, int32 size)
+{
+	b2Assert(size >= 0);
+	if (m_size + size > m_capacity)
+	{
+		Reserve(m_size + size);
+	}
+
+	if (size > 0)
+	{
+		memcpy(m_data + m_size, data, size);
+		m_size += size;
+	}
+}
+
+template <typename T>
+inline void b2Snapshot::Write(const T& value)
+{
+	Write(&value, sizeof(T));
+}
+
+inline const void* b2Snapshot::GetData() const
+{
+	return m_data;
+}
+
+inline int32 b2Snapshot::GetSize() const
+{
+	return m_size;
+}
+
+inline void b2SnapshotReader::Read(void* data, int32 size)
+{
+	b2Assert(size >= 0 && m_index + size <= m_size);
+	if (size > 0)
+	{
+		memcpy(data, m_data + m_index, size);
+		m_index += size;
+	}
+}
+
+template <typename T>
+inline void b2SnapshotReader::Read(T* value)
+{
+	Read(value, sizeof(T));
+}
+
+inline bool b2SnapshotReader::IsDone() const
+{
+	return m_index == m_size;
+}
+
+#endif
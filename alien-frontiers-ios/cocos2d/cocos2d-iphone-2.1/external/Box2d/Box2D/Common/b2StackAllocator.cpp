@@ -19,65 +19,83 @@
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Math.h>
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(int32 capacity)
 {
+	b2Assert(capacity >= 0);
+	m_data = (char*)b2Alloc(capacity);
 	m_index = 0;
 	m_allocation = 0;
-	m_maxAllocation = 0;
-	m_entryCount = 0;
+	m_stats.capacity = capacity;
+	m_stats.peakBytes = 0;
+	m_stats.fallbackCount = 0;
+	m_stats.fallbackBytes = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
-	b2Assert(m_entryCount == 0);
+	b2Assert(m_entries.GetCount() == 0);
+	b2Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
 {
-	b2Assert(m_entryCount < b2_maxStackEntries);
-
-	b2StackEntry* entry = m_entries + m_entryCount;
-	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	b2StackEntry entry;
+	entry.size = size;
+	if (m_index + size > m_stats.capacity)
 	{
-		entry->data = (char*)b2Alloc(size);
-		entry->usedMalloc = true;
+		entry.data = (char*)b2Alloc(size);
+		entry.usedMalloc = true;
+		++m_stats.fallbackCount;
+		m_stats.fallbackBytes += size;
 	}
 	else
 	{
-		entry->data = m_data + m_index;
-		entry->usedMalloc = false;
+		entry.data = m_data + m_index;
+		entry.usedMalloc = false;
 		m_index += size;
 	}
 
 	m_allocation += size;
-	m_maxAllocation = b2Max(m_maxAllocation, m_allocation);
-	++m_entryCount;
+	m_stats.peakBytes = b2Max(m_stats.peakBytes, m_allocation);
+	m_entries.Push(entry);
 
-	return entry->data;
+	return entry.data;
 }
 
 void b2StackAllocator::Free(void* p)
 {
-	b2Assert(m_entryCount > 0);
-	b2StackEntry* entry = m_entries + m_entryCount - 1;
-	b2Assert(p == entry->data);
-	if (entry->usedMalloc)
+	b2StackEntry entry = m_entries.Pop();
+	b2Assert(p == entry.data);
+	if (entry.usedMalloc)
 	{
 		b2Free(p);
 	}
 	else
 	{
-		m_index -= entry->size;
+		m_index -= entry.size;
+	}
+	m_allocation -= entry.size;
+
+	// Grow to the high-water mark while nothing points into the arena.
+	if (m_entries.GetCount() == 0 && m_stats.peakBytes > m_stats.capacity)
+	{
+		SetCapacity(m_stats.peakBytes);
 	}
-	m_allocation -= entry->size;
-	--m_entryCount;
 
 	p = NULL;
 }
 
+void b2StackAllocator::SetCapacity(int32 capacity)
+{
+	b2Assert(capacity >= 0);
+	b2Assert(m_entries.GetCount() == 0);
+	b2Free(m_data);
+	m_data = (char*)b2Alloc(capacity);
+	m_stats.capacity = capacity;
+}
+
 int32 b2StackAllocator::GetMaxAllocation() const
 {
-	return m_maxAllocation;
+	return m_stats.peakBytes;
 }
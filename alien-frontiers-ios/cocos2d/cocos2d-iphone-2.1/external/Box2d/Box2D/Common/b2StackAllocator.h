@@ -20,6 +20,7 @@
 #define B2_STACK_ALLOCATOR_H
 
 #include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2GrowableStack.h>
 
 const int32 b2_stackSize = 100 * 1024;	// 100k
 const int32 b2_maxStackEntries = 32;
@@ -31,30 +32,53 @@ struct b2StackEntry
 	bool usedMalloc;
 };
 
+/// Memory use of a stack allocator.
+struct b2StackAllocatorStats
+{
+	int32 capacity;			///< bytes in the arena
+	int32 peakBytes;		///< the largest total allocation seen
+	int32 fallbackCount;	///< allocations that did not fit the arena and used b2Alloc
+	int32 fallbackBytes;	///< bytes of those allocations
+};
+
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+// Allocations that do not fit the arena use b2Alloc. The next time the
+// stack is empty the arena grows to the peak allocation, so a steady
+// simulation stops using b2Alloc after one step.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	b2StackAllocator(int32 capacity = b2_stackSize);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
 	void Free(void* p);
 
+	/// Resize the arena. The stack must be empty. This keeps the statistics.
+	void SetCapacity(int32 capacity);
+
 	int32 GetMaxAllocation() const;
 
+	/// Get the memory statistics.
+	const b2StackAllocatorStats& GetStats() const;
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;
 	int32 m_index;
 
 	int32 m_allocation;
-	int32 m_maxAllocation;
 
-	b2StackEntry m_entries[b2_maxStackEntries];
-	int32 m_entryCount;
+	b2GrowableStack<b2StackEntry, b2_maxStackEntries> m_entries;
+
+	b2StackAllocatorStats m_stats;
 };
 
+inline const b2StackAllocatorStats& b2StackAllocator::GetStats() const
+{
+	return m_stats;
+}
+
 #endif
@@ -0,0 +1,56 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TASK_SCHEDULER_H
+#define B2_TASK_SCHEDULER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A task is a set of independent work items. The scheduler hands out
+/// contiguous ranges of items to its threads.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Execute the items [begin, end).
+	/// @param threadIndex the index of the calling thread, in [0, GetThreadCount()).
+	virtual void Execute(int32 begin, int32 end, int32 threadIndex) = 0;
+};
+
+/// Implement this class to run world work on your own threads and
+/// register it with b2World::SetTaskScheduler. See b2ThreadPool for
+/// a default implementation.
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// The number of threads that may execute tasks, including the calling thread.
+	/// This must not change while the scheduler is registered with a world.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Execute all items of the task and return when they are done.
+	/// Every item must be executed exactly once. Two ranges executing at
+	/// the same time must not share a thread index.
+	/// @param itemCount the number of items.
+	/// @param minRange the smallest range worth handing to another thread.
+	virtual void ParallelFor(b2Task* task, int32 itemCount, int32 minRange) = 0;
+};
+
+#endif
@@ -0,0 +1,189 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2ThreadPool.h>
+#include <Box2D/Common/b2Math.h>
+
+#if defined(__linux__) || defined (__APPLE__)
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	b2Assert(0 < threadCount && threadCount <= b2_maxThreads);
+	m_threadCount = b2Clamp(threadCount, 1, b2_maxThreads);
+
+	m_task = NULL;
+	m_itemCount = 0;
+	m_rangeSize = 1;
+	m_nextItem = 0;
+	m_doneCount = 0;
+	m_generation = 0;
+	m_exit = false;
+
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_workCondition, NULL);
+	pthread_cond_init(&m_doneCondition, NULL);
+
+	// Thread 0 is the thread calling ParallelFor.
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		m_contexts[i].pool = this;
+		m_contexts[i].threadIndex = i;
+		pthread_create(m_threads + i, NULL, ThreadMain, m_contexts + i);
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_exit = true;
+	pthread_cond_broadcast(&m_workCondition);
+	pthread_mutex_unlock(&m_mutex);
+
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		pthread_join(m_threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&m_doneCondition);
+	pthread_cond_destroy(&m_workCondition);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void* b2ThreadPool::ThreadMain(void* arg)
+{
+	b2ThreadContext* context = (b2ThreadContext*)arg;
+	b2ThreadPool* pool = context->pool;
+
+	int32 generation = 0;
+
+	pthread_mutex_lock(&pool->m_mutex);
+	for (;;)
+	{
+		while (pool->m_generation == generation && pool->m_exit == false)
+		{
+			pthread_cond_wait(&pool->m_workCondition, &pool->m_mutex);
+		}
+
+		if (pool->m_exit)
+		{
+			break;
+		}
+
+		generation = pool->m_generation;
+
+		pthread_mutex_unlock(&pool->m_mutex);
+		pool->ExecuteRanges(context->threadIndex);
+		pthread_mutex_lock(&pool->m_mutex);
+	}
+	pthread_mutex_unlock(&pool->m_mutex);
+
+	return NULL;
+}
+
+// Grab ranges until the task is exhausted. The task pointer is only read while
+// ranges remain, so a late worker never touches a task that has completed.
+void b2ThreadPool::ExecuteRanges(int32 threadIndex)
+{
+	for (;;)
+	{
+		pthread_mutex_lock(&m_mutex);
+		if (m_nextItem >= m_itemCount)
+		{
+			pthread_mutex_unlock(&m_mutex);
+			return;
+		}
+
+		b2Task* task = m_task;
+		int32 begin = m_nextItem;
+		int32 end = b2Min(begin + m_rangeSize, m_itemCount);
+		m_nextItem = end;
+		pthread_mutex_unlock(&m_mutex);
+
+		task->Execute(begin, end, threadIndex);
+
+		pthread_mutex_lock(&m_mutex);
+		m_doneCount += end - begin;
+		if (m_doneCount == m_itemCount)
+		{
+			pthread_cond_signal(&m_doneCondition);
+		}
+		pthread_mutex_unlock(&m_mutex);
+	}
+}
+
+void b2ThreadPool::ParallelFor(b2Task* task, int32 itemCount, int32 minRange)
+{
+	if (itemCount <= 0)
+	{
+		return;
+	}
+
+	minRange = b2Max(minRange, 1);
+
+	if (m_threadCount == 1 || itemCount <= minRange)
+	{
+		task->Execute(0, itemCount, 0);
+		return;
+	}
+
+	// Use a few ranges per thread so that uneven items balance out.
+	int32 rangeSize = b2Max(minRange, itemCount / (4 * m_threadCount));
+
+	pthread_mutex_lock(&m_mutex);
+	m_task = task;
+	m_itemCount = itemCount;
+	m_rangeSize = rangeSize;
+	m_nextItem = 0;
+	m_doneCount = 0;
+	++m_generation;
+	pthread_cond_broadcast(&m_workCondition);
+	pthread_mutex_unlock(&m_mutex);
+
+	ExecuteRanges(0);
+
+	pthread_mutex_lock(&m_mutex);
+	while (m_doneCount < m_itemCount)
+	{
+		pthread_cond_wait(&m_doneCondition, &m_mutex);
+	}
+	m_task = NULL;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+#else
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	B2_NOT_USED(threadCount);
+	m_threadCount = 1;
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+}
+
+void b2ThreadPool::ParallelFor(b2Task* task, int32 itemCount, int32 minRange)
+{
+	B2_NOT_USED(minRange);
+	if (itemCount > 0)
+	{
+		task->Execute(0, itemCount, 0);
+	}
+}
+
+#endif
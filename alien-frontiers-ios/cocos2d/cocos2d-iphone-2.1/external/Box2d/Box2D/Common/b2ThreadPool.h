@@ -0,0 +1,88 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include <Box2D/Common/b2TaskScheduler.h>
+
+#if defined(__linux__) || defined (__APPLE__)
+#include <pthread.h>
+#endif
+
+const int32 b2_maxThreads = 32;
+
+/// A simple task scheduler with a fixed number of worker threads. The thread
+/// calling ParallelFor also executes work. This has platform specific code;
+/// where threads are not supported all work runs on the calling thread.
+class b2ThreadPool : public b2TaskScheduler
+{
+public:
+
+	/// Start threadCount - 1 worker threads.
+	b2ThreadPool(int32 threadCount);
+
+	/// Stop and join the worker threads.
+	~b2ThreadPool();
+
+	/// @see b2TaskScheduler::GetThreadCount
+	int32 GetThreadCount() const;
+
+	/// @see b2TaskScheduler::ParallelFor
+	/// This is not re-entrant: a task may not call ParallelFor.
+	void ParallelFor(b2Task* task, int32 itemCount, int32 minRange);
+
+private:
+
+	int32 m_threadCount;
+
+#if defined(__linux__) || defined (__APPLE__)
+	static void* ThreadMain(void* arg);
+
+	void ExecuteRanges(int32 threadIndex);
+
+	struct b2ThreadContext
+	{
+		b2ThreadPool* pool;
+		int32 threadIndex;
+	};
+
+	pthread_t m_threads[b2_maxThreads];
+	b2ThreadContext m_contexts[b2_maxThreads];
+
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_workCondition;
+	pthread_cond_t m_doneCondition;
+
+	// These are protected by the mutex.
+	b2Task* m_task;
+	int32 m_itemCount;
+	int32 m_rangeSize;
+	int32 m_nextItem;
+	int32 m_doneCount;
+	int32 m_generation;
+	bool m_exit;
+#endif
+};
+
+inline int32 b2ThreadPool::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+#endif
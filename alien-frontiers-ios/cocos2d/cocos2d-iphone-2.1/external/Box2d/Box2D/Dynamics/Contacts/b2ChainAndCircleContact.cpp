@@ -20,7 +20,6 @@
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Collision/Shapes/b2ChainShape.h>
-#include <Box2D/Collision/Shapes/b2EdgeShape.h>
 
 #include <new>
 using namespace std;
@@ -46,9 +45,6 @@ b2ChainAndCircleContact::b2ChainAndCircleContact(b2Fixture* fixtureA, int32 inde
 
 void b2ChainAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
-	b2ChainShape* chain = (b2ChainShape*)m_fixtureA->GetShape();
-	b2EdgeShape edge;
-	chain->GetChildEdge(&edge, m_indexA);
-	b2CollideEdgeAndCircle(	manifold, &edge, xfA,
-							(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	b2CollideChainAndCircle(	manifold, (b2ChainShape*)m_fixtureA->GetShape(), m_indexA, xfA,
+								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
 }
@@ -25,6 +25,7 @@
 #include <Box2D/Dynamics/Contacts/b2ChainAndCircleContact.h>
 #include <Box2D/Dynamics/Contacts/b2ChainAndPolygonContact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2TOIQueue.h>
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
@@ -39,29 +40,38 @@ bool b2Contact::s_initialized = false;
 
 void b2Contact::InitializeRegisters()
 {
-	AddType(b2CircleContact::Create, b2CircleContact::Destroy, b2Shape::e_circle, b2Shape::e_circle);
-	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, b2Shape::e_polygon, b2Shape::e_circle);
-	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, b2Shape::e_polygon, b2Shape::e_polygon);
-	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, b2Shape::e_edge, b2Shape::e_circle);
-	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, b2Shape::e_edge, b2Shape::e_polygon);
-	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, b2Shape::e_chain, b2Shape::e_circle);
-	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, b2Shape::e_chain, b2Shape::e_polygon);
+	AddType(b2CircleContact::Create, b2CircleContact::Destroy, EvaluateBatch<b2CircleContact>,
+			b2Shape::e_circle, b2Shape::e_circle);
+	AddType(b2PolygonAndCircleContact::Create, b2PolygonAndCircleContact::Destroy, EvaluateBatch<b2PolygonAndCircleContact>,
+			b2Shape::e_polygon, b2Shape::e_circle);
+	AddType(b2PolygonContact::Create, b2PolygonContact::Destroy, EvaluateBatch<b2PolygonContact>,
+			b2Shape::e_polygon, b2Shape::e_polygon);
+	AddType(b2EdgeAndCircleContact::Create, b2EdgeAndCircleContact::Destroy, EvaluateBatch<b2EdgeAndCircleContact>,
+			b2Shape::e_edge, b2Shape::e_circle);
+	AddType(b2EdgeAndPolygonContact::Create, b2EdgeAndPolygonContact::Destroy, EvaluateBatch<b2EdgeAndPolygonContact>,
+			b2Shape::e_edge, b2Shape::e_polygon);
+	AddType(b2ChainAndCircleContact::Create, b2ChainAndCircleContact::Destroy, EvaluateBatch<b2ChainAndCircleContact>,
+			b2Shape::e_chain, b2Shape::e_circle);
+	AddType(b2ChainAndPolygonContact::Create, b2ChainAndPolygonContact::Destroy, EvaluateBatch<b2ChainAndPolygonContact>,
+			b2Shape::e_chain, b2Shape::e_polygon);
 }
 
 void b2Contact::AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destoryFcn,
-						b2Shape::Type type1, b2Shape::Type type2)
+						b2ContactBatchFcn* batchFcn, b2Shape::Type type1, b2Shape::Type type2)
 {
 	b2Assert(0 <= type1 && type1 < b2Shape::e_typeCount);
 	b2Assert(0 <= type2 && type2 < b2Shape::e_typeCount);
 
 	s_registers[type1][type2].createFcn = createFcn;
 	s_registers[type1][type2].destroyFcn = destoryFcn;
+	s_registers[type1][type2].batchFcn = batchFcn;
 	s_registers[type1][type2].primary = true;
 
 	if (type1 != type2)
 	{
 		s_registers[type2][type1].createFcn = createFcn;
 		s_registers[type2][type1].destroyFcn = destoryFcn;
+		s_registers[type2][type1].batchFcn = batchFcn;
 		s_registers[type2][type1].primary = false;
 	}
 }
@@ -144,6 +154,8 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_nodeB.other = NULL;
 
 	m_toiCount = 0;
+	m_toiOrder = 0;
+	m_toiIndex = b2_nullQueueIndex;
 
 	m_friction = b2MixFriction(m_fixtureA->m_friction, m_fixtureB->m_friction);
 	m_restitution = b2MixRestitution(m_fixtureA->m_restitution, m_fixtureB->m_restitution);
@@ -153,65 +165,115 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 // Note: do not assume the fixture AABBs are overlapping or are valid.
 void b2Contact::Update(b2ContactListener* listener)
 {
-	b2Manifold oldManifold = m_manifold;
-
-	// Re-enable this contact.
-	m_flags |= e_enabledFlag;
-
-	bool touching = false;
-	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+	b2Manifold manifold;
+	bool touching = ComputeManifold(&manifold);
+	Update(manifold, touching, listener);
+}
 
+bool b2Contact::ComputeManifold(b2Manifold* manifold)
+{
 	bool sensorA = m_fixtureA->IsSensor();
 	bool sensorB = m_fixtureB->IsSensor();
 	bool sensor = sensorA || sensorB;
 
-	b2Body* bodyA = m_fixtureA->GetBody();
-	b2Body* bodyB = m_fixtureB->GetBody();
-	const b2Transform& xfA = bodyA->GetTransform();
-	const b2Transform& xfB = bodyB->GetTransform();
+	const b2Transform& xfA = m_fixtureA->GetBody()->GetTransform();
+	const b2Transform& xfB = m_fixtureB->GetBody()->GetTransform();
 
 	// Is this contact a sensor?
 	if (sensor)
 	{
+		// Sensors don't generate manifolds.
+		*manifold = m_manifold;
+		manifold->pointCount = 0;
+
 		const b2Shape* shapeA = m_fixtureA->GetShape();
 		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+		return b2TestOverlap(shapeA, m_indexA, shapeB, m_indexB, xfA, xfB);
+	}
 
-		// Sensors don't generate manifolds.
-		m_manifold.pointCount = 0;
+	Evaluate(manifold, xfA, xfB);
+	MatchImpulses(manifold);
+
+	return manifold->pointCount > 0;
+}
+
+// The qualified call to T::Evaluate is not virtual.
+template <typename T>
+void b2Contact::EvaluateBatch(b2ContactUpdate* const* updates, int32 count)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2ContactUpdate* update = updates[i];
+		T* contact = (T*)update->contact;
+
+		const b2Transform& xfA = contact->m_fixtureA->GetBody()->GetTransform();
+		const b2Transform& xfB = contact->m_fixtureB->GetBody()->GetTransform();
+
+		contact->T::Evaluate(&update->manifold, xfA, xfB);
+		contact->MatchImpulses(&update->manifold);
+		update->touching = update->manifold.pointCount > 0;
 	}
-	else
+}
+
+void b2Contact::ComputeManifolds(b2ContactUpdate* const* updates, int32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	b2Assert(s_initialized == true);
+	b2Shape::Type typeA = updates[0]->contact->GetFixtureA()->GetType();
+	b2Shape::Type typeB = updates[0]->contact->GetFixtureB()->GetType();
+	s_registers[typeA][typeB].batchFcn(updates, count);
+}
+
+void b2Contact::MatchImpulses(b2Manifold* manifold) const
+{
+	// Match old contact ids to new contact ids and copy the
+	// stored impulses to warm start the solver.
+	for (int32 i = 0; i < manifold->pointCount; ++i)
 	{
-		Evaluate(&m_manifold, xfA, xfB);
-		touching = m_manifold.pointCount > 0;
+		b2ManifoldPoint* mp2 = manifold->points + i;
+		mp2->normalImpulse = 0.0f;
+		mp2->tangentImpulse = 0.0f;
+		b2ContactID id2 = mp2->id;
 
-		// Match old contact ids to new contact ids and copy the
-		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
+		for (int32 j = 0; j < m_manifold.pointCount; ++j)
 		{
-			b2ManifoldPoint* mp2 = m_manifold.points + i;
-			mp2->normalImpulse = 0.0f;
-			mp2->tangentImpulse = 0.0f;
-			b2ContactID id2 = mp2->id;
+			const b2ManifoldPoint* mp1 = m_manifold.points + j;
 
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
+			if (mp1->id.key == id2.key)
 			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
-
-				if (mp1->id.key == id2.key)
-				{
-					mp2->normalImpulse = mp1->normalImpulse;
-					mp2->tangentImpulse = mp1->tangentImpulse;
-					break;
-				}
+				mp2->normalImpulse = mp1->normalImpulse;
+				mp2->tangentImpulse = mp1->tangentImpulse;
+				break;
 			}
 		}
+	}
+}
 
-		if (touching != wasTouching)
-		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
-		}
+void b2Contact::Update(const b2Manifold& manifold, bool touching, b2ContactListener* listener)
+{
+	b2Manifold oldManifold = m_manifold;
+	m_manifold = manifold;
+
+	// Re-enable this contact.
+	m_flags |= e_enabledFlag;
+
+	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+
+	bool sensorA = m_fixtureA->IsSensor();
+	bool sensorB = m_fixtureB->IsSensor();
+	bool sensor = sensorA || sensorB;
+
+	b2Body* bodyA = m_fixtureA->GetBody();
+	b2Body* bodyB = m_fixtureB->GetBody();
+
+	if (sensor == false && touching != wasTouching)
+	{
+		bodyA->SetAwake(true);
+		bodyB->SetAwake(true);
 	}
 
 	if (touching)
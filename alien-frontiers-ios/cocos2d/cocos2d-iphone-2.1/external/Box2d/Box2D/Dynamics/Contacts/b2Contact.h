@@ -51,10 +51,22 @@ typedef b2Contact* b2ContactCreateFcn(	b2Fixture* fixtureA, int32 indexA,
 										b2BlockAllocator* allocator);
 typedef void b2ContactDestroyFcn(b2Contact* contact, b2BlockAllocator* allocator);
 
+/// A manifold computed ahead of updating a contact.
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2Manifold manifold;
+	bool touching;
+};
+
+/// Computes the manifolds of contacts that all have the same contact type.
+typedef void b2ContactBatchFcn(b2ContactUpdate* const* updates, int32 count);
+
 struct b2ContactRegister
 {
 	b2ContactCreateFcn* createFcn;
 	b2ContactDestroyFcn* destroyFcn;
+	b2ContactBatchFcn* batchFcn;
 	bool primary;
 };
 
@@ -144,6 +156,8 @@ protected:
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
+	friend class b2ContactUpdateTask;
+	friend class b2TOIQueue;
 
 	// Flags stored in m_flags
 	enum
@@ -164,14 +178,17 @@ protected:
 		e_bulletHitFlag		= 0x0010,
 
 		// This contact has a valid TOI in m_toi
-		e_toiFlag			= 0x0020
+		e_toiFlag			= 0x0020,
+
+		// This contact is pending in the TOI queue of b2World::SolveTOI
+		e_toiPendingFlag	= 0x0040
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
 	void FlagForFiltering();
 
 	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
-						b2Shape::Type typeA, b2Shape::Type typeB);
+						b2ContactBatchFcn* batchFcn, b2Shape::Type typeA, b2Shape::Type typeB);
 	static void InitializeRegisters();
 	static b2Contact* Create(b2Fixture* fixtureA, int32 indexA, b2Fixture* fixtureB, int32 indexB, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2Shape::Type typeA, b2Shape::Type typeB, b2BlockAllocator* allocator);
@@ -183,6 +200,26 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Compute the new manifold without changing the contact. The impulses are
+	// matched to the current manifold for warm starting. Returns true if the
+	// shapes touch. This may run on several threads at once.
+	bool ComputeManifold(b2Manifold* manifold);
+
+	// Like ComputeManifold for contacts without sensors that all have the shape
+	// types of the first contact. Each contact type is evaluated without
+	// virtual calls, so group contacts by type before calling this.
+	static void ComputeManifolds(b2ContactUpdate* const* updates, int32 count);
+
+	template <typename T>
+	static void EvaluateBatch(b2ContactUpdate* const* updates, int32 count);
+
+	// Copy the impulses of matching points of the current manifold.
+	void MatchImpulses(b2Manifold* manifold) const;
+
+	// Store a manifold from ComputeManifold, wake the bodies and report the
+	// listener events. Update is ComputeManifold followed by this.
+	void Update(const b2Manifold& manifold, bool touching, b2ContactListener* listener);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
@@ -202,11 +239,18 @@ protected:
 	int32 m_indexA;
 	int32 m_indexB;
 
+	// Key of the proxy pair in b2ContactManager::m_pairSet.
+	uint64 m_pairKey;
+
 	b2Manifold m_manifold;
 
 	int32 m_toiCount;
 	float32 m_toi;
 
+	// The position in the contact list and in the b2TOIQueue during b2World::SolveTOI.
+	int32 m_toiOrder;
+	int32 m_toiIndex;
+
 	float32 m_friction;
 	float32 m_restitution;
 };
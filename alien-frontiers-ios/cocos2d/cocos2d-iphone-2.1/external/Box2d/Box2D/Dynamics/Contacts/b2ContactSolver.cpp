@@ -23,6 +23,9 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Dynamics/b2WideSolver.h>
+
+#include <cstring>
 
 #define B2_DEBUG_SOLVER 0
 
@@ -41,6 +44,41 @@ struct b2ContactPositionConstraint
 	int32 pointCount;
 };
 
+// Wide solver
+//
+// The wide solver packs four position constraints into the lanes of a batch and
+// solves them together with SIMD math. The math is the same as the scalar solver
+// below. The lanes of a batch must not share a moving body, so the constraints
+// are colored first and each batch takes its constraints from a single color. The
+// batches of a color are independent, so solving them in sequence is the same as
+// solving the constraints one at a time in a different order.
+//
+// The velocity constraints always use the scalar solver. Stacks only stay standing
+// when their contacts are solved in island order, and in that order a tall stack
+// puts one contact in each batch.
+
+// Islands with fewer contacts use the scalar solver.
+const int32 b2_wideMinContacts = 2 * b2_simdWidth;
+
+// Face B manifolds are stored as face A manifolds with the bodies swapped.
+struct b2ContactPositionConstraintW
+{
+	float32 localPointsX[b2_maxManifoldPoints][4];
+	float32 localPointsY[b2_maxManifoldPoints][4];
+	float32 pointMask[b2_maxManifoldPoints][4];
+	float32 localNormalX[4], localNormalY[4];
+	float32 localPointX[4], localPointY[4];
+	float32 localCenterAx[4], localCenterAy[4];
+	float32 localCenterBx[4], localCenterBy[4];
+	float32 invMassA[4], invMassB[4];
+	float32 invIA[4], invIB[4];
+	float32 radius[4];
+	int32 indexA[4];
+	int32 indexB[4];
+	int32 pointCount;
+	bool circles;
+};
+
 b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 {
 	m_step = def->step;
@@ -52,6 +90,11 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 	m_velocities = def->velocities;
 	m_contacts = def->contacts;
 
+	m_wide = false;
+	m_colors = NULL;
+	m_positionBatches = NULL;
+	m_positionBatchCount = 0;
+
 	// Initialize position independent portions of the constraints.
 	for (int32 i = 0; i < m_count; ++i)
 	{
@@ -129,6 +172,12 @@ b2ContactSolver::b2ContactSolver(b2ContactSolverDef* def)
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_wide)
+	{
+		m_allocator->Free(m_positionBatches);
+		m_allocator->Free(m_colors);
+	}
+
 	m_allocator->Free(m_velocityConstraints);
 	m_allocator->Free(m_positionConstraints);
 }
@@ -243,6 +292,11 @@ void b2ContactSolver::InitializeVelocityConstraints()
 			}
 		}
 	}
+
+	if (m_step.wideContactSolver && m_count >= b2_wideMinContacts)
+	{
+		PrepareWide();
+	}
 }
 
 void b2ContactSolver::WarmStart()
@@ -664,6 +718,11 @@ struct b2PositionSolverManifold
 // Sequential solver.
 bool b2ContactSolver::SolvePositionConstraints()
 {
+	if (m_wide)
+	{
+		return SolvePositionConstraintsWide();
+	}
+
 	float32 minSeparation = 0.0f;
 
 	for (int32 i = 0; i < m_count; ++i)
@@ -830,3 +889,310 @@ bool b2ContactSolver::SolveTOIPositionConstraints(int32 toiIndexA, int32 toiInde
 	// push the separation above -b2_linearSlop.
 	return minSeparation >= -1.5f * b2_linearSlop;
 }
+
+// Count the batches of each group and return the total. Group g holds the
+// constraints of color g / 2. Overflow groups have one constraint per batch.
+static int32 b2CountBatches(int32* batchStarts, const int32* groupCounts, int32 groupCount)
+{
+	int32 batchCount = 0;
+	for (int32 g = 0; g < groupCount; ++g)
+	{
+		batchStarts[g] = batchCount;
+		if (g / 2 == b2_wideOverflowColor)
+		{
+			batchCount += groupCounts[g];
+		}
+		else
+		{
+			batchCount += (groupCounts[g] + b2_simdWidth - 1) / b2_simdWidth;
+		}
+	}
+	return batchCount;
+}
+
+// Find the batch and lane of the k-th constraint in group g.
+static inline void b2GetBatchLane(int32* batch, int32* lane, const int32* batchStarts, int32 g, int32 k)
+{
+	if (g / 2 == b2_wideOverflowColor)
+	{
+		*batch = batchStarts[g] + k;
+		*lane = 0;
+	}
+	else
+	{
+		*batch = batchStarts[g] + k / b2_simdWidth;
+		*lane = k % b2_simdWidth;
+	}
+}
+
+// Pack the position constraints into batches.
+void b2ContactSolver::PrepareWide()
+{
+	b2Assert(m_wide == false);
+
+	const int32 groupCount = 2 * (b2_wideColorCount + 1);
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyCount = b2Max(bodyCount, b2Max(vc->indexA, vc->indexB) + 1);
+	}
+
+	m_colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+
+	// Greedy coloring of the position constraints in constraint order. Bodies
+	// with infinite mass are not moved by contacts, so any number of lanes may
+	// share them. The indices can be sparse when the island uses the world body
+	// state, so only the entries in use are cleared.
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bodyColors[vc->indexA] = 0;
+		bodyColors[vc->indexB] = 0;
+	}
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = m_velocityConstraints + i;
+		bool movesA = vc->invMassA > 0.0f;
+		bool movesB = vc->invMassB > 0.0f;
+
+		uint32 used = 0;
+		if (movesA)
+		{
+			used |= bodyColors[vc->indexA];
+		}
+		if (movesB)
+		{
+			used |= bodyColors[vc->indexB];
+		}
+
+		int32 color = b2_wideOverflowColor;
+		for (int32 c = 0; c < b2_wideColorCount; ++c)
+		{
+			if ((used & (1u << c)) == 0)
+			{
+				color = c;
+				break;
+			}
+		}
+
+		if (color != b2_wideOverflowColor)
+		{
+			if (movesA)
+			{
+				bodyColors[vc->indexA] |= 1u << color;
+			}
+			if (movesB)
+			{
+				bodyColors[vc->indexB] |= 1u << color;
+			}
+		}
+
+		m_colors[i] = color;
+	}
+
+	m_allocator->Free(bodyColors);
+
+	// Position batches are grouped by manifold type.
+	int32 positionCounts[groupCount];
+	memset(positionCounts, 0, sizeof(positionCounts));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 color = m_colors[i];
+		++positionCounts[2 * color + (m_positionConstraints[i].type == b2Manifold::e_circles ? 1 : 0)];
+	}
+
+	int32 positionStarts[groupCount];
+	m_positionBatchCount = b2CountBatches(positionStarts, positionCounts, groupCount);
+
+	m_positionBatches = (b2ContactPositionConstraintW*)m_allocator->Allocate(m_positionBatchCount * sizeof(b2ContactPositionConstraintW));
+
+	// Start with empty lanes.
+	memset(m_positionBatches, 0, m_positionBatchCount * sizeof(b2ContactPositionConstraintW));
+	for (int32 i = 0; i < m_positionBatchCount; ++i)
+	{
+		b2ContactPositionConstraintW* c = m_positionBatches + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			c->indexA[j] = -1;
+			c->indexB[j] = -1;
+		}
+	}
+
+	memset(positionCounts, 0, sizeof(positionCounts));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		const b2ContactPositionConstraint* pc = m_positionConstraints + i;
+		bool circles = pc->type == b2Manifold::e_circles;
+		int32 pg = 2 * m_colors[i] + (circles ? 1 : 0);
+		int32 batch, lane;
+		b2GetBatchLane(&batch, &lane, positionStarts, pg, positionCounts[pg]++);
+
+		b2ContactPositionConstraintW* pw = m_positionBatches + batch;
+		pw->circles = circles;
+		pw->pointCount = b2Max(pw->pointCount, pc->pointCount);
+
+		bool swap = pc->type == b2Manifold::e_faceB;
+		pw->indexA[lane] = swap ? pc->indexB : pc->indexA;
+		pw->indexB[lane] = swap ? pc->indexA : pc->indexB;
+		pw->invMassA[lane] = swap ? pc->invMassB : pc->invMassA;
+		pw->invMassB[lane] = swap ? pc->invMassA : pc->invMassB;
+		pw->invIA[lane] = swap ? pc->invIB : pc->invIA;
+		pw->invIB[lane] = swap ? pc->invIA : pc->invIB;
+
+		b2Vec2 localCenterA = swap ? pc->localCenterB : pc->localCenterA;
+		b2Vec2 localCenterB = swap ? pc->localCenterA : pc->localCenterB;
+		pw->localCenterAx[lane] = localCenterA.x;
+		pw->localCenterAy[lane] = localCenterA.y;
+		pw->localCenterBx[lane] = localCenterB.x;
+		pw->localCenterBy[lane] = localCenterB.y;
+		pw->localNormalX[lane] = pc->localNormal.x;
+		pw->localNormalY[lane] = pc->localNormal.y;
+		pw->localPointX[lane] = pc->localPoint.x;
+		pw->localPointY[lane] = pc->localPoint.y;
+		pw->radius[lane] = pc->radiusA + pc->radiusB;
+
+		for (int32 j = 0; j < pc->pointCount; ++j)
+		{
+			pw->localPointsX[j][lane] = pc->localPoints[j].x;
+			pw->localPointsY[j][lane] = pc->localPoints[j].y;
+			pw->pointMask[j][lane] = 1.0f;
+		}
+	}
+
+	m_wide = true;
+}
+
+bool b2ContactSolver::SolvePositionConstraintsWide()
+{
+	b2FloatW zero = b2ZeroW();
+	b2FloatW minSeparation = zero;
+
+	b2FloatW baumgarte = b2SplatW(b2_baumgarte);
+	b2FloatW linearSlop = b2SplatW(b2_linearSlop);
+	b2FloatW maxCorrection = b2SplatW(-b2_maxLinearCorrection);
+	b2FloatW epsilon = b2SplatW(b2_epsilon);
+	b2FloatW half = b2SplatW(0.5f);
+	b2FloatW one = b2SplatW(1.0f);
+
+	for (int32 i = 0; i < m_positionBatchCount; ++i)
+	{
+		b2ContactPositionConstraintW* c = m_positionBatches + i;
+
+		b2FloatW cAx, cAy, aA, cBx, cBy, aB;
+		b2GatherPositions(&cAx, &cAy, &aA, m_positions, c->indexA);
+		b2GatherPositions(&cBx, &cBy, &aB, m_positions, c->indexB);
+
+		b2FloatW mA = b2LoadW(c->invMassA);
+		b2FloatW iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB);
+		b2FloatW iB = b2LoadW(c->invIB);
+		b2FloatW localCenterAx = b2LoadW(c->localCenterAx);
+		b2FloatW localCenterAy = b2LoadW(c->localCenterAy);
+		b2FloatW localCenterBx = b2LoadW(c->localCenterBx);
+		b2FloatW localCenterBy = b2LoadW(c->localCenterBy);
+		b2FloatW localPointX = b2LoadW(c->localPointX);
+		b2FloatW localPointY = b2LoadW(c->localPointY);
+		b2FloatW radius = b2LoadW(c->radius);
+
+		// Solve normal constraints
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2FloatW sA, cosA, sB, cosB;
+			b2SinCosW(&sA, &cosA, aA);
+			b2SinCosW(&sB, &cosB, aB);
+
+			b2FloatW pAx = b2SubW(cAx, b2SubW(b2MulW(cosA, localCenterAx), b2MulW(sA, localCenterAy)));
+			b2FloatW pAy = b2SubW(cAy, b2AddW(b2MulW(sA, localCenterAx), b2MulW(cosA, localCenterAy)));
+			b2FloatW pBx = b2SubW(cBx, b2SubW(b2MulW(cosB, localCenterBx), b2MulW(sB, localCenterBy)));
+			b2FloatW pBy = b2SubW(cBy, b2AddW(b2MulW(sB, localCenterBx), b2MulW(cosB, localCenterBy)));
+
+			b2FloatW localX = b2LoadW(c->localPointsX[j]);
+			b2FloatW localY = b2LoadW(c->localPointsY[j]);
+
+			b2FloatW normalX, normalY, pointX, pointY, separation;
+			if (c->circles)
+			{
+				b2FloatW pointAx = b2AddW(b2SubW(b2MulW(cosA, localPointX), b2MulW(sA, localPointY)), pAx);
+				b2FloatW pointAy = b2AddW(b2AddW(b2MulW(sA, localPointX), b2MulW(cosA, localPointY)), pAy);
+				b2FloatW pointBx = b2AddW(b2SubW(b2MulW(cosB, localX), b2MulW(sB, localY)), pBx);
+				b2FloatW pointBy = b2AddW(b2AddW(b2MulW(sB, localX), b2MulW(cosB, localY)), pBy);
+
+				// Normalize like b2Vec2::Normalize, which leaves short vectors alone.
+				b2FloatW dx = b2SubW(pointBx, pointAx);
+				b2FloatW dy = b2SubW(pointBy, pointAy);
+				b2FloatW length = b2SqrtW(b2DotW(dx, dy, dx, dy));
+				b2FloatW longEnough = b2GreaterEqualW(length, epsilon);
+				b2FloatW invLength = b2DivW(one, b2BlendW(longEnough, length, one));
+				normalX = b2BlendW(longEnough, b2MulW(dx, invLength), dx);
+				normalY = b2BlendW(longEnough, b2MulW(dy, invLength), dy);
+
+				pointX = b2MulW(half, b2AddW(pointAx, pointBx));
+				pointY = b2MulW(half, b2AddW(pointAy, pointBy));
+				separation = b2SubW(b2DotW(dx, dy, normalX, normalY), radius);
+			}
+			else
+			{
+				b2FloatW localNormalX = b2LoadW(c->localNormalX);
+				b2FloatW localNormalY = b2LoadW(c->localNormalY);
+				normalX = b2SubW(b2MulW(cosA, localNormalX), b2MulW(sA, localNormalY));
+				normalY = b2AddW(b2MulW(sA, localNormalX), b2MulW(cosA, localNormalY));
+
+				b2FloatW planePointX = b2AddW(b2SubW(b2MulW(cosA, localPointX), b2MulW(sA, localPointY)), pAx);
+				b2FloatW planePointY = b2AddW(b2AddW(b2MulW(sA, localPointX), b2MulW(cosA, localPointY)), pAy);
+
+				pointX = b2AddW(b2SubW(b2MulW(cosB, localX), b2MulW(sB, localY)), pBx);
+				pointY = b2AddW(b2AddW(b2MulW(sB, localX), b2MulW(cosB, localY)), pBy);
+				separation = b2SubW(b2DotW(b2SubW(pointX, planePointX), b2SubW(pointY, planePointY), normalX, normalY), radius);
+			}
+
+			b2FloatW active = b2GreaterW(b2LoadW(c->pointMask[j]), zero);
+
+			b2FloatW rAx = b2SubW(pointX, cAx);
+			b2FloatW rAy = b2SubW(pointY, cAy);
+			b2FloatW rBx = b2SubW(pointX, cBx);
+			b2FloatW rBy = b2SubW(pointY, cBy);
+
+			// Track max constraint error.
+			minSeparation = b2MinW(minSeparation, b2BlendW(active, separation, zero));
+
+			// Prevent large corrections and allow slop.
+			b2FloatW C = b2MaxW(maxCorrection, b2MinW(b2MulW(baumgarte, b2AddW(separation, linearSlop)), zero));
+
+			// Compute the effective mass.
+			b2FloatW rnA = b2CrossW(rAx, rAy, normalX, normalY);
+			b2FloatW rnB = b2CrossW(rBx, rBy, normalX, normalY);
+			b2FloatW K = b2AddW(b2AddW(mA, mB), b2AddW(b2MulW(b2MulW(iA, rnA), rnA), b2MulW(b2MulW(iB, rnB), rnB)));
+
+			// Compute normal impulse
+			b2FloatW solvable = b2AndW(active, b2GreaterW(K, zero));
+			b2FloatW impulse = b2DivW(b2SubW(zero, C), b2BlendW(solvable, K, one));
+			impulse = b2BlendW(solvable, impulse, zero);
+
+			b2FloatW Px = b2MulW(impulse, normalX);
+			b2FloatW Py = b2MulW(impulse, normalY);
+
+			cAx = b2SubW(cAx, b2MulW(mA, Px));
+			cAy = b2SubW(cAy, b2MulW(mA, Py));
+			aA = b2SubW(aA, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+			cBx = b2AddW(cBx, b2MulW(mB, Px));
+			cBy = b2AddW(cBy, b2MulW(mB, Py));
+			aB = b2AddW(aB, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+		}
+
+		b2ScatterPositions(m_positions, c->indexA, cAx, cAy, aA);
+		b2ScatterPositions(m_positions, c->indexB, cBx, cBy, aB);
+	}
+
+	float32 separations[4];
+	b2StoreW(separations, minSeparation);
+	float32 s = b2Min(b2Min(separations[0], separations[1]), b2Min(separations[2], separations[3]));
+
+	// We can't expect minSpeparation >= -b2_linearSlop because we don't
+	// push the separation above -b2_linearSlop.
+	return s >= -3.0f * b2_linearSlop;
+}
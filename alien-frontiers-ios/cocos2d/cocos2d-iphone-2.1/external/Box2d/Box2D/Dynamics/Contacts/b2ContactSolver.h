@@ -27,6 +27,7 @@ class b2Contact;
 class b2Body;
 class b2StackAllocator;
 struct b2ContactPositionConstraint;
+struct b2ContactPositionConstraintW;
 
 struct b2VelocityConstraintPoint
 {
@@ -80,6 +81,9 @@ public:
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	void PrepareWide();
+	bool SolvePositionConstraintsWide();
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -88,6 +92,12 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+	// The wide solver packs four position constraints into each batch.
+	bool m_wide;
+	int32* m_colors;
+	b2ContactPositionConstraintW* m_positionBatches;
+	int32 m_positionBatchCount;
 };
 
 #endif
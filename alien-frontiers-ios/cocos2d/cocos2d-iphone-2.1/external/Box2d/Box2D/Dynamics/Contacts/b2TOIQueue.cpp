@@ -0,0 +1,196 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2TOIQueue.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <algorithm>
+#include <cstring>
+
+b2TOIQueue::b2TOIQueue()
+{
+	m_heapCapacity = 64;
+	m_heapCount = 0;
+	m_heap = (b2Contact**)b2Alloc(m_heapCapacity * sizeof(b2Contact*));
+
+	m_pendingCapacity = 64;
+	m_pendingCount = 0;
+	m_pending = (b2Contact**)b2Alloc(m_pendingCapacity * sizeof(b2Contact*));
+}
+
+b2TOIQueue::~b2TOIQueue()
+{
+	ClearPending();
+
+	for (int32 i = 0; i < m_heapCount; ++i)
+	{
+		m_heap[i]->m_toiIndex = b2_nullQueueIndex;
+	}
+
+	b2Free(m_pending);
+	b2Free(m_heap);
+}
+
+inline bool b2TOIQueue::Less(const b2Contact* a, const b2Contact* b) const
+{
+	if (a->m_toi != b->m_toi)
+	{
+		return a->m_toi < b->m_toi;
+	}
+
+	return a->m_toiOrder < b->m_toiOrder;
+}
+
+inline void b2TOIQueue::Place(int32 index, b2Contact* contact)
+{
+	m_heap[index] = contact;
+	contact->m_toiIndex = index;
+}
+
+void b2TOIQueue::SiftUp(int32 index)
+{
+	b2Contact* contact = m_heap[index];
+	while (index > 0)
+	{
+		int32 parent = (index - 1) >> 1;
+		if (Less(contact, m_heap[parent]) == false)
+		{
+			break;
+		}
+
+		Place(index, m_heap[parent]);
+		index = parent;
+	}
+
+	Place(index, contact);
+}
+
+void b2TOIQueue::SiftDown(int32 index)
+{
+	b2Contact* contact = m_heap[index];
+	for (;;)
+	{
+		int32 child = 2 * index + 1;
+		if (child >= m_heapCount)
+		{
+			break;
+		}
+
+		if (child + 1 < m_heapCount && Less(m_heap[child + 1], m_heap[child]))
+		{
+			++child;
+		}
+
+		if (Less(m_heap[child], contact) == false)
+		{
+			break;
+		}
+
+		Place(index, m_heap[child]);
+		index = child;
+	}
+
+	Place(index, contact);
+}
+
+void b2TOIQueue::Push(b2Contact* contact)
+{
+	b2Assert(contact->m_toiIndex == b2_nullQueueIndex);
+
+	if (m_heapCount == m_heapCapacity)
+	{
+		b2Contact** oldHeap = m_heap;
+		m_heapCapacity *= 2;
+		m_heap = (b2Contact**)b2Alloc(m_heapCapacity * sizeof(b2Contact*));
+		memcpy(m_heap, oldHeap, m_heapCount * sizeof(b2Contact*));
+		b2Free(oldHeap);
+	}
+
+	m_heap[m_heapCount] = contact;
+	++m_heapCount;
+	SiftUp(m_heapCount - 1);
+}
+
+void b2TOIQueue::Remove(b2Contact* contact)
+{
+	int32 index = contact->m_toiIndex;
+	if (index == b2_nullQueueIndex)
+	{
+		return;
+	}
+
+	b2Assert(0 <= index && index < m_heapCount && m_heap[index] == contact);
+	contact->m_toiIndex = b2_nullQueueIndex;
+
+	--m_heapCount;
+	if (index == m_heapCount)
+	{
+		return;
+	}
+
+	// Move the last contact into the hole and restore the heap order.
+	Place(index, m_heap[m_heapCount]);
+	if (index > 0 && Less(m_heap[index], m_heap[(index - 1) >> 1]))
+	{
+		SiftUp(index);
+	}
+	else
+	{
+		SiftDown(index);
+	}
+}
+
+void b2TOIQueue::AddPending(b2Contact* contact)
+{
+	if (contact->m_flags & b2Contact::e_toiPendingFlag)
+	{
+		return;
+	}
+
+	if (m_pendingCount == m_pendingCapacity)
+	{
+		b2Contact** oldPending = m_pending;
+		m_pendingCapacity *= 2;
+		m_pending = (b2Contact**)b2Alloc(m_pendingCapacity * sizeof(b2Contact*));
+		memcpy(m_pending, oldPending, m_pendingCount * sizeof(b2Contact*));
+		b2Free(oldPending);
+	}
+
+	contact->m_flags |= b2Contact::e_toiPendingFlag;
+	m_pending[m_pendingCount] = contact;
+	++m_pendingCount;
+}
+
+bool b2TOIQueue::ListOrder(const b2Contact* a, const b2Contact* b)
+{
+	return a->m_toiOrder < b->m_toiOrder;
+}
+
+void b2TOIQueue::SortPending()
+{
+	std::sort(m_pending, m_pending + m_pendingCount, ListOrder);
+}
+
+void b2TOIQueue::ClearPending()
+{
+	for (int32 i = 0; i < m_pendingCount; ++i)
+	{
+		m_pending[i]->m_flags &= ~b2Contact::e_toiPendingFlag;
+	}
+
+	m_pendingCount = 0;
+}
@@ -0,0 +1,93 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TOI_QUEUE_H
+#define B2_TOI_QUEUE_H
+
+#include <Box2D/Common/b2Settings.h>
+
+class b2Contact;
+
+/// The queue index of a contact that is not in the queue.
+const int32 b2_nullQueueIndex = -1;
+
+/// A binary heap of contacts ordered by their cached time of impact, used by
+/// b2World::SolveTOI. Contacts with the same time of impact are ordered by their
+/// position in the contact list, so the minimum is the contact that a scan of the
+/// list would find. The queue also collects the pending contacts that have to be
+/// looked at again before the next minimum is taken.
+class b2TOIQueue
+{
+public:
+	b2TOIQueue();
+	~b2TOIQueue();
+
+	/// Add a contact that is not in the queue.
+	void Push(b2Contact* contact);
+
+	/// Remove a contact if it is in the queue.
+	void Remove(b2Contact* contact);
+
+	/// Get the contact with the smallest time of impact, or NULL if the queue is empty.
+	b2Contact* GetMin() const;
+
+	/// Add a contact to the pending contacts, unless it is there already.
+	void AddPending(b2Contact* contact);
+
+	/// Sort the pending contacts in list order.
+	void SortPending();
+
+	int32 GetPendingCount() const;
+	b2Contact* GetPending(int32 index) const;
+
+	/// Forget the pending contacts.
+	void ClearPending();
+
+private:
+	bool Less(const b2Contact* a, const b2Contact* b) const;
+	static bool ListOrder(const b2Contact* a, const b2Contact* b);
+	void Place(int32 index, b2Contact* contact);
+	void SiftUp(int32 index);
+	void SiftDown(int32 index);
+
+	b2Contact** m_heap;
+	int32 m_heapCount;
+	int32 m_heapCapacity;
+
+	b2Contact** m_pending;
+	int32 m_pendingCount;
+	int32 m_pendingCapacity;
+};
+
+inline b2Contact* b2TOIQueue::GetMin() const
+{
+	return m_heapCount > 0 ? m_heap[0] : NULL;
+}
+
+inline int32 b2TOIQueue::GetPendingCount() const
+{
+	return m_pendingCount;
+}
+
+inline b2Contact* b2TOIQueue::GetPending(int32 index) const
+{
+	b2Assert(0 <= index && index < m_pendingCount);
+	return m_pending[index];
+}
+
+#endif
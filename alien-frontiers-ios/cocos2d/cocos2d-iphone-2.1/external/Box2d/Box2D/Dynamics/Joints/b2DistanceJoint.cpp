@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -258,3 +259,23 @@ void b2DistanceJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2DistanceJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_length);
+	snapshot->Write(m_frequencyHz);
+	snapshot->Write(m_dampingRatio);
+	snapshot->Write(m_impulse);
+}
+
+void b2DistanceJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_length);
+	reader->Read(&m_frequencyHz);
+	reader->Read(&m_dampingRatio);
+	reader->Read(&m_impulse);
+}
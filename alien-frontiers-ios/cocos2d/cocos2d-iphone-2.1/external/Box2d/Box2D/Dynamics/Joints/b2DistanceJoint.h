@@ -104,12 +104,17 @@ public:
 protected:
 
 	friend class b2Joint;
+	friend class b2JointSolver;
+
 	b2DistanceJoint(const b2DistanceJointDef* data);
 
 	void InitVelocityConstraints(const b2SolverData& data);
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2Snapshot* snapshot) const;
+	void LoadState(b2SnapshotReader* reader);
+
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
 	float32 m_bias;
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -249,3 +250,23 @@ void b2FrictionJoint::Dump()
 	b2Log("  jd.maxTorque = %.15lef;\n", m_maxTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2FrictionJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_maxForce);
+	snapshot->Write(m_maxTorque);
+	snapshot->Write(m_linearImpulse);
+	snapshot->Write(m_angularImpulse);
+}
+
+void b2FrictionJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_maxForce);
+	reader->Read(&m_maxTorque);
+	reader->Read(&m_linearImpulse);
+	reader->Read(&m_angularImpulse);
+}
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
@@ -421,3 +422,33 @@ void b2GearJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2GearJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_localAnchorC);
+	snapshot->Write(m_localAnchorD);
+	snapshot->Write(m_localAxisC);
+	snapshot->Write(m_localAxisD);
+	snapshot->Write(m_referenceAngleA);
+	snapshot->Write(m_referenceAngleB);
+	snapshot->Write(m_constant);
+	snapshot->Write(m_ratio);
+	snapshot->Write(m_impulse);
+}
+
+void b2GearJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_localAnchorC);
+	reader->Read(&m_localAnchorD);
+	reader->Read(&m_localAxisC);
+	reader->Read(&m_localAxisD);
+	reader->Read(&m_referenceAngleA);
+	reader->Read(&m_referenceAngleB);
+	reader->Read(&m_constant);
+	reader->Read(&m_ratio);
+	reader->Read(&m_impulse);
+}
@@ -30,6 +30,7 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 #include <new>
 
@@ -168,6 +169,115 @@ void b2Joint::Destroy(b2Joint* joint, b2BlockAllocator* allocator)
 	}
 }
 
+void b2Joint::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_type);
+	snapshot->Write(m_bodyA->m_islandIndex);
+	snapshot->Write(m_bodyB->m_islandIndex);
+	snapshot->Write(m_collideConnected);
+	snapshot->Write(m_userData);
+
+	if (m_type == e_gearJoint)
+	{
+		const b2GearJoint* gear = (const b2GearJoint*)this;
+		snapshot->Write(gear->m_joint1->m_index);
+		snapshot->Write(gear->m_joint2->m_index);
+	}
+
+	SaveState(snapshot);
+}
+
+b2Joint* b2Joint::Load(b2SnapshotReader* reader, b2Body** bodies, b2Joint** joints, b2BlockAllocator* allocator)
+{
+	b2JointType type;
+	int32 indexA, indexB;
+	bool collideConnected;
+	void* userData;
+	reader->Read(&type);
+	reader->Read(&indexA);
+	reader->Read(&indexB);
+	reader->Read(&collideConnected);
+	reader->Read(&userData);
+
+	// The joint is constructed from a default definition and then
+	// overwritten by LoadState.
+	b2DistanceJointDef distanceDef;
+	b2MouseJointDef mouseDef;
+	b2PrismaticJointDef prismaticDef;
+	b2RevoluteJointDef revoluteDef;
+	b2PulleyJointDef pulleyDef;
+	b2GearJointDef gearDef;
+	b2WheelJointDef wheelDef;
+	b2WeldJointDef weldDef;
+	b2FrictionJointDef frictionDef;
+	b2RopeJointDef ropeDef;
+
+	b2JointDef* def = NULL;
+	switch (type)
+	{
+	case e_distanceJoint:
+		def = &distanceDef;
+		break;
+
+	case e_mouseJoint:
+		def = &mouseDef;
+		break;
+
+	case e_prismaticJoint:
+		def = &prismaticDef;
+		break;
+
+	case e_revoluteJoint:
+		def = &revoluteDef;
+		break;
+
+	case e_pulleyJoint:
+		def = &pulleyDef;
+		break;
+
+	case e_gearJoint:
+		{
+			// Gear joints are saved after the joints they connect.
+			int32 index1, index2;
+			reader->Read(&index1);
+			reader->Read(&index2);
+			gearDef.joint1 = joints[index1];
+			gearDef.joint2 = joints[index2];
+			def = &gearDef;
+		}
+		break;
+
+	case e_wheelJoint:
+		def = &wheelDef;
+		break;
+
+	case e_weldJoint:
+		def = &weldDef;
+		break;
+
+	case e_frictionJoint:
+		def = &frictionDef;
+		break;
+
+	case e_ropeJoint:
+		def = &ropeDef;
+		break;
+
+	default:
+		b2Assert(false);
+		return NULL;
+	}
+
+	def->bodyA = bodies[indexA];
+	def->bodyB = bodies[indexB];
+	def->collideConnected = collideConnected;
+	def->userData = userData;
+
+	b2Joint* joint = Create(def, allocator);
+	joint->LoadState(reader);
+	return joint;
+}
+
 b2Joint::b2Joint(const b2JointDef* def)
 {
 	b2Assert(def->bodyA != def->bodyB);
@@ -25,6 +25,8 @@ class b2Body;
 class b2Joint;
 struct b2SolverData;
 class b2BlockAllocator;
+class b2Snapshot;
+class b2SnapshotReader;
 
 enum b2JointType
 {
@@ -149,11 +151,18 @@ protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend class b2JointSolver;
 	friend class b2GearJoint;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
 
+	// These support b2World::Save and b2World::Restore. Bodies and joints are
+	// referred to by their m_islandIndex and m_index, which the world assigns.
+	// Load does not link the joint.
+	void Save(b2Snapshot* snapshot) const;
+	static b2Joint* Load(b2SnapshotReader* reader, b2Body** bodies, b2Joint** joints, b2BlockAllocator* allocator);
+
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
@@ -163,6 +172,11 @@ protected:
 	// This returns true if the position errors are within tolerance.
 	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
+	// Write and read the state of the concrete joint. Solver temporaries are
+	// rebuilt by InitVelocityConstraints and are not saved.
+	virtual void SaveState(b2Snapshot* snapshot) const = 0;
+	virtual void LoadState(b2SnapshotReader* reader) = 0;
+
 	b2JointType m_type;
 	b2Joint* m_prev;
 	b2Joint* m_next;
@@ -0,0 +1,745 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Joints/b2JointSolver.h>
+
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Dynamics/b2WideSolver.h>
+
+#include <cstring>
+
+// Wide solver
+//
+// Joints of different types share no solver code, so the scalar solver pays for
+// a virtual call and a cold code path on each joint. The wide solver groups the
+// joints of an island by type instead. Revolute joints without an active limit
+// and distance joints are packed four to a batch and solved with SIMD math that
+// follows their SolveVelocityConstraints and SolvePositionConstraints. The lanes
+// of a batch must not share a body, so the joints of each type are colored first
+// and each batch takes its joints from a single color. The other joints are
+// sorted by type and solved one at a time after the batches.
+
+// Islands with fewer joints use the scalar solver.
+const int32 b2_wideMinJoints = 2 * b2_simdWidth;
+
+// Group g holds the joints of wide kind g / b2_wideGroupStride with color
+// g % b2_wideGroupStride. Joints of the overflow color are solved one at a time.
+const int32 b2_wideRevoluteKind = 0;
+const int32 b2_wideDistanceKind = 1;
+const int32 b2_wideKindCount = 2;
+const int32 b2_wideGroupStride = b2_wideColorCount + 1;
+
+// Revolute joints with an inactive limit. The limit is inactive for the whole
+// step once InitVelocityConstraints has run, so only the motor and the point
+// constraint are solved. Lanes without a motor have no motor mass.
+struct b2RevoluteConstraintW
+{
+	float32 localAnchorAx[4], localAnchorAy[4];
+	float32 localAnchorBx[4], localAnchorBy[4];
+	float32 rAx[4], rAy[4];
+	float32 rBx[4], rBy[4];
+	float32 K11[4], K12[4], K21[4], K22[4];
+	float32 invDet[4];
+	float32 motorMass[4];
+	float32 motorSpeed[4];
+	float32 maxMotorImpulse[4];
+	float32 impulseX[4], impulseY[4];
+	float32 motorImpulse[4];
+	float32 invMassA[4], invMassB[4];
+	float32 invIA[4], invIB[4];
+	int32 indexA[4];
+	int32 indexB[4];
+	int32 jointIndex[4];
+};
+
+// Soft lanes have no position correction, so their rigid flag is zero.
+struct b2DistanceConstraintW
+{
+	float32 localAnchorAx[4], localAnchorAy[4];
+	float32 localAnchorBx[4], localAnchorBy[4];
+	float32 rAx[4], rAy[4];
+	float32 rBx[4], rBy[4];
+	float32 ux[4], uy[4];
+	float32 mass[4];
+	float32 bias[4];
+	float32 gamma[4];
+	float32 impulse[4];
+	float32 length[4];
+	float32 rigid[4];
+	float32 invMassA[4], invMassB[4];
+	float32 invIA[4], invIB[4];
+	int32 indexA[4];
+	int32 indexB[4];
+	int32 jointIndex[4];
+};
+
+b2JointSolver::b2JointSolver(b2JointSolverDef* def)
+{
+	m_data.step = def->step;
+	m_data.positions = def->positions;
+	m_data.velocities = def->velocities;
+	m_allocator = def->allocator;
+	m_joints = def->joints;
+	m_count = def->count;
+
+	m_wide = false;
+	m_colors = NULL;
+	m_revoluteBatches = NULL;
+	m_revoluteBatchCount = 0;
+	m_distanceBatches = NULL;
+	m_distanceBatchCount = 0;
+	m_scalarJoints = NULL;
+	m_scalarCount = 0;
+}
+
+b2JointSolver::~b2JointSolver()
+{
+	if (m_wide)
+	{
+		m_allocator->Free(m_scalarJoints);
+		m_allocator->Free(m_distanceBatches);
+		m_allocator->Free(m_revoluteBatches);
+		m_allocator->Free(m_colors);
+	}
+}
+
+// The joints warm start in island order, so the wide solver starts from the same
+// velocities as the scalar solver.
+void b2JointSolver::InitVelocityConstraints()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_joints[i]->InitVelocityConstraints(m_data);
+	}
+
+	if (m_data.step.wideJointSolver && m_count >= b2_wideMinJoints)
+	{
+		PrepareWide();
+	}
+}
+
+void b2JointSolver::SolveVelocityConstraints()
+{
+	if (m_wide)
+	{
+		SolveVelocityConstraintsWide();
+		return;
+	}
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_joints[i]->SolveVelocityConstraints(m_data);
+	}
+}
+
+// Copy the accumulated impulses of the batched joints back to the joints for
+// warm starting and for the reaction forces.
+void b2JointSolver::StoreImpulses()
+{
+	if (m_wide == false)
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_revoluteBatchCount; ++i)
+	{
+		const b2RevoluteConstraintW* c = m_revoluteBatches + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			if (c->jointIndex[j] < 0)
+			{
+				continue;
+			}
+
+			b2RevoluteJoint* joint = (b2RevoluteJoint*)m_joints[c->jointIndex[j]];
+			joint->m_impulse.x = c->impulseX[j];
+			joint->m_impulse.y = c->impulseY[j];
+			joint->m_motorImpulse = c->motorImpulse[j];
+		}
+	}
+
+	for (int32 i = 0; i < m_distanceBatchCount; ++i)
+	{
+		const b2DistanceConstraintW* c = m_distanceBatches + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			if (c->jointIndex[j] < 0)
+			{
+				continue;
+			}
+
+			b2DistanceJoint* joint = (b2DistanceJoint*)m_joints[c->jointIndex[j]];
+			joint->m_impulse = c->impulse[j];
+		}
+	}
+}
+
+bool b2JointSolver::SolvePositionConstraints()
+{
+	if (m_wide)
+	{
+		return SolvePositionConstraintsWide();
+	}
+
+	bool jointsOkay = true;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		bool jointOkay = m_joints[i]->SolvePositionConstraints(m_data);
+		jointsOkay = jointsOkay && jointOkay;
+	}
+
+	return jointsOkay;
+}
+
+// Count the batches of each group of a kind and return the total.
+static int32 b2CountJointBatches(int32* batchStarts, const int32* groupCounts)
+{
+	int32 batchCount = 0;
+	for (int32 color = 0; color < b2_wideColorCount; ++color)
+	{
+		batchStarts[color] = batchCount;
+		batchCount += (groupCounts[color] + b2_simdWidth - 1) / b2_simdWidth;
+	}
+	return batchCount;
+}
+
+// Color the joints and pack them into batches. This must be called after the
+// joints' InitVelocityConstraints because that sets the revolute limit state.
+void b2JointSolver::PrepareWide()
+{
+	b2Assert(m_wide == false);
+
+	const int32 groupCount = b2_wideKindCount * b2_wideGroupStride;
+
+	// Start each wide joint in the overflow color of its kind. Other joints
+	// get -1.
+	m_colors = (int32*)m_allocator->Allocate(m_count * sizeof(int32));
+
+	int32 bodyCount = 0;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+
+		int32 kind = -1;
+		if (joint->m_type == e_revoluteJoint && ((b2RevoluteJoint*)joint)->m_limitState == e_inactiveLimit)
+		{
+			kind = b2_wideRevoluteKind;
+		}
+		else if (joint->m_type == e_distanceJoint)
+		{
+			kind = b2_wideDistanceKind;
+		}
+
+		if (kind == -1)
+		{
+			m_colors[i] = -1;
+			continue;
+		}
+
+		m_colors[i] = kind * b2_wideGroupStride + b2_wideOverflowColor;
+		bodyCount = b2Max(bodyCount, b2Max(joint->m_bodyA->m_islandIndex, joint->m_bodyB->m_islandIndex) + 1);
+	}
+
+	// Greedy coloring in joint order, one kind at a time. Bodies with infinite
+	// mass are not moved by joints, so any number of lanes may share them. The
+	// indices can be sparse when the island uses the world body state, so only
+	// the entries in use are cleared.
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	for (int32 kind = 0; kind < b2_wideKindCount; ++kind)
+	{
+		const int32 uncolored = kind * b2_wideGroupStride + b2_wideOverflowColor;
+
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			if (m_colors[i] == uncolored)
+			{
+				bodyColors[m_joints[i]->m_bodyA->m_islandIndex] = 0;
+				bodyColors[m_joints[i]->m_bodyB->m_islandIndex] = 0;
+			}
+		}
+
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			if (m_colors[i] != uncolored)
+			{
+				continue;
+			}
+
+			const b2Body* bodyA = m_joints[i]->m_bodyA;
+			const b2Body* bodyB = m_joints[i]->m_bodyB;
+			bool movesA = bodyA->m_invMass > 0.0f;
+			bool movesB = bodyB->m_invMass > 0.0f;
+
+			uint32 used = 0;
+			if (movesA)
+			{
+				used |= bodyColors[bodyA->m_islandIndex];
+			}
+			if (movesB)
+			{
+				used |= bodyColors[bodyB->m_islandIndex];
+			}
+
+			for (int32 c = 0; c < b2_wideColorCount; ++c)
+			{
+				if ((used & (1u << c)) == 0)
+				{
+					if (movesA)
+					{
+						bodyColors[bodyA->m_islandIndex] |= 1u << c;
+					}
+					if (movesB)
+					{
+						bodyColors[bodyB->m_islandIndex] |= 1u << c;
+					}
+
+					m_colors[i] = kind * b2_wideGroupStride + c;
+					break;
+				}
+			}
+		}
+	}
+
+	m_allocator->Free(bodyColors);
+
+	// Count the joints of each group and of each type that is solved alone.
+	const int32 typeCount = e_ropeJoint + 1;
+	int32 groupCounts[groupCount];
+	int32 typeCounts[typeCount];
+	memset(groupCounts, 0, sizeof(groupCounts));
+	memset(typeCounts, 0, sizeof(typeCounts));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 g = m_colors[i];
+		if (g == -1 || g % b2_wideGroupStride == b2_wideOverflowColor)
+		{
+			m_colors[i] = -1;
+			++typeCounts[m_joints[i]->m_type];
+			++m_scalarCount;
+		}
+		else
+		{
+			++groupCounts[g];
+		}
+	}
+
+	int32 revoluteStarts[b2_wideColorCount];
+	int32 distanceStarts[b2_wideColorCount];
+	m_revoluteBatchCount = b2CountJointBatches(revoluteStarts, groupCounts + b2_wideRevoluteKind * b2_wideGroupStride);
+	m_distanceBatchCount = b2CountJointBatches(distanceStarts, groupCounts + b2_wideDistanceKind * b2_wideGroupStride);
+
+	m_revoluteBatches = (b2RevoluteConstraintW*)m_allocator->Allocate(m_revoluteBatchCount * sizeof(b2RevoluteConstraintW));
+	m_distanceBatches = (b2DistanceConstraintW*)m_allocator->Allocate(m_distanceBatchCount * sizeof(b2DistanceConstraintW));
+	m_scalarJoints = (int32*)m_allocator->Allocate(m_scalarCount * sizeof(int32));
+
+	// Start with empty lanes.
+	memset(m_revoluteBatches, 0, m_revoluteBatchCount * sizeof(b2RevoluteConstraintW));
+	for (int32 i = 0; i < m_revoluteBatchCount; ++i)
+	{
+		b2RevoluteConstraintW* c = m_revoluteBatches + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			c->indexA[j] = -1;
+			c->indexB[j] = -1;
+			c->jointIndex[j] = -1;
+		}
+	}
+
+	memset(m_distanceBatches, 0, m_distanceBatchCount * sizeof(b2DistanceConstraintW));
+	for (int32 i = 0; i < m_distanceBatchCount; ++i)
+	{
+		b2DistanceConstraintW* c = m_distanceBatches + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			c->indexA[j] = -1;
+			c->indexB[j] = -1;
+			c->jointIndex[j] = -1;
+		}
+	}
+
+	// The joints solved alone keep their island order within each type.
+	int32 typeStarts[typeCount];
+	int32 typeStart = 0;
+	for (int32 i = 0; i < typeCount; ++i)
+	{
+		typeStarts[i] = typeStart;
+		typeStart += typeCounts[i];
+	}
+
+	float32 dt = m_data.step.dt;
+
+	memset(groupCounts, 0, sizeof(groupCounts));
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 g = m_colors[i];
+		if (g == -1)
+		{
+			m_scalarJoints[typeStarts[m_joints[i]->m_type]++] = i;
+			continue;
+		}
+
+		int32 kind = g / b2_wideGroupStride;
+		int32 color = g % b2_wideGroupStride;
+		int32 k = groupCounts[g]++;
+		int32 lane = k % b2_simdWidth;
+
+		if (kind == b2_wideRevoluteKind)
+		{
+			const b2RevoluteJoint* joint = (b2RevoluteJoint*)m_joints[i];
+			b2RevoluteConstraintW* c = m_revoluteBatches + revoluteStarts[color] + k / b2_simdWidth;
+
+			c->indexA[lane] = joint->m_indexA;
+			c->indexB[lane] = joint->m_indexB;
+			c->jointIndex[lane] = i;
+
+			b2Vec2 localAnchorA = joint->m_localAnchorA - joint->m_localCenterA;
+			b2Vec2 localAnchorB = joint->m_localAnchorB - joint->m_localCenterB;
+			c->localAnchorAx[lane] = localAnchorA.x;
+			c->localAnchorAy[lane] = localAnchorA.y;
+			c->localAnchorBx[lane] = localAnchorB.x;
+			c->localAnchorBy[lane] = localAnchorB.y;
+			c->rAx[lane] = joint->m_rA.x;
+			c->rAy[lane] = joint->m_rA.y;
+			c->rBx[lane] = joint->m_rB.x;
+			c->rBy[lane] = joint->m_rB.y;
+
+			// The point constraint uses the upper left block of the mass matrix.
+			const b2Mat33& K = joint->m_mass;
+			float32 det = K.ex.x * K.ey.y - K.ey.x * K.ex.y;
+			c->K11[lane] = K.ex.x;
+			c->K12[lane] = K.ey.x;
+			c->K21[lane] = K.ex.y;
+			c->K22[lane] = K.ey.y;
+			c->invDet[lane] = det != 0.0f ? 1.0f / det : 0.0f;
+
+			bool fixedRotation = (joint->m_invIA + joint->m_invIB == 0.0f);
+			if (joint->m_enableMotor && fixedRotation == false)
+			{
+				c->motorMass[lane] = joint->m_motorMass;
+				c->motorSpeed[lane] = joint->m_motorSpeed;
+				c->maxMotorImpulse[lane] = dt * joint->m_maxMotorTorque;
+			}
+
+			c->impulseX[lane] = joint->m_impulse.x;
+			c->impulseY[lane] = joint->m_impulse.y;
+			c->motorImpulse[lane] = joint->m_motorImpulse;
+			c->invMassA[lane] = joint->m_invMassA;
+			c->invMassB[lane] = joint->m_invMassB;
+			c->invIA[lane] = joint->m_invIA;
+			c->invIB[lane] = joint->m_invIB;
+		}
+		else
+		{
+			const b2DistanceJoint* joint = (b2DistanceJoint*)m_joints[i];
+			b2DistanceConstraintW* c = m_distanceBatches + distanceStarts[color] + k / b2_simdWidth;
+
+			c->indexA[lane] = joint->m_indexA;
+			c->indexB[lane] = joint->m_indexB;
+			c->jointIndex[lane] = i;
+
+			b2Vec2 localAnchorA = joint->m_localAnchorA - joint->m_localCenterA;
+			b2Vec2 localAnchorB = joint->m_localAnchorB - joint->m_localCenterB;
+			c->localAnchorAx[lane] = localAnchorA.x;
+			c->localAnchorAy[lane] = localAnchorA.y;
+			c->localAnchorBx[lane] = localAnchorB.x;
+			c->localAnchorBy[lane] = localAnchorB.y;
+			c->rAx[lane] = joint->m_rA.x;
+			c->rAy[lane] = joint->m_rA.y;
+			c->rBx[lane] = joint->m_rB.x;
+			c->rBy[lane] = joint->m_rB.y;
+			c->ux[lane] = joint->m_u.x;
+			c->uy[lane] = joint->m_u.y;
+			c->mass[lane] = joint->m_mass;
+			c->bias[lane] = joint->m_bias;
+			c->gamma[lane] = joint->m_gamma;
+			c->impulse[lane] = joint->m_impulse;
+			c->length[lane] = joint->m_length;
+			c->rigid[lane] = joint->m_frequencyHz > 0.0f ? 0.0f : 1.0f;
+			c->invMassA[lane] = joint->m_invMassA;
+			c->invMassB[lane] = joint->m_invMassB;
+			c->invIA[lane] = joint->m_invIA;
+			c->invIB[lane] = joint->m_invIB;
+		}
+	}
+
+	m_wide = true;
+}
+
+void b2JointSolver::SolveVelocityConstraintsWide()
+{
+	b2FloatW zero = b2ZeroW();
+	b2Velocity* velocities = m_data.velocities;
+
+	for (int32 i = 0; i < m_revoluteBatchCount; ++i)
+	{
+		b2RevoluteConstraintW* c = m_revoluteBatches + i;
+
+		b2FloatW vAx, vAy, wA, vBx, vBy, wB;
+		b2GatherVelocities(&vAx, &vAy, &wA, velocities, c->indexA);
+		b2GatherVelocities(&vBx, &vBy, &wB, velocities, c->indexB);
+
+		b2FloatW mA = b2LoadW(c->invMassA);
+		b2FloatW iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB);
+		b2FloatW iB = b2LoadW(c->invIB);
+
+		// Solve motor constraint.
+		{
+			b2FloatW Cdot = b2SubW(b2SubW(wB, wA), b2LoadW(c->motorSpeed));
+			b2FloatW impulse = b2SubW(zero, b2MulW(b2LoadW(c->motorMass), Cdot));
+			b2FloatW oldImpulse = b2LoadW(c->motorImpulse);
+			b2FloatW maxImpulse = b2LoadW(c->maxMotorImpulse);
+			b2FloatW newImpulse = b2MaxW(b2SubW(zero, maxImpulse), b2MinW(b2AddW(oldImpulse, impulse), maxImpulse));
+			b2StoreW(c->motorImpulse, newImpulse);
+			impulse = b2SubW(newImpulse, oldImpulse);
+
+			wA = b2SubW(wA, b2MulW(iA, impulse));
+			wB = b2AddW(wB, b2MulW(iB, impulse));
+		}
+
+		// Solve point-to-point constraint
+		{
+			b2FloatW rAx = b2LoadW(c->rAx);
+			b2FloatW rAy = b2LoadW(c->rAy);
+			b2FloatW rBx = b2LoadW(c->rBx);
+			b2FloatW rBy = b2LoadW(c->rBy);
+
+			b2FloatW Cdotx = b2AddW(b2SubW(b2SubW(vBx, b2MulW(wB, rBy)), vAx), b2MulW(wA, rAy));
+			b2FloatW Cdoty = b2SubW(b2SubW(b2AddW(vBy, b2MulW(wB, rBx)), vAy), b2MulW(wA, rAx));
+
+			// b2Mat33::Solve22(-Cdot)
+			b2FloatW bx = b2SubW(zero, Cdotx);
+			b2FloatW by = b2SubW(zero, Cdoty);
+			b2FloatW invDet = b2LoadW(c->invDet);
+			b2FloatW Px = b2MulW(invDet, b2SubW(b2MulW(b2LoadW(c->K22), bx), b2MulW(b2LoadW(c->K12), by)));
+			b2FloatW Py = b2MulW(invDet, b2SubW(b2MulW(b2LoadW(c->K11), by), b2MulW(b2LoadW(c->K21), bx)));
+
+			b2StoreW(c->impulseX, b2AddW(b2LoadW(c->impulseX), Px));
+			b2StoreW(c->impulseY, b2AddW(b2LoadW(c->impulseY), Py));
+
+			vAx = b2SubW(vAx, b2MulW(mA, Px));
+			vAy = b2SubW(vAy, b2MulW(mA, Py));
+			wA = b2SubW(wA, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+			vBx = b2AddW(vBx, b2MulW(mB, Px));
+			vBy = b2AddW(vBy, b2MulW(mB, Py));
+			wB = b2AddW(wB, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+		}
+
+		b2ScatterVelocities(velocities, c->indexA, vAx, vAy, wA);
+		b2ScatterVelocities(velocities, c->indexB, vBx, vBy, wB);
+	}
+
+	for (int32 i = 0; i < m_distanceBatchCount; ++i)
+	{
+		b2DistanceConstraintW* c = m_distanceBatches + i;
+
+		b2FloatW vAx, vAy, wA, vBx, vBy, wB;
+		b2GatherVelocities(&vAx, &vAy, &wA, velocities, c->indexA);
+		b2GatherVelocities(&vBx, &vBy, &wB, velocities, c->indexB);
+
+		b2FloatW rAx = b2LoadW(c->rAx);
+		b2FloatW rAy = b2LoadW(c->rAy);
+		b2FloatW rBx = b2LoadW(c->rBx);
+		b2FloatW rBy = b2LoadW(c->rBy);
+		b2FloatW ux = b2LoadW(c->ux);
+		b2FloatW uy = b2LoadW(c->uy);
+
+		// Cdot = dot(u, v + cross(w, r))
+		b2FloatW vpAx = b2SubW(vAx, b2MulW(wA, rAy));
+		b2FloatW vpAy = b2AddW(vAy, b2MulW(wA, rAx));
+		b2FloatW vpBx = b2SubW(vBx, b2MulW(wB, rBy));
+		b2FloatW vpBy = b2AddW(vBy, b2MulW(wB, rBx));
+		b2FloatW Cdot = b2DotW(ux, uy, b2SubW(vpBx, vpAx), b2SubW(vpBy, vpAy));
+
+		b2FloatW oldImpulse = b2LoadW(c->impulse);
+		b2FloatW impulse = b2AddW(b2AddW(Cdot, b2LoadW(c->bias)), b2MulW(b2LoadW(c->gamma), oldImpulse));
+		impulse = b2SubW(zero, b2MulW(b2LoadW(c->mass), impulse));
+		b2StoreW(c->impulse, b2AddW(oldImpulse, impulse));
+
+		b2FloatW Px = b2MulW(impulse, ux);
+		b2FloatW Py = b2MulW(impulse, uy);
+
+		b2FloatW mA = b2LoadW(c->invMassA);
+		b2FloatW iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB);
+		b2FloatW iB = b2LoadW(c->invIB);
+
+		vAx = b2SubW(vAx, b2MulW(mA, Px));
+		vAy = b2SubW(vAy, b2MulW(mA, Py));
+		wA = b2SubW(wA, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+		vBx = b2AddW(vBx, b2MulW(mB, Px));
+		vBy = b2AddW(vBy, b2MulW(mB, Py));
+		wB = b2AddW(wB, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+
+		b2ScatterVelocities(velocities, c->indexA, vAx, vAy, wA);
+		b2ScatterVelocities(velocities, c->indexB, vBx, vBy, wB);
+	}
+
+	for (int32 i = 0; i < m_scalarCount; ++i)
+	{
+		m_joints[m_scalarJoints[i]]->SolveVelocityConstraints(m_data);
+	}
+}
+
+bool b2JointSolver::SolvePositionConstraintsWide()
+{
+	b2FloatW zero = b2ZeroW();
+	b2FloatW one = b2SplatW(1.0f);
+	b2FloatW epsilon = b2SplatW(b2_epsilon);
+	b2FloatW linearSlop = b2SplatW(b2_linearSlop);
+	b2FloatW maxCorrection = b2SplatW(b2_maxLinearCorrection);
+	b2Position* positions = m_data.positions;
+
+	// The lanes that are out of tolerance.
+	int32 errorMask = 0;
+
+	for (int32 i = 0; i < m_revoluteBatchCount; ++i)
+	{
+		b2RevoluteConstraintW* c = m_revoluteBatches + i;
+
+		b2FloatW cAx, cAy, aA, cBx, cBy, aB;
+		b2GatherPositions(&cAx, &cAy, &aA, positions, c->indexA);
+		b2GatherPositions(&cBx, &cBy, &aB, positions, c->indexB);
+
+		b2FloatW sA, cosA, sB, cosB;
+		b2SinCosW(&sA, &cosA, aA);
+		b2SinCosW(&sB, &cosB, aB);
+
+		b2FloatW localAnchorAx = b2LoadW(c->localAnchorAx);
+		b2FloatW localAnchorAy = b2LoadW(c->localAnchorAy);
+		b2FloatW localAnchorBx = b2LoadW(c->localAnchorBx);
+		b2FloatW localAnchorBy = b2LoadW(c->localAnchorBy);
+
+		b2FloatW rAx = b2SubW(b2MulW(cosA, localAnchorAx), b2MulW(sA, localAnchorAy));
+		b2FloatW rAy = b2AddW(b2MulW(sA, localAnchorAx), b2MulW(cosA, localAnchorAy));
+		b2FloatW rBx = b2SubW(b2MulW(cosB, localAnchorBx), b2MulW(sB, localAnchorBy));
+		b2FloatW rBy = b2AddW(b2MulW(sB, localAnchorBx), b2MulW(cosB, localAnchorBy));
+
+		b2FloatW Cx = b2SubW(b2SubW(b2AddW(cBx, rBx), cAx), rAx);
+		b2FloatW Cy = b2SubW(b2SubW(b2AddW(cBy, rBy), cAy), rAy);
+		b2FloatW positionError = b2SqrtW(b2DotW(Cx, Cy, Cx, Cy));
+		errorMask |= b2MoveMaskW(b2GreaterW(positionError, linearSlop));
+
+		b2FloatW mA = b2LoadW(c->invMassA);
+		b2FloatW iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB);
+		b2FloatW iB = b2LoadW(c->invIB);
+		b2FloatW m = b2AddW(mA, mB);
+
+		b2FloatW K11 = b2AddW(b2AddW(m, b2MulW(b2MulW(iA, rAy), rAy)), b2MulW(b2MulW(iB, rBy), rBy));
+		b2FloatW K12 = b2SubW(b2SubW(zero, b2MulW(b2MulW(iA, rAx), rAy)), b2MulW(b2MulW(iB, rBx), rBy));
+		b2FloatW K22 = b2AddW(b2AddW(m, b2MulW(b2MulW(iA, rAx), rAx)), b2MulW(b2MulW(iB, rBx), rBx));
+
+		// impulse = -K.Solve(C), which is zero for a singular K.
+		b2FloatW det = b2SubW(b2MulW(K11, K22), b2MulW(K12, K12));
+		b2FloatW solvable = b2GreaterW(b2MaxW(det, b2SubW(zero, det)), zero);
+		b2FloatW invDet = b2DivW(one, b2BlendW(solvable, det, one));
+		invDet = b2BlendW(solvable, invDet, zero);
+		b2FloatW Px = b2SubW(zero, b2MulW(invDet, b2SubW(b2MulW(K22, Cx), b2MulW(K12, Cy))));
+		b2FloatW Py = b2SubW(zero, b2MulW(invDet, b2SubW(b2MulW(K11, Cy), b2MulW(K12, Cx))));
+
+		cAx = b2SubW(cAx, b2MulW(mA, Px));
+		cAy = b2SubW(cAy, b2MulW(mA, Py));
+		aA = b2SubW(aA, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+		cBx = b2AddW(cBx, b2MulW(mB, Px));
+		cBy = b2AddW(cBy, b2MulW(mB, Py));
+		aB = b2AddW(aB, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+
+		b2ScatterPositions(positions, c->indexA, cAx, cAy, aA);
+		b2ScatterPositions(positions, c->indexB, cBx, cBy, aB);
+	}
+
+	for (int32 i = 0; i < m_distanceBatchCount; ++i)
+	{
+		b2DistanceConstraintW* c = m_distanceBatches + i;
+
+		b2FloatW cAx, cAy, aA, cBx, cBy, aB;
+		b2GatherPositions(&cAx, &cAy, &aA, positions, c->indexA);
+		b2GatherPositions(&cBx, &cBy, &aB, positions, c->indexB);
+
+		b2FloatW sA, cosA, sB, cosB;
+		b2SinCosW(&sA, &cosA, aA);
+		b2SinCosW(&sB, &cosB, aB);
+
+		b2FloatW localAnchorAx = b2LoadW(c->localAnchorAx);
+		b2FloatW localAnchorAy = b2LoadW(c->localAnchorAy);
+		b2FloatW localAnchorBx = b2LoadW(c->localAnchorBx);
+		b2FloatW localAnchorBy = b2LoadW(c->localAnchorBy);
+
+		b2FloatW rAx = b2SubW(b2MulW(cosA, localAnchorAx), b2MulW(sA, localAnchorAy));
+		b2FloatW rAy = b2AddW(b2MulW(sA, localAnchorAx), b2MulW(cosA, localAnchorAy));
+		b2FloatW rBx = b2SubW(b2MulW(cosB, localAnchorBx), b2MulW(sB, localAnchorBy));
+		b2FloatW rBy = b2AddW(b2MulW(sB, localAnchorBx), b2MulW(cosB, localAnchorBy));
+
+		b2FloatW ux = b2SubW(b2SubW(b2AddW(cBx, rBx), cAx), rAx);
+		b2FloatW uy = b2SubW(b2SubW(b2AddW(cBy, rBy), cAy), rAy);
+
+		// Normalize like b2Vec2::Normalize, which leaves short vectors alone and
+		// returns zero for them.
+		b2FloatW length = b2SqrtW(b2DotW(ux, uy, ux, uy));
+		b2FloatW longEnough = b2GreaterEqualW(length, epsilon);
+		b2FloatW invLength = b2DivW(one, b2BlendW(longEnough, length, one));
+		ux = b2BlendW(longEnough, b2MulW(ux, invLength), ux);
+		uy = b2BlendW(longEnough, b2MulW(uy, invLength), uy);
+		length = b2BlendW(longEnough, length, zero);
+
+		b2FloatW C = b2SubW(length, b2LoadW(c->length));
+		C = b2MaxW(b2SubW(zero, maxCorrection), b2MinW(C, maxCorrection));
+
+		// Soft lanes have no position correction.
+		b2FloatW rigid = b2GreaterW(b2LoadW(c->rigid), zero);
+		b2FloatW absC = b2MaxW(C, b2SubW(zero, C));
+		errorMask |= b2MoveMaskW(b2AndW(rigid, b2GreaterEqualW(absC, linearSlop)));
+
+		b2FloatW impulse = b2SubW(zero, b2MulW(b2LoadW(c->mass), C));
+		impulse = b2BlendW(rigid, impulse, zero);
+		b2FloatW Px = b2MulW(impulse, ux);
+		b2FloatW Py = b2MulW(impulse, uy);
+
+		b2FloatW mA = b2LoadW(c->invMassA);
+		b2FloatW iA = b2LoadW(c->invIA);
+		b2FloatW mB = b2LoadW(c->invMassB);
+		b2FloatW iB = b2LoadW(c->invIB);
+
+		cAx = b2SubW(cAx, b2MulW(mA, Px));
+		cAy = b2SubW(cAy, b2MulW(mA, Py));
+		aA = b2SubW(aA, b2MulW(iA, b2CrossW(rAx, rAy, Px, Py)));
+
+		cBx = b2AddW(cBx, b2MulW(mB, Px));
+		cBy = b2AddW(cBy, b2MulW(mB, Py));
+		aB = b2AddW(aB, b2MulW(iB, b2CrossW(rBx, rBy, Px, Py)));
+
+		b2ScatterPositions(positions, c->indexA, cAx, cAy, aA);
+		b2ScatterPositions(positions, c->indexB, cBx, cBy, aB);
+	}
+
+	bool jointsOkay = errorMask == 0;
+	for (int32 i = 0; i < m_scalarCount; ++i)
+	{
+		bool jointOkay = m_joints[m_scalarJoints[i]]->SolvePositionConstraints(m_data);
+		jointsOkay = jointsOkay && jointOkay;
+	}
+
+	return jointsOkay;
+}
@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_JOINT_SOLVER_H
+#define B2_JOINT_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Joint;
+class b2StackAllocator;
+struct b2RevoluteConstraintW;
+struct b2DistanceConstraintW;
+
+struct b2JointSolverDef
+{
+	b2TimeStep step;
+	b2Joint** joints;
+	int32 count;
+	b2Position* positions;
+	b2Velocity* velocities;
+	b2StackAllocator* allocator;
+};
+
+class b2JointSolver
+{
+public:
+	b2JointSolver(b2JointSolverDef* def);
+	~b2JointSolver();
+
+	void InitVelocityConstraints();
+	void SolveVelocityConstraints();
+	void StoreImpulses();
+
+	bool SolvePositionConstraints();
+
+	void PrepareWide();
+	void SolveVelocityConstraintsWide();
+	bool SolvePositionConstraintsWide();
+
+	b2SolverData m_data;
+	b2StackAllocator* m_allocator;
+	b2Joint** m_joints;
+	int32 m_count;
+
+	// The wide solver packs four revolute or distance joints into each batch.
+	// The remaining joints are sorted by type and solved one at a time.
+	bool m_wide;
+	int32* m_colors;
+	b2RevoluteConstraintW* m_revoluteBatches;
+	int32 m_revoluteBatchCount;
+	b2DistanceConstraintW* m_distanceBatches;
+	int32 m_distanceBatchCount;
+	int32* m_scalarJoints;
+	int32 m_scalarCount;
+};
+
+#endif
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2MouseJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -215,3 +216,23 @@ float32 b2MouseJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * 0.0f;
 }
+
+void b2MouseJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_targetA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_maxForce);
+	snapshot->Write(m_frequencyHz);
+	snapshot->Write(m_dampingRatio);
+	snapshot->Write(m_impulse);
+}
+
+void b2MouseJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_targetA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_maxForce);
+	reader->Read(&m_frequencyHz);
+	reader->Read(&m_dampingRatio);
+	reader->Read(&m_impulse);
+}
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -635,3 +636,39 @@ void b2PrismaticJoint::Dump()
 	b2Log("  jd.maxMotorForce = %.15lef;\n", m_maxMotorForce);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PrismaticJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_localXAxisA);
+	snapshot->Write(m_localYAxisA);
+	snapshot->Write(m_referenceAngle);
+	snapshot->Write(m_enableLimit);
+	snapshot->Write(m_lowerTranslation);
+	snapshot->Write(m_upperTranslation);
+	snapshot->Write(m_enableMotor);
+	snapshot->Write(m_maxMotorForce);
+	snapshot->Write(m_motorSpeed);
+	snapshot->Write(m_limitState);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_motorImpulse);
+}
+
+void b2PrismaticJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_localXAxisA);
+	reader->Read(&m_localYAxisA);
+	reader->Read(&m_referenceAngle);
+	reader->Read(&m_enableLimit);
+	reader->Read(&m_lowerTranslation);
+	reader->Read(&m_upperTranslation);
+	reader->Read(&m_enableMotor);
+	reader->Read(&m_maxMotorForce);
+	reader->Read(&m_motorSpeed);
+	reader->Read(&m_limitState);
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+}
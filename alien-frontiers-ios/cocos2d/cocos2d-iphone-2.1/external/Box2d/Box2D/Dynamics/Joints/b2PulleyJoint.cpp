@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -330,3 +331,29 @@ void b2PulleyJoint::Dump()
 	b2Log("  jd.ratio = %.15lef;\n", m_ratio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2PulleyJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_groundAnchorA);
+	snapshot->Write(m_groundAnchorB);
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_lengthA);
+	snapshot->Write(m_lengthB);
+	snapshot->Write(m_ratio);
+	snapshot->Write(m_constant);
+	snapshot->Write(m_impulse);
+}
+
+void b2PulleyJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_groundAnchorA);
+	reader->Read(&m_groundAnchorB);
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_lengthA);
+	reader->Read(&m_lengthB);
+	reader->Read(&m_ratio);
+	reader->Read(&m_constant);
+	reader->Read(&m_impulse);
+}
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -502,3 +503,35 @@ void b2RevoluteJoint::Dump()
 	b2Log("  jd.maxMotorTorque = %.15lef;\n", m_maxMotorTorque);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RevoluteJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_referenceAngle);
+	snapshot->Write(m_enableLimit);
+	snapshot->Write(m_lowerAngle);
+	snapshot->Write(m_upperAngle);
+	snapshot->Write(m_enableMotor);
+	snapshot->Write(m_maxMotorTorque);
+	snapshot->Write(m_motorSpeed);
+	snapshot->Write(m_limitState);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_motorImpulse);
+}
+
+void b2RevoluteJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_referenceAngle);
+	reader->Read(&m_enableLimit);
+	reader->Read(&m_lowerAngle);
+	reader->Read(&m_upperAngle);
+	reader->Read(&m_enableMotor);
+	reader->Read(&m_maxMotorTorque);
+	reader->Read(&m_motorSpeed);
+	reader->Read(&m_limitState);
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+}
@@ -158,6 +158,7 @@ protected:
 
 	friend class b2Joint;
 	friend class b2GearJoint;
+	friend class b2JointSolver;
 
 	b2RevoluteJoint(const b2RevoluteJointDef* def);
 
@@ -165,6 +166,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2Snapshot* snapshot) const;
+	void LoadState(b2SnapshotReader* reader);
+
 	// Solver shared
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2RopeJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -239,3 +240,23 @@ void b2RopeJoint::Dump()
 	b2Log("  jd.maxLength = %.15lef;\n", m_maxLength);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2RopeJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_maxLength);
+	snapshot->Write(m_length);
+	snapshot->Write(m_state);
+	snapshot->Write(m_impulse);
+}
+
+void b2RopeJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_maxLength);
+	reader->Read(&m_length);
+	reader->Read(&m_state);
+	reader->Read(&m_impulse);
+}
@@ -98,6 +98,9 @@ protected:
 	void SolveVelocityConstraints(const b2SolverData& data);
 	bool SolvePositionConstraints(const b2SolverData& data);
 
+	void SaveState(b2Snapshot* snapshot) const;
+	void LoadState(b2SnapshotReader* reader);
+
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
 	float32 m_bias;
@@ -17,6 +17,7 @@
 */
 
 #include <Box2D/Dynamics/Joints/b2WheelJoint.h>
+#include <Box2D/Common/b2Snapshot.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 
@@ -417,3 +418,35 @@ void b2WheelJoint::Dump()
 	b2Log("  jd.dampingRatio = %.15lef;\n", m_dampingRatio);
 	b2Log("  joints[%d] = m_world->CreateJoint(&jd);\n", m_index);
 }
+
+void b2WheelJoint::SaveState(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_localAnchorA);
+	snapshot->Write(m_localAnchorB);
+	snapshot->Write(m_localXAxisA);
+	snapshot->Write(m_localYAxisA);
+	snapshot->Write(m_frequencyHz);
+	snapshot->Write(m_dampingRatio);
+	snapshot->Write(m_enableMotor);
+	snapshot->Write(m_maxMotorTorque);
+	snapshot->Write(m_motorSpeed);
+	snapshot->Write(m_impulse);
+	snapshot->Write(m_motorImpulse);
+	snapshot->Write(m_springImpulse);
+}
+
+void b2WheelJoint::LoadState(b2SnapshotReader* reader)
+{
+	reader->Read(&m_localAnchorA);
+	reader->Read(&m_localAnchorB);
+	reader->Read(&m_localXAxisA);
+	reader->Read(&m_localYAxisA);
+	reader->Read(&m_frequencyHz);
+	reader->Read(&m_dampingRatio);
+	reader->Read(&m_enableMotor);
+	reader->Read(&m_maxMotorTorque);
+	reader->Read(&m_motorSpeed);
+	reader->Read(&m_impulse);
+	reader->Read(&m_motorImpulse);
+	reader->Read(&m_springImpulse);
+}
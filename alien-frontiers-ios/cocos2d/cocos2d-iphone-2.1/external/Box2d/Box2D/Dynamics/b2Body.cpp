@@ -21,6 +21,7 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 {
@@ -55,6 +56,8 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	}
 
 	m_world = world;
+	m_state = NULL;
+	m_stateIndex = b2_nullStateIndex;
 
 	m_xf.p = bd->position;
 	m_xf.q.Set(bd->angle);
@@ -133,10 +136,12 @@ void b2Body::SetType(b2BodyType type)
 		m_angularVelocity = 0.0f;
 		m_sweep.a0 = m_sweep.a;
 		m_sweep.c0 = m_sweep.c;
+		StoreState();
 		SynchronizeFixtures();
 	}
 
 	SetAwake(true);
+	SynchronizeProxyTree();
 
 	m_force.SetZero();
 	m_torque = 0.0f;
@@ -165,7 +170,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	if (m_flags & e_activeFlag)
 	{
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-		fixture->CreateProxies(broadPhase, m_xf);
+		fixture->CreateProxies(broadPhase, m_xf, GetProxyTree());
 	}
 
 	fixture->m_next = m_fixtureList;
@@ -278,6 +283,7 @@ void b2Body::ResetMassData()
 		m_sweep.c0 = m_xf.p;
 		m_sweep.c = m_xf.p;
 		m_sweep.a0 = m_sweep.a;
+		StoreState();
 		return;
 	}
 
@@ -333,6 +339,7 @@ void b2Body::ResetMassData()
 
 	// Update center of mass velocity.
 	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	StoreState();
 }
 
 void b2Body::SetMassData(const b2MassData* massData)
@@ -374,6 +381,7 @@ void b2Body::SetMassData(const b2MassData* massData)
 
 	// Update center of mass velocity.
 	m_linearVelocity += b2Cross(m_angularVelocity, m_sweep.c - oldCenter);
+	StoreState();
 }
 
 bool b2Body::ShouldCollide(const b2Body* other) const
@@ -415,6 +423,7 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 
 	m_sweep.c0 = m_sweep.c;
 	m_sweep.a0 = angle;
+	StoreState();
 
 	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
@@ -438,6 +447,26 @@ void b2Body::SynchronizeFixtures()
 	}
 }
 
+int32 b2Body::GetProxyTree() const
+{
+	if (m_type == b2_staticBody)
+	{
+		return b2BroadPhase::e_staticTree;
+	}
+
+	return (m_flags & e_awakeFlag) ? b2BroadPhase::e_awakeTree : b2BroadPhase::e_sleepingTree;
+}
+
+void b2Body::SynchronizeProxyTree()
+{
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	int32 tree = GetProxyTree();
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		f->SetProxyTree(broadPhase, tree);
+	}
+}
+
 void b2Body::SetActive(bool flag)
 {
 	b2Assert(m_world->IsLocked() == false);
@@ -455,7 +484,7 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
-			f->CreateProxies(broadPhase, m_xf);
+			f->CreateProxies(broadPhase, m_xf, GetProxyTree());
 		}
 
 		// Contacts are created the next time step.
@@ -512,3 +541,72 @@ void b2Body::Dump()
 	}
 	b2Log("}\n");
 }
+
+void b2Body::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_type);
+	snapshot->Write(m_flags);
+	snapshot->Write(m_xf);
+	snapshot->Write(m_sweep);
+	snapshot->Write(m_linearVelocity);
+	snapshot->Write(m_angularVelocity);
+	snapshot->Write(m_force);
+	snapshot->Write(m_torque);
+	snapshot->Write(m_mass);
+	snapshot->Write(m_invMass);
+	snapshot->Write(m_I);
+	snapshot->Write(m_invI);
+	snapshot->Write(m_linearDamping);
+	snapshot->Write(m_angularDamping);
+	snapshot->Write(m_gravityScale);
+	snapshot->Write(m_sleepTime);
+	snapshot->Write(m_userData);
+
+	snapshot->Write(m_fixtureCount);
+	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+	{
+		f->Save(snapshot);
+	}
+}
+
+void b2Body::Load(b2SnapshotReader* reader)
+{
+	b2Assert(m_fixtureList == NULL);
+
+	reader->Read(&m_type);
+	reader->Read(&m_flags);
+	reader->Read(&m_xf);
+	reader->Read(&m_sweep);
+	reader->Read(&m_linearVelocity);
+	reader->Read(&m_angularVelocity);
+	reader->Read(&m_force);
+	reader->Read(&m_torque);
+	reader->Read(&m_mass);
+	reader->Read(&m_invMass);
+	reader->Read(&m_I);
+	reader->Read(&m_invI);
+	reader->Read(&m_linearDamping);
+	reader->Read(&m_angularDamping);
+	reader->Read(&m_gravityScale);
+	reader->Read(&m_sleepTime);
+	reader->Read(&m_userData);
+
+	int32 fixtureCount;
+	reader->Read(&fixtureCount);
+
+	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
+	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+
+	// Keep the saved order, it decides the order of broad-phase moves.
+	b2Fixture** tail = &m_fixtureList;
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		void* memory = allocator->Allocate(sizeof(b2Fixture));
+		b2Fixture* fixture = new (memory) b2Fixture;
+		fixture->Load(allocator, this, reader, broadPhase);
+
+		*tail = fixture;
+		tail = &fixture->m_next;
+	}
+	m_fixtureCount = fixtureCount;
+}
@@ -21,6 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2BodyState.h>
 #include <memory>
 
 class b2Fixture;
@@ -28,6 +29,8 @@ class b2Joint;
 class b2Contact;
 class b2Controller;
 class b2World;
+class b2Snapshot;
+class b2SnapshotReader;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
@@ -384,7 +387,10 @@ private:
 	friend class b2Island;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
+	friend class b2JointSolver;
 	friend class b2Contact;
+	friend class b2Joint;
+	friend class b2BodyState;
 
 	friend class b2DistanceJoint;
 	friend class b2GearJoint;
@@ -415,12 +421,26 @@ private:
 	void SynchronizeFixtures();
 	void SynchronizeTransform();
 
+	// Get the broad-phase tree that suits the type and sleep state, and move
+	// the proxies there.
+	int32 GetProxyTree() const;
+	void SynchronizeProxyTree();
+
+	// These support b2World::Save and b2World::Restore. Load expects a body
+	// without fixtures.
+	void Save(b2Snapshot* snapshot) const;
+	void Load(b2SnapshotReader* reader);
+
 	// This is used to prevent connected bodies from colliding.
 	// It may lie, depending on the collideConnected flag.
 	bool ShouldCollide(const b2Body* other) const;
 
 	void Advance(float32 t);
 
+	// Copy the position and velocity into the world body state, if the body
+	// has a slot there.
+	void StoreState();
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
@@ -436,6 +456,9 @@ private:
 	b2Vec2 m_force;
 	float32 m_torque;
 
+	b2BodyState* m_state;
+	int32 m_stateIndex;
+
 	b2World* m_world;
 	b2Body* m_prev;
 	b2Body* m_next;
@@ -503,6 +526,7 @@ inline void b2Body::SetLinearVelocity(const b2Vec2& v)
 	}
 
 	m_linearVelocity = v;
+	StoreState();
 }
 
 inline b2Vec2 b2Body::GetLinearVelocity() const
@@ -523,6 +547,7 @@ inline void b2Body::SetAngularVelocity(float32 w)
 	}
 
 	m_angularVelocity = w;
+	StoreState();
 }
 
 inline float32 b2Body::GetAngularVelocity() const
@@ -642,6 +667,7 @@ inline void b2Body::SetAwake(bool flag)
 		m_angularVelocity = 0.0f;
 		m_force.SetZero();
 		m_torque = 0.0f;
+		StoreState();
 	}
 }
 
@@ -801,6 +827,7 @@ inline void b2Body::ApplyLinearImpulse(const b2Vec2& impulse, const b2Vec2& poin
 	}
 	m_linearVelocity += m_invMass * impulse;
 	m_angularVelocity += m_invI * b2Cross(point - m_sweep.c, impulse);
+	StoreState();
 }
 
 inline void b2Body::ApplyAngularImpulse(float32 impulse)
@@ -815,6 +842,7 @@ inline void b2Body::ApplyAngularImpulse(float32 impulse)
 		SetAwake(true);
 	}
 	m_angularVelocity += m_invI * impulse;
+	StoreState();
 }
 
 inline void b2Body::SynchronizeTransform()
@@ -831,6 +859,23 @@ inline void b2Body::Advance(float32 alpha)
 	m_sweep.a = m_sweep.a0;
 	m_xf.q.Set(m_sweep.a);
 	m_xf.p = m_sweep.c - b2Mul(m_xf.q, m_sweep.localCenter);
+	StoreState();
+}
+
+inline void b2Body::StoreState()
+{
+	if (m_state == NULL)
+	{
+		return;
+	}
+
+	b2Position* position = m_state->m_positions + m_stateIndex;
+	position->c = m_sweep.c;
+	position->a = m_sweep.a;
+
+	b2Velocity* velocity = m_state->m_velocities + m_stateIndex;
+	velocity->v = m_linearVelocity;
+	velocity->w = m_angularVelocity;
 }
 
 inline b2World* b2Body::GetWorld()
@@ -0,0 +1,105 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2BodyState.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <cstring>
+
+b2BodyState::b2BodyState()
+{
+	m_bodies = NULL;
+	m_positions = NULL;
+	m_velocities = NULL;
+	m_count = 0;
+	m_capacity = 0;
+}
+
+b2BodyState::~b2BodyState()
+{
+	b2Free(m_velocities);
+	b2Free(m_positions);
+	b2Free(m_bodies);
+}
+
+void b2BodyState::Add(b2Body* body)
+{
+	b2Assert(body->m_state == NULL);
+
+	if (m_count == m_capacity)
+	{
+		m_capacity = b2Max(2 * m_capacity, 64);
+
+		b2Body** bodies = (b2Body**)b2Alloc(m_capacity * sizeof(b2Body*));
+		b2Position* positions = (b2Position*)b2Alloc(m_capacity * sizeof(b2Position));
+		b2Velocity* velocities = (b2Velocity*)b2Alloc(m_capacity * sizeof(b2Velocity));
+
+		if (m_count > 0)
+		{
+			memcpy(bodies, m_bodies, m_count * sizeof(b2Body*));
+			memcpy(positions, m_positions, m_count * sizeof(b2Position));
+			memcpy(velocities, m_velocities, m_count * sizeof(b2Velocity));
+		}
+
+		b2Free(m_velocities);
+		b2Free(m_positions);
+		b2Free(m_bodies);
+
+		m_bodies = bodies;
+		m_positions = positions;
+		m_velocities = velocities;
+	}
+
+	body->m_state = this;
+	body->m_stateIndex = m_count;
+	m_bodies[m_count] = body;
+	++m_count;
+
+	body->StoreState();
+}
+
+void b2BodyState::Remove(b2Body* body)
+{
+	b2Assert(body->m_state == this);
+
+	int32 index = body->m_stateIndex;
+	b2Assert(0 <= index && index < m_count);
+
+	--m_count;
+	if (index < m_count)
+	{
+		b2Body* last = m_bodies[m_count];
+		m_bodies[index] = last;
+		m_positions[index] = m_positions[m_count];
+		m_velocities[index] = m_velocities[m_count];
+		last->m_stateIndex = index;
+	}
+
+	body->m_state = NULL;
+	body->m_stateIndex = b2_nullStateIndex;
+}
+
+void b2BodyState::Clear()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_bodies[i]->m_state = NULL;
+		m_bodies[i]->m_stateIndex = b2_nullStateIndex;
+	}
+
+	m_count = 0;
+}
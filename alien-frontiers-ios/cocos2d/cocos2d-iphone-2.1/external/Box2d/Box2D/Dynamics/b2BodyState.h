@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BODY_STATE_H
+#define B2_BODY_STATE_H
+
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Body;
+
+/// The state index of a body without a slot.
+const int32 b2_nullStateIndex = -1;
+
+/// The solver state of all bodies of a world in contiguous arrays, used when
+/// b2World::SetBodyStateArrays is enabled. A body keeps its slot, given by
+/// b2Body::m_stateIndex, for as long as it lives. The slots mirror the body:
+/// whatever moves a body outside of the solver also stores it here. Islands
+/// solve directly on these arrays, so bodies are not gathered into temporary
+/// arrays and static bodies need no copies.
+class b2BodyState
+{
+public:
+	b2BodyState();
+	~b2BodyState();
+
+	/// Give a body a slot and store its state there.
+	void Add(b2Body* body);
+
+	/// Free the slot of a body. The body in the last slot moves into it.
+	void Remove(b2Body* body);
+
+	/// Free all slots.
+	void Clear();
+
+	int32 GetCount() const;
+
+	b2Body** m_bodies;
+	b2Position* m_positions;
+	b2Velocity* m_velocities;
+
+	int32 m_count;
+	int32 m_capacity;
+};
+
+inline int32 b2BodyState::GetCount() const
+{
+	return m_count;
+}
+
+#endif
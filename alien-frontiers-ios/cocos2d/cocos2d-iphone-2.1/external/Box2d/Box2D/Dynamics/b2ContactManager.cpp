@@ -19,8 +19,12 @@
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2Profiler.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -32,6 +36,7 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_profiler = NULL;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -46,6 +51,8 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactListener->EndContact(c);
 	}
 
+	m_pairSet.Remove(c->m_pairKey);
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -102,12 +109,151 @@ void b2ContactManager::Destroy(b2Contact* c)
 // This is the top level collision call for the time step. Here
 // all the narrow phase collision is processed for the world
 // contact list.
-void b2ContactManager::Collide()
+// The smallest number of contacts worth handing to another thread.
+static const int32 b2_collideRange = 64;
+
+// Computes manifolds. This only reads the contacts, so contacts may be
+// computed in any order. The updates are grouped by contact type and each
+// run of one type is computed by a single batch call.
+class b2ContactUpdateTask : public b2Task
 {
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		b2ProfileZone(profiler, threadIndex, "Narrow-phase");
+
+		int32 runBegin = begin;
+		while (runBegin < end)
+		{
+			int32 type = types[runBegin];
+			int32 runEnd = runBegin + 1;
+			while (runEnd < end && types[runEnd] == type)
+			{
+				++runEnd;
+			}
+
+			b2ProfileBegin(profiler, manifoldBegin);
+			b2Contact::ComputeManifolds(updates + runBegin, runEnd - runBegin);
+			b2ProfileManifolds(profiler, threadIndex, updates[runBegin]->contact, manifoldBegin, runEnd - runBegin);
+
+			runBegin = runEnd;
+		}
+	}
+
+	b2ContactUpdate** updates;
+	const int32* types;
+	b2Profiler* profiler;
+};
+
+void b2ContactManager::Collide(b2TaskScheduler* scheduler, b2StackAllocator* allocator)
+{
+	// Compute the manifolds of the contacts that the serial pass below is going to
+	// update, as far as this can be known before any listener runs. The serial pass
+	// applies them in list order, so the listener sees the same events in the same
+	// order as without a scheduler. Contacts that are not found here, for example
+	// because an earlier contact wakes their bodies, are computed on the spot.
+	// So are sensors, because b2Distance keeps global statistics.
+	b2ContactUpdate* updates = NULL;
+	b2ContactUpdate** groupedUpdates = NULL;
+	int32* types = NULL;
+	int32 updateCount = 0;
+	if (scheduler != NULL && scheduler->GetThreadCount() > 1 && m_contactCount > 0)
+	{
+		updates = (b2ContactUpdate*)allocator->Allocate(m_contactCount * sizeof(b2ContactUpdate));
+
+		for (b2Contact* c = m_contactList; c; c = c->GetNext())
+		{
+			if (c->m_flags & b2Contact::e_filterFlag)
+			{
+				continue;
+			}
+
+			b2Fixture* fixtureA = c->GetFixtureA();
+			b2Fixture* fixtureB = c->GetFixtureB();
+			if (fixtureA->IsSensor() || fixtureB->IsSensor())
+			{
+				continue;
+			}
+
+			b2Body* bodyA = fixtureA->GetBody();
+			b2Body* bodyB = fixtureB->GetBody();
+
+			bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+			bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+			if (activeA == false && activeB == false)
+			{
+				continue;
+			}
+
+			int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+			int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+			if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+			{
+				continue;
+			}
+
+			b2ContactUpdate* update = updates + updateCount;
+			update->contact = c;
+			++updateCount;
+		}
+
+		// Group the updates by contact type with a counting sort.
+		const int32 typeCount = b2Shape::e_typeCount * b2Shape::e_typeCount;
+		int32 typeStarts[typeCount + 1];
+		memset(typeStarts, 0, sizeof(typeStarts));
+
+		groupedUpdates = (b2ContactUpdate**)allocator->Allocate(updateCount * sizeof(b2ContactUpdate*));
+		types = (int32*)allocator->Allocate(updateCount * sizeof(int32));
+
+		for (int32 i = 0; i < updateCount; ++i)
+		{
+			b2Contact* contact = updates[i].contact;
+			int32 type = contact->GetFixtureA()->GetType() * b2Shape::e_typeCount + contact->GetFixtureB()->GetType();
+			types[i] = type;
+			++typeStarts[type + 1];
+		}
+
+		for (int32 i = 0; i < typeCount; ++i)
+		{
+			typeStarts[i + 1] += typeStarts[i];
+		}
+
+		for (int32 i = 0; i < updateCount; ++i)
+		{
+			groupedUpdates[typeStarts[types[i]]++] = updates + i;
+		}
+
+		// The starts now point at the end of each type.
+		for (int32 type = 0, index = 0; type < typeCount; ++type)
+		{
+			while (index < typeStarts[type])
+			{
+				types[index++] = type;
+			}
+		}
+
+		b2ContactUpdateTask task;
+		task.updates = groupedUpdates;
+		task.types = types;
+		task.profiler = m_profiler;
+		scheduler->ParallelFor(&task, updateCount, b2_collideRange);
+	}
+
+	int32 updateIndex = 0;
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
 	{
+		// Contacts are never added here, so the computed contacts come up in order.
+		b2ContactUpdate* update = NULL;
+		if (updateIndex < updateCount && updates[updateIndex].contact == c)
+		{
+			update = updates + updateIndex;
+			++updateIndex;
+		}
+
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		int32 indexA = c->GetChildIndexA();
@@ -163,14 +309,43 @@ void b2ContactManager::Collide()
 			continue;
 		}
 
-		// The contact persists.
-		c->Update(m_contactListener);
+		// The contact persists. A listener may have made it a sensor since
+		// the manifold was computed.
+		bool sensor = fixtureA->IsSensor() || fixtureB->IsSensor();
+		if (update != NULL && sensor == false)
+		{
+			c->Update(update->manifold, update->touching, m_contactListener);
+		}
+		else
+		{
+			b2ProfileBegin(m_profiler, manifoldBegin);
+			c->Update(m_contactListener);
+			b2ProfileManifolds(m_profiler, 0, c, manifoldBegin, 1);
+		}
+
 		c = c->GetNext();
 	}
+
+	if (updates != NULL)
+	{
+		allocator->Free(types);
+		allocator->Free(groupedUpdates);
+		allocator->Free(updates);
+	}
+}
+
+void b2ContactManager::Reset()
+{
+	m_contactList = NULL;
+	m_contactCount = 0;
+	m_pairSet.Clear();
+	m_broadPhase.Reset();
 }
 
 void b2ContactManager::FindNewContacts()
 {
+	b2ProfileZone(m_profiler, 0, "Find pairs");
+	b2ProfileCount(m_profiler, proxyMoveCount, m_broadPhase.GetMoveCount());
 	m_broadPhase.UpdatePairs(this);
 }
 
@@ -194,33 +369,11 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
-	// TODO_ERIN use a hash table to remove a potential bottleneck when both
-	// bodies have a lot of contacts.
 	// Does a contact already exist?
-	b2ContactEdge* edge = bodyB->GetContactList();
-	while (edge)
+	uint64 pairKey = b2PairKey(proxyA->proxyId, proxyB->proxyId);
+	if (m_pairSet.Contains(pairKey))
 	{
-		if (edge->other == bodyA)
-		{
-			b2Fixture* fA = edge->contact->GetFixtureA();
-			b2Fixture* fB = edge->contact->GetFixtureB();
-			int32 iA = edge->contact->GetChildIndexA();
-			int32 iB = edge->contact->GetChildIndexB();
-
-			if (fA == fixtureA && fB == fixtureB && iA == indexA && iB == indexB)
-			{
-				// A contact already exists.
-				return;
-			}
-
-			if (fA == fixtureB && fB == fixtureA && iA == indexB && iB == indexA)
-			{
-				// A contact already exists.
-				return;
-			}
-		}
-
-		edge = edge->next;
+		return;
 	}
 
 	// Does a joint override collision? Is at least one body dynamic?
@@ -242,13 +395,21 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	c->m_pairKey = pairKey;
+	m_pairSet.Add(pairKey);
+
+	Link(c);
+
+	// Wake up the bodies
+	bodyA->SetAwake(true);
+	bodyB->SetAwake(true);
+}
+
+void b2ContactManager::Link(b2Contact* c)
+{
 	// Contact creation may swap fixtures.
-	fixtureA = c->GetFixtureA();
-	fixtureB = c->GetFixtureB();
-	indexA = c->GetChildIndexA();
-	indexB = c->GetChildIndexB();
-	bodyA = fixtureA->GetBody();
-	bodyB = fixtureB->GetBody();
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
 
 	// Insert into the world.
 	c->m_prev = NULL;
@@ -285,9 +446,88 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
-	// Wake up the bodies
-	bodyA->SetAwake(true);
-	bodyB->SetAwake(true);
-
 	++m_contactCount;
 }
+
+void b2ContactManager::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_contactCount);
+
+	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	{
+		snapshot->Write(c->m_pairKey);
+		snapshot->Write(c->m_flags);
+		snapshot->Write(c->m_toiCount);
+		snapshot->Write(c->m_toi);
+		snapshot->Write(c->m_friction);
+		snapshot->Write(c->m_restitution);
+
+		// Most contacts in the broad-phase are not touching.
+		const b2Manifold& manifold = c->m_manifold;
+		snapshot->Write(manifold.pointCount);
+		if (manifold.pointCount > 0)
+		{
+			snapshot->Write(manifold.localNormal);
+			snapshot->Write(manifold.localPoint);
+			snapshot->Write(manifold.type);
+			snapshot->Write(manifold.points, manifold.pointCount * sizeof(b2ManifoldPoint));
+		}
+	}
+}
+
+void b2ContactManager::Load(b2SnapshotReader* reader)
+{
+	b2Assert(m_contactList == NULL);
+
+	int32 contactCount;
+	reader->Read(&contactCount);
+
+	// The contacts are saved newest first. They are chained through m_prev
+	// and linked oldest first, as AddPair does, so all lists keep their order.
+	b2Contact* oldest = NULL;
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		uint64 pairKey;
+		reader->Read(&pairKey);
+
+		// AddPair receives the smaller proxy first, see b2BroadPhase::QueryCallback.
+		// The factory then orders the fixtures the same way it did then.
+		int32 proxyIdA = int32(pairKey >> 32);
+		int32 proxyIdB = int32(pairKey & 0xFFFFFFFF);
+		b2FixtureProxy* proxyA = (b2FixtureProxy*)m_broadPhase.GetUserData(proxyIdA);
+		b2FixtureProxy* proxyB = (b2FixtureProxy*)m_broadPhase.GetUserData(proxyIdB);
+
+		b2Contact* c = b2Contact::Create(proxyA->fixture, proxyA->childIndex, proxyB->fixture, proxyB->childIndex, m_allocator);
+		b2Assert(c != NULL);
+
+		c->m_pairKey = pairKey;
+		m_pairSet.Add(pairKey);
+
+		reader->Read(&c->m_flags);
+		reader->Read(&c->m_toiCount);
+		reader->Read(&c->m_toi);
+		reader->Read(&c->m_friction);
+		reader->Read(&c->m_restitution);
+
+		b2Manifold& manifold = c->m_manifold;
+		reader->Read(&manifold.pointCount);
+		if (manifold.pointCount > 0)
+		{
+			b2Assert(manifold.pointCount <= b2_maxManifoldPoints);
+			reader->Read(&manifold.localNormal);
+			reader->Read(&manifold.localPoint);
+			reader->Read(&manifold.type);
+			reader->Read(manifold.points, manifold.pointCount * sizeof(b2ManifoldPoint));
+		}
+
+		c->m_prev = oldest;
+		oldest = c;
+	}
+
+	while (oldest)
+	{
+		b2Contact* newer = oldest->m_prev;
+		Link(oldest);
+		oldest = newer;
+	}
+}
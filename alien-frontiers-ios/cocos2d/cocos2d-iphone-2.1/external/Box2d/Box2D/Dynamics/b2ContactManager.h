@@ -25,6 +25,11 @@ class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2Profiler;
+class b2Snapshot;
+class b2SnapshotReader;
+class b2StackAllocator;
+class b2TaskScheduler;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -39,7 +44,21 @@ public:
 
 	void Destroy(b2Contact* c);
 
-	void Collide();
+	// Update the contacts. With a scheduler the manifolds are computed on its
+	// threads and the listener events are still reported in list order.
+	void Collide(b2TaskScheduler* scheduler, b2StackAllocator* allocator);
+
+	// Forget all contacts and proxies without destroying them. Used by b2World::Reset.
+	void Reset();
+
+	// Write the contacts. Fixtures are referred to by the pair key.
+	void Save(b2Snapshot* snapshot) const;
+
+	// Rebuild the contacts after the broad-phase and the fixtures are loaded.
+	void Load(b2SnapshotReader* reader);
+
+	// Insert a new contact into the world list and the body contact lists.
+	void Link(b2Contact* c);
 
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
@@ -47,6 +66,10 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2Profiler* m_profiler;
+
+	// The proxy pairs that have a contact, see b2PairKey.
+	b2HashSet m_pairSet;
 };
 
 #endif
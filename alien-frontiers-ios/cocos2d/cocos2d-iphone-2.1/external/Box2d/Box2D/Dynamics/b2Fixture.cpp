@@ -26,6 +26,7 @@
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2Snapshot.h>
 
 b2Fixture::b2Fixture()
 {
@@ -119,7 +120,7 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 	m_shape = NULL;
 }
 
-void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
+void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf, int32 tree)
 {
 	b2Assert(m_proxyCount == 0);
 
@@ -130,7 +131,7 @@ void b2Fixture::CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf)
 	{
 		b2FixtureProxy* proxy = m_proxies + i;
 		m_shape->ComputeAABB(&proxy->aabb, xf, i);
-		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy);
+		proxy->proxyId = broadPhase->CreateProxy(proxy->aabb, proxy, tree);
 		proxy->fixture = this;
 		proxy->childIndex = i;
 	}
@@ -173,6 +174,18 @@ void b2Fixture::Synchronize(b2BroadPhase* broadPhase, const b2Transform& transfo
 	}
 }
 
+void b2Fixture::SetProxyTree(b2BroadPhase* broadPhase, int32 tree)
+{
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		b2FixtureProxy* proxy = m_proxies + i;
+		if (broadPhase->GetProxyTree(proxy->proxyId) != tree)
+		{
+			broadPhase->SetProxyTree(proxy->proxyId, tree, proxy->aabb);
+		}
+	}
+}
+
 void b2Fixture::SetFilterData(const b2Filter& filter)
 {
 	m_filter = filter;
@@ -301,3 +314,161 @@ void b2Fixture::Dump(int32 bodyIndex)
 	b2Log("\n");
 	b2Log("    bodies[%d]->CreateFixture(&fd);\n", bodyIndex);
 }
+
+void b2Fixture::Save(b2Snapshot* snapshot) const
+{
+	snapshot->Write(m_shape->m_type);
+	snapshot->Write(m_shape->m_radius);
+
+	switch (m_shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			b2CircleShape* s = (b2CircleShape*)m_shape;
+			snapshot->Write(s->m_p);
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			b2EdgeShape* s = (b2EdgeShape*)m_shape;
+			snapshot->Write(s->m_vertex0);
+			snapshot->Write(s->m_vertex1);
+			snapshot->Write(s->m_vertex2);
+			snapshot->Write(s->m_vertex3);
+			snapshot->Write(s->m_hasVertex0);
+			snapshot->Write(s->m_hasVertex3);
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			b2PolygonShape* s = (b2PolygonShape*)m_shape;
+			snapshot->Write(s->m_centroid);
+			snapshot->Write(s->m_vertexCount);
+			snapshot->Write(s->m_vertices, s->m_vertexCount * sizeof(b2Vec2));
+			snapshot->Write(s->m_normals, s->m_vertexCount * sizeof(b2Vec2));
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			b2ChainShape* s = (b2ChainShape*)m_shape;
+			snapshot->Write(s->m_count);
+			snapshot->Write(s->m_vertices, s->m_count * sizeof(b2Vec2));
+			snapshot->Write(s->m_prevVertex);
+			snapshot->Write(s->m_nextVertex);
+			snapshot->Write(s->m_hasPrevVertex);
+			snapshot->Write(s->m_hasNextVertex);
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+
+	snapshot->Write(m_density);
+	snapshot->Write(m_friction);
+	snapshot->Write(m_restitution);
+	snapshot->Write(m_filter);
+	snapshot->Write(m_isSensor);
+	snapshot->Write(m_userData);
+
+	snapshot->Write(m_proxyCount);
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		const b2FixtureProxy* proxy = m_proxies + i;
+		snapshot->Write(proxy->aabb);
+		snapshot->Write(proxy->proxyId);
+	}
+}
+
+void b2Fixture::Load(b2BlockAllocator* allocator, b2Body* body, b2SnapshotReader* reader, b2BroadPhase* broadPhase)
+{
+	b2CircleShape circle;
+	b2EdgeShape edge;
+	b2PolygonShape polygon;
+	b2ChainShape chain;
+
+	b2FixtureDef def;
+
+	b2Shape::Type type;
+	float32 radius;
+	reader->Read(&type);
+	reader->Read(&radius);
+
+	switch (type)
+	{
+	case b2Shape::e_circle:
+		{
+			reader->Read(&circle.m_p);
+			def.shape = &circle;
+		}
+		break;
+
+	case b2Shape::e_edge:
+		{
+			reader->Read(&edge.m_vertex0);
+			reader->Read(&edge.m_vertex1);
+			reader->Read(&edge.m_vertex2);
+			reader->Read(&edge.m_vertex3);
+			reader->Read(&edge.m_hasVertex0);
+			reader->Read(&edge.m_hasVertex3);
+			def.shape = &edge;
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			int32 vertexCount;
+			reader->Read(&polygon.m_centroid);
+			reader->Read(&vertexCount);
+			polygon.SetVertexCount(vertexCount);
+			reader->Read(polygon.m_vertices, polygon.m_vertexCount * sizeof(b2Vec2));
+			reader->Read(polygon.m_normals, polygon.m_vertexCount * sizeof(b2Vec2));
+			def.shape = &polygon;
+		}
+		break;
+
+	case b2Shape::e_chain:
+		{
+			// The destructor frees the vertices after the fixture clones them.
+			reader->Read(&chain.m_count);
+			chain.m_vertices = (b2Vec2*)b2Alloc(chain.m_count * sizeof(b2Vec2));
+			reader->Read(chain.m_vertices, chain.m_count * sizeof(b2Vec2));
+			reader->Read(&chain.m_prevVertex);
+			reader->Read(&chain.m_nextVertex);
+			reader->Read(&chain.m_hasPrevVertex);
+			reader->Read(&chain.m_hasNextVertex);
+			def.shape = &chain;
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		return;
+	}
+
+	reader->Read(&def.density);
+	reader->Read(&def.friction);
+	reader->Read(&def.restitution);
+	reader->Read(&def.filter);
+	reader->Read(&def.isSensor);
+	reader->Read(&def.userData);
+
+	Create(allocator, body, &def);
+	m_shape->m_radius = radius;
+
+	reader->Read(&m_proxyCount);
+	b2Assert(m_proxyCount == 0 || m_proxyCount == m_shape->GetChildCount());
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		b2FixtureProxy* proxy = m_proxies + i;
+		reader->Read(&proxy->aabb);
+		reader->Read(&proxy->proxyId);
+		proxy->fixture = this;
+		proxy->childIndex = i;
+		broadPhase->SetUserData(proxy->proxyId, proxy);
+	}
+}
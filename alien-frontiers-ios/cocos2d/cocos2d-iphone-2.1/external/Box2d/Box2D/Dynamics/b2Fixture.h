@@ -27,6 +27,8 @@ class b2BlockAllocator;
 class b2Body;
 class b2BroadPhase;
 class b2Fixture;
+class b2Snapshot;
+class b2SnapshotReader;
 
 /// This holds contact filtering data.
 struct b2Filter
@@ -210,11 +212,19 @@ protected:
 	void Destroy(b2BlockAllocator* allocator);
 
 	// These support body activation/deactivation.
-	void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf);
+	void CreateProxies(b2BroadPhase* broadPhase, const b2Transform& xf, int32 tree);
 	void DestroyProxies(b2BroadPhase* broadPhase);
 
 	void Synchronize(b2BroadPhase* broadPhase, const b2Transform& xf1, const b2Transform& xf2);
 
+	// Move the proxies into another broad-phase tree.
+	void SetProxyTree(b2BroadPhase* broadPhase, int32 tree);
+
+	// These support b2World::Save and b2World::Restore. Load creates the fixture
+	// and points the saved broad-phase proxies at it.
+	void Save(b2Snapshot* snapshot) const;
+	void Load(b2BlockAllocator* allocator, b2Body* body, b2SnapshotReader* reader, b2BroadPhase* broadPhase);
+
 	float32 m_density;
 
 	b2Fixture* m_next;
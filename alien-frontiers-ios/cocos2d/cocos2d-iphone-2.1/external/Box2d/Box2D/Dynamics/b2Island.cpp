@@ -24,8 +24,10 @@
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Dynamics/Joints/b2JointSolver.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
+#include <Box2D/Dynamics/b2Profiler.h>
 
 /*
 Position Correction Notes
@@ -150,7 +152,8 @@ b2Island::b2Island(
 	int32 contactCapacity,
 	int32 jointCapacity,
 	b2StackAllocator* allocator,
-	b2ContactListener* listener)
+	b2ContactListener* listener,
+	b2BodyState* state)
 {
 	m_bodyCapacity = bodyCapacity;
 	m_contactCapacity = contactCapacity;
@@ -161,20 +164,39 @@ b2Island::b2Island(
 
 	m_allocator = allocator;
 	m_listener = listener;
+	m_state = state;
+
+	m_statics = NULL;
+	m_staticCount = 0;
+	m_staticCapacity = 0;
+	m_impulses = NULL;
+	m_profiler = NULL;
+	m_threadIndex = 0;
 
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
 
-	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
-	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+	if (m_state != NULL)
+	{
+		m_velocities = m_state->m_velocities;
+		m_positions = m_state->m_positions;
+	}
+	else
+	{
+		m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
+		m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+	}
 }
 
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
-	m_allocator->Free(m_positions);
-	m_allocator->Free(m_velocities);
+	if (m_state == NULL)
+	{
+		m_allocator->Free(m_positions);
+		m_allocator->Free(m_velocities);
+	}
 	m_allocator->Free(m_joints);
 	m_allocator->Free(m_contacts);
 	m_allocator->Free(m_bodies);
@@ -186,6 +208,21 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	float32 h = step.dt;
 
+	// Shared static bodies only provide state to the constraints. The world
+	// body state holds it already.
+	if (m_state == NULL)
+	{
+		for (int32 i = 0; i < m_staticCount; ++i)
+		{
+			b2Body* b = m_statics[i];
+			int32 index = b->m_islandIndex;
+			m_positions[index].c = b->m_sweep.c;
+			m_positions[index].a = b->m_sweep.a;
+			m_velocities[index].v = b->m_linearVelocity;
+			m_velocities[index].w = b->m_angularVelocity;
+		}
+	}
+
 	// Integrate velocities and apply damping. Initialize the body state.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
@@ -217,20 +254,15 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			w *= b2Clamp(1.0f - h * b->m_angularDamping, 0.0f, 1.0f);
 		}
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		int32 index = b->m_islandIndex;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 	}
 
 	timer.Reset();
 
-	// Solver data
-	b2SolverData solverData;
-	solverData.step = step;
-	solverData.positions = m_positions;
-	solverData.velocities = m_velocities;
-
 	// Initialize velocity constraints.
 	b2ContactSolverDef contactSolverDef;
 	contactSolverDef.step = step;
@@ -248,36 +280,42 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		contactSolver.WarmStart();
 	}
 
-	for (int32 i = 0; i < m_jointCount; ++i)
-	{
-		m_joints[i]->InitVelocityConstraints(solverData);
-	}
+	b2JointSolverDef jointSolverDef;
+	jointSolverDef.step = step;
+	jointSolverDef.joints = m_joints;
+	jointSolverDef.count = m_jointCount;
+	jointSolverDef.positions = m_positions;
+	jointSolverDef.velocities = m_velocities;
+	jointSolverDef.allocator = m_allocator;
+
+	b2JointSolver jointSolver(&jointSolverDef);
+	jointSolver.InitVelocityConstraints();
 
 	profile->solveInit = timer.GetMilliseconds();
 
 	// Solve velocity constraints
 	timer.Reset();
+	b2ProfileBegin(m_profiler, velocityBegin);
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(solverData);
-		}
-
+		jointSolver.SolveVelocityConstraints();
 		contactSolver.SolveVelocityConstraints();
 	}
+	b2ProfileEnd(m_profiler, m_threadIndex, "Velocity iterations", velocityBegin, m_bodyCount);
 
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
+	jointSolver.StoreImpulses();
 	profile->solveVelocity = timer.GetMilliseconds();
 
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Vec2 c = m_positions[i].c;
-		float32 a = m_positions[i].a;
-		b2Vec2 v = m_velocities[i].v;
-		float32 w = m_velocities[i].w;
+		int32 index = m_state != NULL ? m_bodies[i]->m_islandIndex : i;
+		b2Vec2 c = m_positions[index].c;
+		float32 a = m_positions[index].a;
+		b2Vec2 v = m_velocities[index].v;
+		float32 w = m_velocities[index].w;
 
 		// Check for large velocities
 		b2Vec2 translation = h * v;
@@ -298,25 +336,21 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 		c += h * v;
 		a += h * w;
 
-		m_positions[i].c = c;
-		m_positions[i].a = a;
-		m_velocities[i].v = v;
-		m_velocities[i].w = w;
+		m_positions[index].c = c;
+		m_positions[index].a = a;
+		m_velocities[index].v = v;
+		m_velocities[index].w = w;
 	}
 
 	// Solve position constraints
 	timer.Reset();
+	b2ProfileBegin(m_profiler, positionBegin);
 	bool positionSolved = false;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
 
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
-		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(solverData);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+		bool jointsOkay = jointSolver.SolvePositionConstraints();
 
 		if (contactsOkay && jointsOkay)
 		{
@@ -325,15 +359,17 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 			break;
 		}
 	}
+	b2ProfileEnd(m_profiler, m_threadIndex, "Position iterations", positionBegin, m_bodyCount);
 
 	// Copy state buffers back to the bodies
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* body = m_bodies[i];
-		body->m_sweep.c = m_positions[i].c;
-		body->m_sweep.a = m_positions[i].a;
-		body->m_linearVelocity = m_velocities[i].v;
-		body->m_angularVelocity = m_velocities[i].w;
+		int32 index = body->m_islandIndex;
+		body->m_sweep.c = m_positions[index].c;
+		body->m_sweep.a = m_positions[index].a;
+		body->m_linearVelocity = m_velocities[index].v;
+		body->m_angularVelocity = m_velocities[index].w;
 		body->SynchronizeTransform();
 	}
 
@@ -383,6 +419,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiIndexB)
 {
+	b2Assert(m_state == NULL);
 	b2Assert(toiIndexA < m_bodyCount);
 	b2Assert(toiIndexB < m_bodyCount);
 
@@ -508,6 +545,7 @@ void b2Island::SolveTOI(const b2TimeStep& subStep, int32 toiIndexA, int32 toiInd
 		body->m_linearVelocity = v;
 		body->m_angularVelocity = w;
 		body->SynchronizeTransform();
+		body->StoreState();
 	}
 
 	Report(contactSolver.m_velocityConstraints);
@@ -534,6 +572,13 @@ void b2Island::Report(const b2ContactVelocityConstraint* constraints)
 			impulse.tangentImpulses[j] = vc->points[j].tangentImpulse;
 		}
 
-		m_listener->PostSolve(c, &impulse);
+		if (m_impulses != NULL)
+		{
+			m_impulses[i] = impulse;
+		}
+		else
+		{
+			m_listener->PostSolve(c, &impulse);
+		}
 	}
 }
@@ -27,7 +27,10 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2Profiler;
+class b2BodyState;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -35,7 +38,7 @@ class b2Island
 {
 public:
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
-			b2StackAllocator* allocator, b2ContactListener* listener);
+			b2StackAllocator* allocator, b2ContactListener* listener, b2BodyState* state);
 	~b2Island();
 
 	void Clear()
@@ -51,8 +54,15 @@ public:
 
 	void Add(b2Body* body)
 	{
+		if (m_statics != NULL && body->m_type == b2_staticBody)
+		{
+			b2Assert(m_staticCount < m_staticCapacity);
+			m_statics[m_staticCount++] = body;
+			return;
+		}
+
 		b2Assert(m_bodyCount < m_bodyCapacity);
-		body->m_islandIndex = m_bodyCount;
+		body->m_islandIndex = m_state != NULL ? body->m_stateIndex : m_bodyCount;
 		m_bodies[m_bodyCount] = body;
 		++m_bodyCount;
 	}
@@ -81,6 +91,23 @@ public:
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
 
+	// When set, the solver works on the world body state. The island index of a
+	// body is its state index and m_positions and m_velocities are not owned.
+	b2BodyState* m_state;
+
+	// Islands solved by tasks share static bodies. When m_statics is set, static
+	// bodies are kept out of m_bodies and the world assigns their m_islandIndex.
+	b2Body** m_statics;
+	int32 m_staticCount;
+	int32 m_staticCapacity;
+
+	// When set, contact impulses are stored here instead of being reported.
+	b2ContactImpulse* m_impulses;
+
+	// Zones are recorded with the index of the solving thread.
+	b2Profiler* m_profiler;
+	int32 m_threadIndex;
+
 	int32 m_bodyCount;
 	int32 m_jointCount;
 	int32 m_contactCount;
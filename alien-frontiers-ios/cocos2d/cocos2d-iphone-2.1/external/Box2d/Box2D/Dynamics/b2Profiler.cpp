@@ -0,0 +1,288 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2Profiler.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+static uint64 b2GetTicks()
+{
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceCounter(&largeInteger);
+	return uint64(largeInteger.QuadPart);
+}
+
+static float64 b2GetTickPeriod()
+{
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceFrequency(&largeInteger);
+	return 1.0e6 / float64(largeInteger.QuadPart);
+}
+
+#elif defined(__APPLE__)
+
+#include <mach/mach_time.h>
+
+static uint64 b2GetTicks()
+{
+	return mach_absolute_time();
+}
+
+static float64 b2GetTickPeriod()
+{
+	mach_timebase_info_data_t info;
+	mach_timebase_info(&info);
+	return 1.0e-3 * float64(info.numer) / float64(info.denom);
+}
+
+#elif defined(__linux__)
+
+#include <time.h>
+
+static uint64 b2GetTicks()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64(t.tv_sec) * 1000000000ULL + uint64(t.tv_nsec);
+}
+
+static float64 b2GetTickPeriod()
+{
+	return 1.0e-3;
+}
+
+#else
+
+static uint64 b2GetTicks()
+{
+	return 0;
+}
+
+static float64 b2GetTickPeriod()
+{
+	return 0.0;
+}
+
+#endif
+
+static float64 b2_tickPeriod = 0.0;
+
+static const char* b2_shapeNames[b2Shape::e_typeCount] =
+{
+	"circle",
+	"edge",
+	"polygon",
+	"chain"
+};
+
+b2Profiler::b2Profiler()
+{
+	if (b2_tickPeriod == 0.0)
+	{
+		b2_tickPeriod = b2GetTickPeriod();
+	}
+
+	for (int32 i = 0; i < b2_maxProfileThreads; ++i)
+	{
+		m_threads[i].events = NULL;
+		m_threads[i].eventCount = 0;
+		m_threads[i].eventCapacity = 0;
+	}
+
+	m_steps = NULL;
+	m_stepCount = 0;
+	m_stepCapacity = 0;
+
+	Clear();
+
+	m_start = b2GetTicks();
+}
+
+b2Profiler::~b2Profiler()
+{
+	for (int32 i = 0; i < b2_maxProfileThreads; ++i)
+	{
+		b2Free(m_threads[i].events);
+	}
+
+	b2Free(m_steps);
+}
+
+void b2Profiler::Clear()
+{
+	for (int32 i = 0; i < b2_maxProfileThreads; ++i)
+	{
+		m_threads[i].eventCount = 0;
+		memset(m_threads[i].narrowPhase, 0, sizeof(m_threads[i].narrowPhase));
+	}
+
+	m_stepCount = 0;
+	memset(&m_counters, 0, sizeof(m_counters));
+}
+
+float64 b2Profiler::GetTime() const
+{
+	return b2_tickPeriod * float64(b2GetTicks() - m_start);
+}
+
+void b2Profiler::AddEvent(const char* name, int32 threadIndex, float64 begin, float64 end, int32 size)
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxProfileThreads);
+	b2ProfileThread* thread = m_threads + threadIndex;
+
+	if (thread->eventCount == thread->eventCapacity)
+	{
+		int32 capacity = b2Max(2 * thread->eventCapacity, 256);
+		b2ProfileEvent* events = (b2ProfileEvent*)b2Alloc(capacity * sizeof(b2ProfileEvent));
+		if (thread->events != NULL)
+		{
+			memcpy(events, thread->events, thread->eventCount * sizeof(b2ProfileEvent));
+			b2Free(thread->events);
+		}
+		thread->events = events;
+		thread->eventCapacity = capacity;
+	}
+
+	b2ProfileEvent* event = thread->events + thread->eventCount;
+	event->name = name;
+	event->begin = begin;
+	event->duration = end - begin;
+	event->threadIndex = threadIndex;
+	event->size = size;
+	++thread->eventCount;
+}
+
+void b2Profiler::AddNarrowPhase(int32 threadIndex, b2Shape::Type typeA, b2Shape::Type typeB, float64 begin, int32 count)
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxProfileThreads);
+	b2ProfileNarrowPhase* narrowPhase = &m_threads[threadIndex].narrowPhase[typeA][typeB];
+	narrowPhase->time += GetTime() - begin;
+	narrowPhase->count += count;
+}
+
+void b2Profiler::EndStep()
+{
+	if (m_stepCount == m_stepCapacity)
+	{
+		int32 capacity = b2Max(2 * m_stepCapacity, 64);
+		b2ProfileStep* steps = (b2ProfileStep*)b2Alloc(capacity * sizeof(b2ProfileStep));
+		if (m_steps != NULL)
+		{
+			memcpy(steps, m_steps, m_stepCount * sizeof(b2ProfileStep));
+			b2Free(m_steps);
+		}
+		m_steps = steps;
+		m_stepCapacity = capacity;
+	}
+
+	b2ProfileStep* step = m_steps + m_stepCount;
+	++m_stepCount;
+
+	step->end = GetTime();
+	step->counters = m_counters;
+	memset(&m_counters, 0, sizeof(m_counters));
+
+	// Sum the narrow-phase times of all threads.
+	memset(step->narrowPhase, 0, sizeof(step->narrowPhase));
+	for (int32 i = 0; i < b2_maxProfileThreads; ++i)
+	{
+		for (int32 typeA = 0; typeA < b2Shape::e_typeCount; ++typeA)
+		{
+			for (int32 typeB = 0; typeB < b2Shape::e_typeCount; ++typeB)
+			{
+				b2ProfileNarrowPhase* source = &m_threads[i].narrowPhase[typeA][typeB];
+				b2ProfileNarrowPhase* target = &step->narrowPhase[typeA][typeB];
+				target->time += source->time;
+				target->count += source->count;
+				source->time = 0.0;
+				source->count = 0;
+			}
+		}
+	}
+}
+
+// Zones become complete events ("X") and the step data becomes counter events
+// ("C"). All events use process 1 and the thread index as the thread id.
+bool b2Profiler::WriteChromeTrace(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	for (int32 i = 0; i < b2_maxProfileThreads; ++i)
+	{
+		const b2ProfileThread* thread = m_threads + i;
+		for (int32 j = 0; j < thread->eventCount; ++j)
+		{
+			const b2ProfileEvent* e = thread->events + j;
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+				first ? "" : ",\n", e->name, e->threadIndex, e->begin, e->duration);
+			if (e->size >= 0)
+			{
+				fprintf(file, ",\"args\":{\"bodies\":%d}", e->size);
+			}
+			fprintf(file, "}");
+			first = false;
+		}
+	}
+
+	for (int32 i = 0; i < m_stepCount; ++i)
+	{
+		const b2ProfileStep* s = m_steps + i;
+		const b2ProfileCounters* c = &s->counters;
+		fprintf(file, "%s{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{"
+			"\"islands\":%d,\"contacts\":%d,\"proxy moves\":%d,\"toi events\":%d,\"stack fallbacks\":%d}}",
+			first ? "" : ",\n", s->end, c->islandCount, c->contactCount, c->proxyMoveCount,
+			c->toiEventCount, c->stackFallbackCount);
+		first = false;
+
+		fprintf(file, ",\n{\"name\":\"narrow-phase us\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{", s->end);
+		bool firstArg = true;
+		for (int32 typeA = 0; typeA < b2Shape::e_typeCount; ++typeA)
+		{
+			for (int32 typeB = 0; typeB < b2Shape::e_typeCount; ++typeB)
+			{
+				const b2ProfileNarrowPhase* n = &s->narrowPhase[typeA][typeB];
+				if (n->count == 0)
+				{
+					continue;
+				}
+
+				fprintf(file, "%s\"%s-%s\":%.3f", firstArg ? "" : ",",
+					b2_shapeNames[typeA], b2_shapeNames[typeB], n->time);
+				firstArg = false;
+			}
+		}
+		fprintf(file, "}}");
+	}
+
+	fprintf(file, "\n]}\n");
+
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
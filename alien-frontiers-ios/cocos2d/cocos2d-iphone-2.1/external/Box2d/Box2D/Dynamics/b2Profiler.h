@@ -0,0 +1,204 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PROFILER_H
+#define B2_PROFILER_H
+
+#include <Box2D/Common/b2Settings.h>
+#include <Box2D/Collision/Shapes/b2Shape.h>
+
+const int32 b2_maxProfileThreads = 32;
+
+/// A timed zone of work. Times are in microseconds since the profiler was created.
+struct b2ProfileEvent
+{
+	const char* name;
+	float64 begin;
+	float64 duration;
+	int32 threadIndex;
+	int32 size;			///< the number of bodies of an island, or -1
+};
+
+/// Counts for one time step.
+struct b2ProfileCounters
+{
+	int32 islandCount;			///< islands solved
+	int32 contactCount;			///< contacts at the end of the step
+	int32 proxyMoveCount;		///< proxies moved in the broad-phase
+	int32 toiEventCount;		///< TOI sub-steps
+	int32 stackFallbackCount;	///< stack allocations that used b2Alloc so far
+};
+
+/// Narrow-phase time for one pair of shape types.
+struct b2ProfileNarrowPhase
+{
+	float64 time;	///< microseconds
+	int32 count;	///< manifolds computed
+};
+
+/// The counters and narrow-phase totals of a time step.
+struct b2ProfileStep
+{
+	float64 end;
+	b2ProfileCounters counters;
+	b2ProfileNarrowPhase narrowPhase[b2Shape::e_typeCount][b2Shape::e_typeCount];
+};
+
+/// Records timed zones, counters and narrow-phase times of b2World::Step.
+/// Register it with b2World::SetProfiler. Box2D only records when it is built
+/// with B2_PROFILER defined; otherwise the instrumentation compiles to nothing.
+/// The events of all steps are kept until Clear is called.
+class b2Profiler
+{
+public:
+	b2Profiler();
+	~b2Profiler();
+
+	/// Forget all events and steps.
+	void Clear();
+
+	/// Get the time since construction in microseconds.
+	float64 GetTime() const;
+
+	/// Add a zone. Each thread index must be used by one thread at a time.
+	void AddEvent(const char* name, int32 threadIndex, float64 begin, float64 end, int32 size);
+
+	/// Add the narrow-phase time since begin of count manifolds of a pair of shape types.
+	void AddNarrowPhase(int32 threadIndex, b2Shape::Type typeA, b2Shape::Type typeB, float64 begin, int32 count);
+
+	/// The counters of the current step. Only the world thread may change these.
+	b2ProfileCounters* GetCounters();
+
+	/// Close the current step. Called by b2World::Step.
+	void EndStep();
+
+	/// Get the events recorded by a thread.
+	int32 GetEventCount(int32 threadIndex) const;
+	const b2ProfileEvent* GetEvents(int32 threadIndex) const;
+
+	/// Get the closed steps.
+	int32 GetStepCount() const;
+	const b2ProfileStep* GetSteps() const;
+
+	/// Write the events and steps in the Chrome trace event format. Load the
+	/// file in chrome://tracing or a compatible viewer.
+	/// @return false if the file could not be written.
+	bool WriteChromeTrace(const char* fileName) const;
+
+private:
+
+	struct b2ProfileThread
+	{
+		b2ProfileEvent* events;
+		int32 eventCount;
+		int32 eventCapacity;
+		b2ProfileNarrowPhase narrowPhase[b2Shape::e_typeCount][b2Shape::e_typeCount];
+	};
+
+	b2ProfileThread m_threads[b2_maxProfileThreads];
+
+	b2ProfileStep* m_steps;
+	int32 m_stepCount;
+	int32 m_stepCapacity;
+
+	b2ProfileCounters m_counters;
+
+	uint64 m_start;
+};
+
+inline b2ProfileCounters* b2Profiler::GetCounters()
+{
+	return &m_counters;
+}
+
+inline int32 b2Profiler::GetEventCount(int32 threadIndex) const
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxProfileThreads);
+	return m_threads[threadIndex].eventCount;
+}
+
+inline const b2ProfileEvent* b2Profiler::GetEvents(int32 threadIndex) const
+{
+	b2Assert(0 <= threadIndex && threadIndex < b2_maxProfileThreads);
+	return m_threads[threadIndex].events;
+}
+
+inline int32 b2Profiler::GetStepCount() const
+{
+	return m_stepCount;
+}
+
+inline const b2ProfileStep* b2Profiler::GetSteps() const
+{
+	return m_steps;
+}
+
+/// Times a zone from construction to destruction. A NULL profiler is ignored.
+class b2ProfileScope
+{
+public:
+	b2ProfileScope(b2Profiler* profiler, int32 threadIndex, const char* name, int32 size = -1)
+	{
+		m_profiler = profiler;
+		m_threadIndex = threadIndex;
+		m_name = name;
+		m_size = size;
+		m_begin = profiler != NULL ? profiler->GetTime() : 0.0;
+	}
+
+	~b2ProfileScope()
+	{
+		if (m_profiler != NULL)
+		{
+			m_profiler->AddEvent(m_name, m_threadIndex, m_begin, m_profiler->GetTime(), m_size);
+		}
+	}
+
+private:
+	b2Profiler* m_profiler;
+	const char* m_name;
+	float64 m_begin;
+	int32 m_threadIndex;
+	int32 m_size;
+};
+
+/// Instrumentation used inside Box2D. These compile to nothing unless
+/// B2_PROFILER is defined. b2ProfileZone times the rest of the enclosing block,
+/// so use at most one per block. b2ProfileBegin and b2ProfileEnd time a zone
+/// that is not a block. b2ProfileManifolds adds the narrow-phase time of count
+/// contacts with the shape types of the given contact.
+#if defined(B2_PROFILER)
+#define b2ProfileZone(profiler, threadIndex, name) \
+	b2ProfileScope b2_profileScope(profiler, threadIndex, name)
+#define b2ProfileBegin(profiler, begin) \
+	float64 begin = (profiler) != NULL ? (profiler)->GetTime() : 0.0
+#define b2ProfileEnd(profiler, threadIndex, name, begin, size) \
+	if (profiler) { (profiler)->AddEvent(name, threadIndex, begin, (profiler)->GetTime(), size); }
+#define b2ProfileManifolds(profiler, threadIndex, contact, begin, count) \
+	if (profiler) { (profiler)->AddNarrowPhase(threadIndex, (contact)->GetFixtureA()->GetType(), (contact)->GetFixtureB()->GetType(), begin, count); }
+#define b2ProfileCount(profiler, counter, n) \
+	if (profiler) { (profiler)->GetCounters()->counter += (n); }
+#else
+#define b2ProfileZone(profiler, threadIndex, name)
+#define b2ProfileBegin(profiler, begin)
+#define b2ProfileEnd(profiler, threadIndex, name, begin, size)
+#define b2ProfileManifolds(profiler, threadIndex, contact, begin, count)
+#define b2ProfileCount(profiler, counter, n)
+#endif
+
+#endif
@@ -43,6 +43,8 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool wideContactSolver;
+	bool wideJointSolver;
 };
 
 /// This is an internal structure.
@@ -0,0 +1,146 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_SOLVER_H
+#define B2_WIDE_SOLVER_H
+
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+// Helpers shared by the wide contact and joint solvers. These solve four
+// constraints at a time, one per lane. The lanes of a batch must not share a
+// body that the constraints move, so the constraints are colored first.
+
+// Bits in the body color masks.
+const int32 b2_wideColorCount = 32;
+
+// Constraints that don't find a free color are solved one at a time.
+const int32 b2_wideOverflowColor = b2_wideColorCount;
+
+// Padding lanes use index -1 and have zero mass, so they never apply an impulse.
+inline void b2GatherVelocities(b2FloatW* vx, b2FloatW* vy, b2FloatW* w,
+							   const b2Velocity* velocities, const int32* indices)
+{
+	float32 x[4], y[4], z[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		int32 index = indices[i];
+		if (index < 0)
+		{
+			x[i] = 0.0f;
+			y[i] = 0.0f;
+			z[i] = 0.0f;
+			continue;
+		}
+
+		const b2Velocity* v = velocities + index;
+		x[i] = v->v.x;
+		y[i] = v->v.y;
+		z[i] = v->w;
+	}
+
+	*vx = b2LoadW(x);
+	*vy = b2LoadW(y);
+	*w = b2LoadW(z);
+}
+
+inline void b2ScatterVelocities(b2Velocity* velocities, const int32* indices,
+									   b2FloatW vx, b2FloatW vy, b2FloatW w)
+{
+	float32 x[4], y[4], z[4];
+	b2StoreW(x, vx);
+	b2StoreW(y, vy);
+	b2StoreW(z, w);
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		int32 index = indices[i];
+		if (index < 0)
+		{
+			continue;
+		}
+
+		b2Velocity* v = velocities + index;
+		v->v.Set(x[i], y[i]);
+		v->w = z[i];
+	}
+}
+
+inline void b2GatherPositions(b2FloatW* cx, b2FloatW* cy, b2FloatW* a,
+									 const b2Position* positions, const int32* indices)
+{
+	float32 x[4], y[4], z[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		int32 index = indices[i];
+		if (index < 0)
+		{
+			x[i] = 0.0f;
+			y[i] = 0.0f;
+			z[i] = 0.0f;
+			continue;
+		}
+
+		const b2Position* p = positions + index;
+		x[i] = p->c.x;
+		y[i] = p->c.y;
+		z[i] = p->a;
+	}
+
+	*cx = b2LoadW(x);
+	*cy = b2LoadW(y);
+	*a = b2LoadW(z);
+}
+
+inline void b2ScatterPositions(b2Position* positions, const int32* indices,
+									  b2FloatW cx, b2FloatW cy, b2FloatW a)
+{
+	float32 x[4], y[4], z[4];
+	b2StoreW(x, cx);
+	b2StoreW(y, cy);
+	b2StoreW(z, a);
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		int32 index = indices[i];
+		if (index < 0)
+		{
+			continue;
+		}
+
+		b2Position* p = positions + index;
+		p->c.Set(x[i], y[i]);
+		p->a = z[i];
+	}
+}
+
+// Compute the rotation of each lane, like b2Rot::Set.
+inline void b2SinCosW(b2FloatW* s, b2FloatW* c, b2FloatW angle)
+{
+	float32 a[4], x[4], y[4];
+	b2StoreW(a, angle);
+	for (int32 i = 0; i < 4; ++i)
+	{
+		x[i] = b2Sin(a[i]);
+		y[i] = b2Cos(a[i]);
+	}
+	*s = b2LoadW(x);
+	*c = b2LoadW(y);
+}
+
+#endif
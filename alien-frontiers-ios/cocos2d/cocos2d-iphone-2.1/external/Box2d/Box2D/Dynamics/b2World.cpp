@@ -20,9 +20,11 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2Profiler.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2TOIQueue.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
@@ -31,6 +33,8 @@
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Snapshot.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 #include <Box2D/Common/b2Timer.h>
 #include <new>
 
@@ -48,6 +52,10 @@ b2World::b2World(const b2Vec2& gravity)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 	m_subStepping = false;
+	m_wideContactSolver = false;
+	m_wideJointSolver = false;
+	m_parallelCollide = true;
+	m_bodyStateArrays = false;
 
 	m_stepComplete = true;
 
@@ -60,7 +68,13 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_taskScheduler = NULL;
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+	m_stackSize = b2_stackSize;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
+	m_profiler = NULL;
 }
 
 b2World::~b2World()
@@ -82,6 +96,196 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+}
+
+void b2World::Reset()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Some shapes allocate using b2Alloc. Everything else lives in the
+	// block allocator and is released with it.
+	b2Body* b = m_bodyList;
+	while (b)
+	{
+		b2Body* bNext = b->m_next;
+
+		b2Fixture* f = b->m_fixtureList;
+		while (f)
+		{
+			b2Fixture* fNext = f->m_next;
+			f->m_proxyCount = 0;
+			f->Destroy(&m_blockAllocator);
+			f = fNext;
+		}
+
+		b = bNext;
+	}
+
+	m_bodyState.Clear();
+
+	m_bodyList = NULL;
+	m_jointList = NULL;
+	m_bodyCount = 0;
+	m_jointCount = 0;
+
+	m_contactManager.Reset();
+	m_blockAllocator.Clear();
+
+	m_flags &= ~e_newFixture;
+	m_stepComplete = true;
+	m_inv_dt0 = 0.0f;
+}
+
+// "b2WS" in the first bytes of a snapshot.
+static const uint32 b2_snapshotMagic = 0x53573262;
+
+void b2World::Save(b2Snapshot* snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	snapshot->Clear();
+	snapshot->Write(b2_snapshotMagic);
+	snapshot->Write(b2_version);
+
+	snapshot->Write(m_gravity);
+	snapshot->Write(m_flags);
+	snapshot->Write(m_allowSleep);
+	snapshot->Write(m_warmStarting);
+	snapshot->Write(m_continuousPhysics);
+	snapshot->Write(m_subStepping);
+	snapshot->Write(m_stepComplete);
+	snapshot->Write(m_inv_dt0);
+
+	m_contactManager.m_broadPhase.Save(snapshot);
+
+	// Bodies and joints are written oldest first. Restore prepends them like
+	// CreateBody and CreateJoint do, so all lists keep their order, and with
+	// it the island and solver order.
+	b2Body* b = m_bodyList;
+	while (b && b->m_next)
+	{
+		b = b->m_next;
+	}
+
+	snapshot->Write(m_bodyCount);
+	int32 i = 0;
+	for (; b; b = b->m_prev)
+	{
+		b->m_islandIndex = i;
+		b->Save(snapshot);
+		++i;
+	}
+
+	b2Joint* j = m_jointList;
+	while (j && j->m_next)
+	{
+		j = j->m_next;
+	}
+
+	snapshot->Write(m_jointCount);
+	i = 0;
+	for (; j; j = j->m_prev)
+	{
+		j->m_index = i;
+		j->Save(snapshot);
+		++i;
+	}
+
+	m_contactManager.Save(snapshot);
+}
+
+void b2World::Restore(const b2Snapshot& snapshot)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2SnapshotReader reader(snapshot);
+
+	uint32 magic;
+	b2Version version;
+	reader.Read(&magic);
+	reader.Read(&version);
+
+	b2Assert(magic == b2_snapshotMagic);
+	b2Assert(version.major == b2_version.major && version.minor == b2_version.minor && version.revision == b2_version.revision);
+	if (magic != b2_snapshotMagic)
+	{
+		return;
+	}
+
+	Reset();
+
+	reader.Read(&m_gravity);
+	reader.Read(&m_flags);
+	reader.Read(&m_allowSleep);
+	reader.Read(&m_warmStarting);
+	reader.Read(&m_continuousPhysics);
+	reader.Read(&m_subStepping);
+	reader.Read(&m_stepComplete);
+	reader.Read(&m_inv_dt0);
+
+	// The fixtures point the broad-phase proxies back at themselves.
+	m_contactManager.m_broadPhase.Load(&reader);
+
+	int32 bodyCount;
+	reader.Read(&bodyCount);
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCount * sizeof(b2Body*));
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2BodyDef bd;
+		void* mem = m_blockAllocator.Allocate(sizeof(b2Body));
+		b2Body* b = new (mem) b2Body(&bd, this);
+		b->Load(&reader);
+		bodies[i] = b;
+
+		if (m_bodyStateArrays)
+		{
+			m_bodyState.Add(b);
+		}
+
+		b->m_prev = NULL;
+		b->m_next = m_bodyList;
+		if (m_bodyList)
+		{
+			m_bodyList->m_prev = b;
+		}
+		m_bodyList = b;
+	}
+	m_bodyCount = bodyCount;
+
+	int32 jointCount;
+	reader.Read(&jointCount);
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(jointCount * sizeof(b2Joint*));
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		b2Joint* j = b2Joint::Load(&reader, bodies, joints, &m_blockAllocator);
+		joints[i] = j;
+		LinkJoint(j);
+	}
+	b2Assert(m_jointCount == jointCount);
+
+	m_contactManager.Load(&reader);
+	b2Assert(reader.IsDone());
+
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(bodies);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -104,6 +308,100 @@ void b2World::SetDebugDraw(b2Draw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_taskScheduler = scheduler;
+
+	if (scheduler != NULL)
+	{
+		m_threadAllocatorCount = scheduler->GetThreadCount();
+		b2Assert(m_threadAllocatorCount > 0);
+		m_threadAllocators = (b2StackAllocator*)b2Alloc(m_threadAllocatorCount * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator(m_stackSize);
+		}
+	}
+}
+
+void b2World::SetProfiler(b2Profiler* profiler)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_profiler = profiler;
+	m_contactManager.m_profiler = profiler;
+}
+
+void b2World::SetBodyStateArrays(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || flag == m_bodyStateArrays)
+	{
+		return;
+	}
+
+	m_bodyStateArrays = flag;
+
+	if (flag == false)
+	{
+		m_bodyState.Clear();
+		return;
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		m_bodyState.Add(b);
+	}
+}
+
+void b2World::SetStackAllocatorSize(int32 size)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_stackSize = size;
+	m_stackAllocator.SetCapacity(size);
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].SetCapacity(size);
+	}
+}
+
+b2StackAllocatorStats b2World::GetStackAllocatorStats() const
+{
+	b2StackAllocatorStats stats = m_stackAllocator.GetStats();
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		const b2StackAllocatorStats& s = m_threadAllocators[i].GetStats();
+		stats.capacity += s.capacity;
+		stats.peakBytes = b2Max(stats.peakBytes, s.peakBytes);
+		stats.fallbackCount += s.fallbackCount;
+		stats.fallbackBytes += s.fallbackBytes;
+	}
+	return stats;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -125,6 +423,11 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	if (m_bodyStateArrays)
+	{
+		m_bodyState.Add(b);
+	}
+
 	return b;
 }
 
@@ -204,45 +507,254 @@ void b2World::DestroyBody(b2Body* b)
 		m_bodyList = b->m_next;
 	}
 
+	if (b->m_state != NULL)
+	{
+		m_bodyState.Remove(b);
+	}
+
 	--m_bodyCount;
 	b->~b2Body();
 	m_blockAllocator.Free(b, sizeof(b2Body));
 }
 
-b2Joint* b2World::CreateJoint(const b2JointDef* def)
+void b2World::CreateBodies(b2Body** bodies, const b2BodyDef* defs, int32 count,
+						   const b2FixtureDef* fixtureDefs, const int32* fixtureCounts)
 {
 	b2Assert(IsLocked() == false);
 	if (IsLocked())
 	{
-		return NULL;
+		return;
 	}
 
-	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+	// Create the bodies and fixtures and count the proxies of each tree.
+	int32 proxyCounts[b2BroadPhase::e_treeCount];
+	for (int32 i = 0; i < b2BroadPhase::e_treeCount; ++i)
+	{
+		proxyCounts[i] = 0;
+	}
 
-	// Connect to the world list.
-	j->m_prev = NULL;
-	j->m_next = m_jointList;
-	if (m_jointList)
+	const b2FixtureDef* fixtureDef = fixtureDefs;
+	for (int32 i = 0; i < count; ++i)
 	{
-		m_jointList->m_prev = j;
+		b2Body* b = CreateBody(defs + i);
+		bodies[i] = b;
+
+		int32 fixtureCount = fixtureCounts != NULL ? fixtureCounts[i] : 0;
+		bool hasDensity = false;
+		for (int32 j = 0; j < fixtureCount; ++j)
+		{
+			void* memory = m_blockAllocator.Allocate(sizeof(b2Fixture));
+			b2Fixture* fixture = new (memory) b2Fixture;
+			fixture->Create(&m_blockAllocator, b, fixtureDef);
+			++fixtureDef;
+
+			fixture->m_next = b->m_fixtureList;
+			b->m_fixtureList = fixture;
+			++b->m_fixtureCount;
+
+			hasDensity = hasDensity || fixture->m_density > 0.0f;
+
+			if (b->m_flags & b2Body::e_activeFlag)
+			{
+				proxyCounts[b->GetProxyTree()] += fixture->m_shape->GetChildCount();
+			}
+		}
+
+		if (hasDensity)
+		{
+			b->ResetMassData();
+		}
+
+		if (fixtureCount > 0)
+		{
+			m_flags |= e_newFixture;
+		}
 	}
-	m_jointList = j;
-	++m_jointCount;
 
-	// Connect to the bodies' doubly linked lists.
-	j->m_edgeA.joint = j;
-	j->m_edgeA.other = j->m_bodyB;
-	j->m_edgeA.prev = NULL;
-	j->m_edgeA.next = j->m_bodyA->m_jointList;
-	if (j->m_bodyA->m_jointList) j->m_bodyA->m_jointList->prev = &j->m_edgeA;
-	j->m_bodyA->m_jointList = &j->m_edgeA;
+	int32 proxyStarts[b2BroadPhase::e_treeCount];
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < b2BroadPhase::e_treeCount; ++i)
+	{
+		proxyStarts[i] = proxyCount;
+		proxyCount += proxyCounts[i];
+	}
 
-	j->m_edgeB.joint = j;
-	j->m_edgeB.other = j->m_bodyA;
-	j->m_edgeB.prev = NULL;
-	j->m_edgeB.next = j->m_bodyB->m_jointList;
-	if (j->m_bodyB->m_jointList) j->m_bodyB->m_jointList->prev = &j->m_edgeB;
-	j->m_bodyB->m_jointList = &j->m_edgeB;
+	if (proxyCount == 0)
+	{
+		return;
+	}
+
+	// Gather the proxies by tree.
+	b2AABB* aabbs = (b2AABB*)b2Alloc(proxyCount * sizeof(b2AABB));
+	void** userData = (void**)b2Alloc(proxyCount * sizeof(void*));
+	int32* proxyIds = (int32*)b2Alloc(proxyCount * sizeof(int32));
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		if ((b->m_flags & b2Body::e_activeFlag) == 0)
+		{
+			continue;
+		}
+
+		int32 tree = b->GetProxyTree();
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->m_proxyCount = f->m_shape->GetChildCount();
+			for (int32 j = 0; j < f->m_proxyCount; ++j)
+			{
+				b2FixtureProxy* proxy = f->m_proxies + j;
+				f->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, j);
+				proxy->fixture = f;
+				proxy->childIndex = j;
+
+				int32 index = proxyStarts[tree]++;
+				aabbs[index] = proxy->aabb;
+				userData[index] = proxy;
+			}
+		}
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+	int32 start = 0;
+	for (int32 i = 0; i < b2BroadPhase::e_treeCount; ++i)
+	{
+		broadPhase->CreateProxies(proxyIds + start, aabbs + start, userData + start, proxyCounts[i], i);
+		start += proxyCounts[i];
+	}
+
+	for (int32 i = 0; i < proxyCount; ++i)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)userData[i];
+		proxy->proxyId = proxyIds[i];
+	}
+
+	b2Free(proxyIds);
+	b2Free(userData);
+	b2Free(aabbs);
+}
+
+void b2World::DestroyBodies(b2Body** bodies, int32 count)
+{
+	b2Assert(m_bodyCount >= count);
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		for (b2Fixture* f = bodies[i]->m_fixtureList; f; f = f->m_next)
+		{
+			proxyCount += f->m_proxyCount;
+		}
+	}
+
+	// The proxies outlive their fixtures until they are all destroyed below.
+	// Nothing reads their user data in between.
+	int32* proxyIds = (int32*)b2Alloc(proxyCount * sizeof(int32));
+	int32 proxyIndex = 0;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+
+		// Delete the attached joints.
+		b2JointEdge* je = b->m_jointList;
+		while (je)
+		{
+			b2JointEdge* je0 = je;
+			je = je->next;
+
+			if (m_destructionListener)
+			{
+				m_destructionListener->SayGoodbye(je0->joint);
+			}
+
+			DestroyJoint(je0->joint);
+
+			b->m_jointList = je;
+		}
+		b->m_jointList = NULL;
+
+		// Delete the attached contacts.
+		b2ContactEdge* ce = b->m_contactList;
+		while (ce)
+		{
+			b2ContactEdge* ce0 = ce;
+			ce = ce->next;
+			m_contactManager.Destroy(ce0->contact);
+		}
+		b->m_contactList = NULL;
+
+		// Delete the attached fixtures.
+		b2Fixture* f = b->m_fixtureList;
+		while (f)
+		{
+			b2Fixture* f0 = f;
+			f = f->m_next;
+
+			if (m_destructionListener)
+			{
+				m_destructionListener->SayGoodbye(f0);
+			}
+
+			for (int32 j = 0; j < f0->m_proxyCount; ++j)
+			{
+				proxyIds[proxyIndex++] = f0->m_proxies[j].proxyId;
+			}
+			f0->m_proxyCount = 0;
+
+			f0->Destroy(&m_blockAllocator);
+			f0->~b2Fixture();
+			m_blockAllocator.Free(f0, sizeof(b2Fixture));
+		}
+		b->m_fixtureList = NULL;
+		b->m_fixtureCount = 0;
+
+		// Remove world body list.
+		if (b->m_prev)
+		{
+			b->m_prev->m_next = b->m_next;
+		}
+
+		if (b->m_next)
+		{
+			b->m_next->m_prev = b->m_prev;
+		}
+
+		if (b == m_bodyList)
+		{
+			m_bodyList = b->m_next;
+		}
+
+		if (b->m_state != NULL)
+		{
+			m_bodyState.Remove(b);
+		}
+
+		--m_bodyCount;
+		b->~b2Body();
+		m_blockAllocator.Free(b, sizeof(b2Body));
+	}
+
+	b2Assert(proxyIndex == proxyCount);
+	m_contactManager.m_broadPhase.DestroyProxies(proxyIds, proxyCount);
+	b2Free(proxyIds);
+}
+
+b2Joint* b2World::CreateJoint(const b2JointDef* def)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	b2Joint* j = b2Joint::Create(def, &m_blockAllocator);
+	LinkJoint(j);
 
 	b2Body* bodyA = def->bodyA;
 	b2Body* bodyB = def->bodyB;
@@ -269,6 +781,34 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	return j;
 }
 
+void b2World::LinkJoint(b2Joint* j)
+{
+	// Connect to the world list.
+	j->m_prev = NULL;
+	j->m_next = m_jointList;
+	if (m_jointList)
+	{
+		m_jointList->m_prev = j;
+	}
+	m_jointList = j;
+	++m_jointCount;
+
+	// Connect to the bodies' doubly linked lists.
+	j->m_edgeA.joint = j;
+	j->m_edgeA.other = j->m_bodyB;
+	j->m_edgeA.prev = NULL;
+	j->m_edgeA.next = j->m_bodyA->m_jointList;
+	if (j->m_bodyA->m_jointList) j->m_bodyA->m_jointList->prev = &j->m_edgeA;
+	j->m_bodyA->m_jointList = &j->m_edgeA;
+
+	j->m_edgeB.joint = j;
+	j->m_edgeB.other = j->m_bodyA;
+	j->m_edgeB.prev = NULL;
+	j->m_edgeB.next = j->m_bodyB->m_jointList;
+	if (j->m_bodyB->m_jointList) j->m_bodyB->m_jointList->prev = &j->m_edgeB;
+	j->m_bodyB->m_jointList = &j->m_edgeB;
+}
+
 void b2World::DestroyJoint(b2Joint* j)
 {
 	b2Assert(IsLocked() == false);
@@ -382,6 +922,83 @@ void b2World::SetAllowSleeping(bool flag)
 	}
 }
 
+// The part of the world island that belongs to one island.
+struct b2IslandRange
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+	int32 staticStart;
+	int32 staticCount;
+	b2Profile profile;
+};
+
+// Solves the islands gathered by b2World::Solve. Islands share no bodies, contacts
+// or joints, so the result does not depend on which thread solves an island.
+class b2SolveIslandTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		b2Assert(0 <= threadIndex && threadIndex < allocatorCount);
+		b2StackAllocator* allocator = allocators + threadIndex;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2IslandRange* range = ranges + i;
+
+			b2Island island(slotCount, range->contactCount, range->jointCount, allocator, listener, state);
+
+			for (int32 j = 0; j < range->bodyCount; ++j)
+			{
+				island.Add(source->m_bodies[range->bodyStart + j]);
+			}
+
+			for (int32 j = 0; j < range->contactCount; ++j)
+			{
+				island.Add(source->m_contacts[range->contactStart + j]);
+			}
+
+			for (int32 j = 0; j < range->jointCount; ++j)
+			{
+				island.Add(source->m_joints[range->jointStart + j]);
+			}
+
+			island.m_statics = source->m_statics + range->staticStart;
+			island.m_staticCount = range->staticCount;
+			island.m_staticCapacity = range->staticCount;
+
+			if (impulses != NULL)
+			{
+				island.m_impulses = impulses + range->contactStart;
+			}
+
+			island.m_profiler = profiler;
+			island.m_threadIndex = threadIndex;
+
+			b2ProfileBegin(profiler, islandBegin);
+			island.Solve(&range->profile, step, gravity, allowSleep);
+			b2ProfileEnd(profiler, threadIndex, "Solve island", islandBegin, range->bodyCount);
+		}
+	}
+
+	const b2Island* source;
+	b2IslandRange* ranges;
+	b2BodyState* state;
+	b2StackAllocator* allocators;
+	int32 allocatorCount;
+	int32 slotCount;
+	b2ContactListener* listener;
+	b2ContactImpulse* impulses;
+	b2Profiler* profiler;
+	b2TimeStep step;
+	b2Vec2 gravity;
+	bool allowSleep;
+};
+
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
@@ -389,17 +1006,46 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	b2BodyState* state = m_bodyStateArrays ? &m_bodyState : NULL;
+
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
 					m_jointCount,
 					&m_stackAllocator,
-					m_contactManager.m_contactListener);
+					m_contactManager.m_contactListener,
+					state);
+	island.m_profiler = m_profiler;
+
+	// With a task scheduler all islands are gathered into the world island
+	// first and then solved in parallel. Static bodies are shared by islands,
+	// so they are kept in a separate list and each gets one slot in the solver
+	// arrays that is the same for all islands. With body state arrays that slot
+	// is the state index.
+	bool useTasks = m_taskScheduler != NULL;
+	b2IslandRange* ranges = NULL;
+	b2Body** staticSlots = NULL;
+	int32 islandCount = 0;
+	int32 staticSlotCount = 0;
+	int32 maxBodyCount = 0;
+	if (useTasks)
+	{
+		// A static body is reached through a contact or joint.
+		int32 staticCapacity = m_contactManager.m_contactCount + m_jointCount;
+		island.m_statics = (b2Body**)m_stackAllocator.Allocate(staticCapacity * sizeof(b2Body*));
+		island.m_staticCapacity = staticCapacity;
+		staticSlots = (b2Body**)m_stackAllocator.Allocate(staticCapacity * sizeof(b2Body*));
+		ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	}
 
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
 	{
 		b->m_flags &= ~b2Body::e_islandFlag;
+		if (useTasks && b->m_type == b2_staticBody)
+		{
+			b->m_islandIndex = state != NULL ? b->m_stateIndex : -1;
+		}
 	}
 	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
 	{
@@ -431,8 +1077,24 @@ void b2World::Solve(const b2TimeStep& step)
 			continue;
 		}
 
+		b2ProfileCount(m_profiler, islandCount, 1);
+		b2ProfileBegin(m_profiler, buildBegin);
+
 		// Reset island and stack.
-		island.Clear();
+		b2IslandRange* range = NULL;
+		if (useTasks)
+		{
+			range = ranges + islandCount;
+			++islandCount;
+			range->bodyStart = island.m_bodyCount;
+			range->contactStart = island.m_contactCount;
+			range->jointStart = island.m_jointCount;
+			range->staticStart = island.m_staticCount;
+		}
+		else
+		{
+			island.Clear();
+		}
 		int32 stackCount = 0;
 		stack[stackCount++] = seed;
 		seed->m_flags |= b2Body::e_islandFlag;
@@ -513,70 +1175,371 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
+				island.Add(je->joint);
+				je->joint->m_islandFlag = true;
+
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < stackSize);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+
+		b2ProfileEnd(m_profiler, 0, "Build island", buildBegin, useTasks ? island.m_bodyCount - range->bodyStart : island.m_bodyCount);
+
+		if (useTasks)
+		{
+			range->bodyCount = island.m_bodyCount - range->bodyStart;
+			range->contactCount = island.m_contactCount - range->contactStart;
+			range->jointCount = island.m_jointCount - range->jointStart;
+			range->staticCount = island.m_staticCount - range->staticStart;
+			maxBodyCount = b2Max(maxBodyCount, range->bodyCount);
+
+			for (int32 i = range->staticStart; i < island.m_staticCount; ++i)
+			{
+				// Allow static bodies to participate in other islands.
+				b2Body* b = island.m_statics[i];
+				b->m_flags &= ~b2Body::e_islandFlag;
+
+				if (b->m_islandIndex == -1)
+				{
+					b->m_islandIndex = staticSlotCount;
+					staticSlots[staticSlotCount] = b;
+					++staticSlotCount;
+				}
+			}
+
+			continue;
+		}
+
+		b2Profile profile;
+		b2ProfileBegin(m_profiler, islandBegin);
+		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		b2ProfileEnd(m_profiler, 0, "Solve island", islandBegin, island.m_bodyCount);
+		m_profile.solveInit += profile.solveInit;
+		m_profile.solveVelocity += profile.solveVelocity;
+		m_profile.solvePosition += profile.solvePosition;
+
+		// Post solve cleanup.
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			// Allow static bodies to participate in other islands.
+			b2Body* b = island.m_bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
+	}
+
+	m_stackAllocator.Free(stack);
+
+	if (useTasks)
+	{
+		// The static slots follow the bodies of the largest island.
+		for (int32 i = 0; i < staticSlotCount; ++i)
+		{
+			staticSlots[i]->m_islandIndex += maxBodyCount;
+		}
+
+		// Contact impulses are buffered and reported on this thread.
+		b2ContactListener* listener = m_contactManager.m_contactListener;
+		b2ContactImpulse* impulses = NULL;
+		if (listener != NULL)
+		{
+			impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(island.m_contactCount * sizeof(b2ContactImpulse));
+		}
+
+		b2SolveIslandTask task;
+		task.source = &island;
+		task.ranges = ranges;
+		task.state = state;
+		task.allocators = m_threadAllocators;
+		task.allocatorCount = m_threadAllocatorCount;
+		task.slotCount = maxBodyCount + staticSlotCount;
+		task.listener = listener;
+		task.impulses = impulses;
+		task.profiler = m_profiler;
+		task.step = step;
+		task.gravity = m_gravity;
+		task.allowSleep = m_allowSleep;
+
+		m_taskScheduler->ParallelFor(&task, islandCount, 1);
+
+		for (int32 i = 0; i < islandCount; ++i)
+		{
+			m_profile.solveInit += ranges[i].profile.solveInit;
+			m_profile.solveVelocity += ranges[i].profile.solveVelocity;
+			m_profile.solvePosition += ranges[i].profile.solvePosition;
+		}
+
+		// Report in the same order as the serial solver.
+		if (listener != NULL)
+		{
+			for (int32 i = 0; i < island.m_contactCount; ++i)
+			{
+				listener->PostSolve(island.m_contacts[i], impulses + i);
+			}
+
+			m_stackAllocator.Free(impulses);
+		}
+
+		m_stackAllocator.Free(ranges);
+		m_stackAllocator.Free(staticSlots);
+		m_stackAllocator.Free(island.m_statics);
+	}
+
+	{
+		b2Timer timer;
+		b2ProfileZone(m_profiler, 0, "Broad-phase");
+		// Synchronize fixtures, check for out of range bodies.
+		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		{
+			// If a body was not in an island then it did not move.
+			if ((b->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				continue;
+			}
+
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			// Update fixtures (for broad-phase). Bodies that fell asleep or woke
+			// up change broad-phase trees.
+			b->SynchronizeFixtures();
+			b->SynchronizeProxyTree();
+		}
+
+		// Look for new contacts.
+		m_contactManager.FindNewContacts();
+		m_profile.broadphase = timer.GetMilliseconds();
+	}
+}
+
+// A contact whose time of impact is computed by b2TOITask.
+struct b2TOICandidate
+{
+	b2Contact* contact;
+	float32 alpha0;
+	b2TOIInput input;
+	b2TOIOutput output;
+};
+
+// Computes the time of impact of candidates. The sweeps are copied into the
+// inputs beforehand, so the candidates do not depend on each other.
+class b2TOITask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		b2ProfileZone(profiler, threadIndex, "Time of impact");
+		b2TOICounters* threadCounters = counters + threadIndex;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2TOICandidate* candidate = candidates + i;
+			b2TimeOfImpact(&candidate->output, &candidate->input, threadCounters);
+		}
+	}
+
+	b2TOICandidate* candidates;
+	b2TOICounters* counters;
+	b2Profiler* profiler;
+};
+
+// The smallest number of TOI candidates worth handing to another thread.
+static const int32 b2_toiRange = 16;
+
+// Look at the pending contacts of the queue and queue the ones that may have
+// a TOI event. The pending contacts are visited in list order and the sweeps are
+// advanced just like a scan of the contact list does, so only the b2TimeOfImpact
+// calls are left for the task scheduler threads.
+void b2World::UpdateTOIQueue(b2TOIQueue* queue)
+{
+	b2ProfileZone(m_profiler, 0, "TOI queue");
+	queue->SortPending();
+
+	int32 pendingCount = queue->GetPendingCount();
+	b2TOICandidate* candidates = (b2TOICandidate*)m_stackAllocator.Allocate(pendingCount * sizeof(b2TOICandidate));
+	int32 candidateCount = 0;
+
+	for (int32 i = 0; i < pendingCount; ++i)
+	{
+		b2Contact* c = queue->GetPending(i);
+		queue->Remove(c);
+
+		// Is this contact disabled?
+		if (c->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// Prevent excessive sub-stepping.
+		if (c->m_toiCount > b2_maxSubSteps)
+		{
+			continue;
+		}
+
+		if (c->m_flags & b2Contact::e_toiFlag)
+		{
+			// This contact has a valid cached TOI.
+			if (c->m_toi < 1.0f)
+			{
+				queue->Push(c);
+			}
+			continue;
+		}
+
+		b2Fixture* fA = c->GetFixtureA();
+		b2Fixture* fB = c->GetFixtureB();
+
+		// Is there a sensor?
+		if (fA->IsSensor() || fB->IsSensor())
+		{
+			continue;
+		}
+
+		b2Body* bA = fA->GetBody();
+		b2Body* bB = fB->GetBody();
+
+		b2BodyType typeA = bA->m_type;
+		b2BodyType typeB = bB->m_type;
+		b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
 
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+		bool activeA = bA->IsAwake() && typeA != b2_staticBody;
+		bool activeB = bB->IsAwake() && typeB != b2_staticBody;
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+		// Is at least one body active (awake and dynamic or kinematic)?
+		if (activeA == false && activeB == false)
+		{
+			continue;
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
+		bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		// Are these two non-bullet dynamic bodies?
+		if (collideA == false && collideB == false)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->GetType() == b2_staticBody)
-			{
-				b->m_flags &= ~b2Body::e_islandFlag;
-			}
+			continue;
+		}
+
+		// Compute the TOI for this contact.
+		// Put the sweeps onto the same time interval.
+		float32 alpha0 = bA->m_sweep.alpha0;
+
+		if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
+		{
+			alpha0 = bB->m_sweep.alpha0;
+			bA->m_sweep.Advance(alpha0);
 		}
+		else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
+		{
+			alpha0 = bA->m_sweep.alpha0;
+			bB->m_sweep.Advance(alpha0);
+		}
+
+		b2Assert(alpha0 < 1.0f);
+
+		int32 indexA = c->GetChildIndexA();
+		int32 indexB = c->GetChildIndexB();
+
+		// Compute the time of impact in interval [0, minTOI]
+		b2TOICandidate* candidate = candidates + candidateCount;
+		candidate->contact = c;
+		candidate->alpha0 = alpha0;
+		candidate->input.proxyA.Set(fA->GetShape(), indexA);
+		candidate->input.proxyB.Set(fB->GetShape(), indexB);
+		candidate->input.sweepA = bA->m_sweep;
+		candidate->input.sweepB = bB->m_sweep;
+		candidate->input.tMax = 1.0f;
+		++candidateCount;
 	}
 
-	m_stackAllocator.Free(stack);
+	queue->ClearPending();
 
+	int32 threadCount = m_taskScheduler != NULL ? m_taskScheduler->GetThreadCount() : 1;
+	b2TOICounters* counters = (b2TOICounters*)m_stackAllocator.Allocate(threadCount * sizeof(b2TOICounters));
+	for (int32 i = 0; i < threadCount; ++i)
 	{
-		b2Timer timer;
-		// Synchronize fixtures, check for out of range bodies.
-		for (b2Body* b = m_bodyList; b; b = b->GetNext())
+		b2ClearTOICounters(counters + i);
+	}
+
+	b2TOITask task;
+	task.candidates = candidates;
+	task.counters = counters;
+	task.profiler = m_profiler;
+
+	if (m_taskScheduler != NULL)
+	{
+		m_taskScheduler->ParallelFor(&task, candidateCount, b2_toiRange);
+	}
+	else
+	{
+		task.Execute(0, candidateCount, 0);
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		b2AddTOICounters(counters[i]);
+	}
+
+	for (int32 i = 0; i < candidateCount; ++i)
+	{
+		b2TOICandidate* candidate = candidates + i;
+		b2Contact* c = candidate->contact;
+		float32 alpha0 = candidate->alpha0;
+
+		// Beta is the fraction of the remaining portion of the .
+		float32 alpha;
+		float32 beta = candidate->output.t;
+		if (candidate->output.state == b2TOIOutput::e_touching)
 		{
-			// If a body was not in an island then it did not move.
-			if ((b->m_flags & b2Body::e_islandFlag) == 0)
-			{
-				continue;
-			}
+			alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
+		}
+		else
+		{
+			alpha = 1.0f;
+		}
 
-			if (b->GetType() == b2_staticBody)
-			{
-				continue;
-			}
+		c->m_toi = alpha;
+		c->m_flags |= b2Contact::e_toiFlag;
 
-			// Update fixtures (for broad-phase).
-			b->SynchronizeFixtures();
+		if (alpha < 1.0f)
+		{
+			queue->Push(c);
 		}
+	}
 
-		// Look for new contacts.
-		m_contactManager.FindNewContacts();
-		m_profile.broadphase = timer.GetMilliseconds();
+	m_stackAllocator.Free(counters);
+	m_stackAllocator.Free(candidates);
+}
+
+// Make the contacts of a body that woke up pending. Contacts between two
+// sleeping bodies are skipped by UpdateTOIQueue, so they must be looked at again.
+static void b2AddWokenContacts(b2TOIQueue* queue, b2Body* body)
+{
+	for (b2ContactEdge* ce = body->GetContactList(); ce; ce = ce->next)
+	{
+		queue->AddPending(ce->contact);
 	}
 }
 
 // Find TOI contacts and solve them.
+// The contact list is scanned for the first TOI event only once. Then the
+// contacts are kept in a queue ordered by TOI and only the contacts touched by
+// the last event are looked at again. These are the contacts of the displaced
+// bodies, the contacts of bodies that woke up and the new contacts. Changes that a
+// contact listener makes to other bodies during TOI events are not tracked.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
-	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener);
+	b2Island island(2 * b2_maxTOIContacts, b2_maxTOIContacts, 0, &m_stackAllocator, m_contactManager.m_contactListener, NULL);
 
 	if (m_stepComplete)
 	{
@@ -595,136 +1558,47 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		}
 	}
 
-	// Find TOI events and solve them.
-	for (;;)
-	{
-		// Find the first TOI.
-		b2Contact* minContact = NULL;
-		float32 minAlpha = 1.0f;
-
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
-		{
-			// Is this contact disabled?
-			if (c->IsEnabled() == false)
-			{
-				continue;
-			}
-
-			// Prevent excessive sub-stepping.
-			if (c->m_toiCount > b2_maxSubSteps)
-			{
-				continue;
-			}
-
-			float32 alpha = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				alpha = c->m_toi;
-			}
-			else
-			{
-				b2Fixture* fA = c->GetFixtureA();
-				b2Fixture* fB = c->GetFixtureB();
-
-				// Is there a sensor?
-				if (fA->IsSensor() || fB->IsSensor())
-				{
-					continue;
-				}
-
-				b2Body* bA = fA->GetBody();
-				b2Body* bB = fB->GetBody();
-
-				b2BodyType typeA = bA->m_type;
-				b2BodyType typeB = bB->m_type;
-				b2Assert(typeA == b2_dynamicBody || typeB == b2_dynamicBody);
-
-				bool activeA = bA->IsAwake() && typeA != b2_staticBody;
-				bool activeB = bB->IsAwake() && typeB != b2_staticBody;
-
-				// Is at least one body active (awake and dynamic or kinematic)?
-				if (activeA == false && activeB == false)
-				{
-					continue;
-				}
-
-				bool collideA = bA->IsBullet() || typeA != b2_dynamicBody;
-				bool collideB = bB->IsBullet() || typeB != b2_dynamicBody;
-
-				// Are these two non-bullet dynamic bodies?
-				if (collideA == false && collideB == false)
-				{
-					continue;
-				}
-
-				// Compute the TOI for this contact.
-				// Put the sweeps onto the same time interval.
-				float32 alpha0 = bA->m_sweep.alpha0;
-
-				if (bA->m_sweep.alpha0 < bB->m_sweep.alpha0)
-				{
-					alpha0 = bB->m_sweep.alpha0;
-					bA->m_sweep.Advance(alpha0);
-				}
-				else if (bB->m_sweep.alpha0 < bA->m_sweep.alpha0)
-				{
-					alpha0 = bA->m_sweep.alpha0;
-					bB->m_sweep.Advance(alpha0);
-				}
-
-				b2Assert(alpha0 < 1.0f);
-
-				int32 indexA = c->GetChildIndexA();
-				int32 indexB = c->GetChildIndexB();
+	b2TOIQueue queue;
 
-				// Compute the time of impact in interval [0, minTOI]
-				b2TOIInput input;
-				input.proxyA.Set(fA->GetShape(), indexA);
-				input.proxyB.Set(fB->GetShape(), indexB);
-				input.sweepA = bA->m_sweep;
-				input.sweepB = bB->m_sweep;
-				input.tMax = 1.0f;
-
-				b2TOIOutput output;
-				b2TimeOfImpact(&output, &input);
+	// New contacts are added to the head of the list, so they get decreasing orders.
+	int32 order = 0;
+	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	{
+		c->m_toiOrder = order++;
+		queue.AddPending(c);
+	}
 
-				// Beta is the fraction of the remaining portion of the .
-				float32 beta = output.t;
-				if (output.state == b2TOIOutput::e_touching)
-				{
-					alpha = b2Min(alpha0 + (1.0f - alpha0) * beta, 1.0f);
-				}
-				else
-				{
-					alpha = 1.0f;
-				}
+	int32 firstOrder = 0;
 
-				c->m_toi = alpha;
-				c->m_flags |= b2Contact::e_toiFlag;
-			}
+	// Find TOI events and solve them.
+	for (;;)
+	{
+		UpdateTOIQueue(&queue);
 
-			if (alpha < minAlpha)
-			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minAlpha = alpha;
-			}
-		}
+		// Find the first TOI.
+		b2Contact* minContact = queue.GetMin();
 
-		if (minContact == NULL || 1.0f - 10.0f * b2_epsilon < minAlpha)
+		if (minContact == NULL || 1.0f - 10.0f * b2_epsilon < minContact->m_toi)
 		{
 			// No more TOI events. Done!
 			m_stepComplete = true;
 			break;
 		}
 
+		b2ProfileZone(m_profiler, 0, "TOI event");
+		b2ProfileCount(m_profiler, toiEventCount, 1);
+
+		float32 minAlpha = minContact->m_toi;
+
 		// Advance the bodies to the TOI.
 		b2Fixture* fA = minContact->GetFixtureA();
 		b2Fixture* fB = minContact->GetFixtureB();
 		b2Body* bA = fA->GetBody();
 		b2Body* bB = fB->GetBody();
 
+		bool sleepingA = bA->IsAwake() == false && bA->m_type != b2_staticBody;
+		bool sleepingB = bB->IsAwake() == false && bB->m_type != b2_staticBody;
+
 		b2Sweep backup1 = bA->m_sweep;
 		b2Sweep backup2 = bB->m_sweep;
 
@@ -735,6 +1609,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		minContact->Update(m_contactManager.m_contactListener);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
+		queue.AddPending(minContact);
 
 		// Is the contact solid?
 		if (minContact->IsEnabled() == false || minContact->IsTouching() == false)
@@ -745,12 +1620,34 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			bB->m_sweep = backup2;
 			bA->SynchronizeTransform();
 			bB->SynchronizeTransform();
+			bA->StoreState();
+			bB->StoreState();
+
+			if (sleepingA && bA->IsAwake())
+			{
+				b2AddWokenContacts(&queue, bA);
+			}
+
+			if (sleepingB && bB->IsAwake())
+			{
+				b2AddWokenContacts(&queue, bB);
+			}
 			continue;
 		}
 
 		bA->SetAwake(true);
 		bB->SetAwake(true);
 
+		if (sleepingA)
+		{
+			b2AddWokenContacts(&queue, bA);
+		}
+
+		if (sleepingB)
+		{
+			b2AddWokenContacts(&queue, bB);
+		}
+
 		// Build the island
 		island.Clear();
 		island.Add(bA);
@@ -804,6 +1701,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
 						continue;
 					}
 
+					bool sleepingOther = other->IsAwake() == false && other->m_type != b2_staticBody;
+
 					// Tentatively advance the body to the TOI.
 					b2Sweep backup = other->m_sweep;
 					if ((other->m_flags & b2Body::e_islandFlag) == 0)
@@ -814,11 +1713,19 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					// Update the contact points
 					contact->Update(m_contactManager.m_contactListener);
 
+					// The update wakes the other body if it starts or stops touching.
+					if (sleepingOther && other->IsAwake())
+					{
+						b2AddWokenContacts(&queue, other);
+						sleepingOther = false;
+					}
+
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
 					{
 						other->m_sweep = backup;
 						other->SynchronizeTransform();
+						other->StoreState();
 						continue;
 					}
 
@@ -827,6 +1734,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					{
 						other->m_sweep = backup;
 						other->SynchronizeTransform();
+						other->StoreState();
 						continue;
 					}
 
@@ -848,6 +1756,11 @@ void b2World::SolveTOI(const b2TimeStep& step)
 						other->SetAwake(true);
 					}
 
+					if (sleepingOther)
+					{
+						b2AddWokenContacts(&queue, other);
+					}
+
 					island.Add(other);
 				}
 			}
@@ -860,6 +1773,8 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.positionIterations = 20;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
+		subStep.wideContactSolver = false;
+		subStep.wideJointSolver = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
 
 		// Reset island flags and synchronize broad-phase proxies.
@@ -879,13 +1794,30 @@ void b2World::SolveTOI(const b2TimeStep& step)
 			for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 			{
 				ce->contact->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+				queue.AddPending(ce->contact);
 			}
 		}
 
 		// Commit fixture proxy movements to the broad-phase so that new contacts are created.
 		// Also, some contacts can be destroyed.
+		b2Contact* oldHead = m_contactManager.m_contactList;
 		m_contactManager.FindNewContacts();
 
+		// Order the new contacts ahead of the old ones.
+		int32 newCount = 0;
+		for (b2Contact* c = m_contactManager.m_contactList; c != oldHead; c = c->m_next)
+		{
+			++newCount;
+		}
+
+		order = firstOrder - newCount;
+		firstOrder = order;
+		for (b2Contact* c = m_contactManager.m_contactList; c != oldHead; c = c->m_next)
+		{
+			c->m_toiOrder = order++;
+			queue.AddPending(c);
+		}
+
 		if (m_subStepping)
 		{
 			m_stepComplete = false;
@@ -897,6 +1829,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
 	b2Timer stepTimer;
+	b2ProfileZone(m_profiler, 0, "Step");
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
@@ -923,11 +1856,15 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.wideContactSolver = m_wideContactSolver;
+	step.wideJointSolver = m_wideJointSolver;
 
 	// Update contacts. This is where some contacts are destroyed.
 	{
 		b2Timer timer;
-		m_contactManager.Collide();
+		b2ProfileZone(m_profiler, 0, "Collide");
+		b2TaskScheduler* scheduler = m_parallelCollide ? m_taskScheduler : NULL;
+		m_contactManager.Collide(scheduler, &m_stackAllocator);
 		m_profile.collide = timer.GetMilliseconds();
 	}
 
@@ -935,6 +1872,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	if (m_stepComplete && step.dt > 0.0f)
 	{
 		b2Timer timer;
+		b2ProfileZone(m_profiler, 0, "Solve");
 		Solve(step);
 		m_profile.solve = timer.GetMilliseconds();
 	}
@@ -943,6 +1881,7 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
 		b2Timer timer;
+		b2ProfileZone(m_profiler, 0, "Solve TOI");
 		SolveTOI(step);
 		m_profile.solveTOI = timer.GetMilliseconds();
 	}
@@ -960,6 +1899,20 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	m_flags &= ~e_locked;
 
 	m_profile.step = stepTimer.GetMilliseconds();
+
+#if defined(B2_PROFILER)
+	if (m_profiler != NULL)
+	{
+		b2ProfileCounters* counters = m_profiler->GetCounters();
+		counters->contactCount = m_contactManager.m_contactCount;
+		counters->stackFallbackCount = m_stackAllocator.GetStats().fallbackCount;
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			counters->stackFallbackCount += m_threadAllocators[i].GetStats().fallbackCount;
+		}
+		m_profiler->EndStep();
+	}
+#endif
 }
 
 void b2World::ClearForces()
@@ -1028,6 +1981,169 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
+// The smallest number of batched queries worth handing to another thread.
+static const int32 b2_batchQueryRange = 32;
+
+// These call no virtual functions for the tree callbacks, so that
+// many small queries stay cheap.
+struct b2WorldQueryBatchWrapper
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+		if ((fixture->GetFilterData().categoryBits & maskBits) != 0)
+		{
+			if (count < capacity)
+			{
+				fixtures[count] = fixture;
+			}
+			++count;
+		}
+		return true;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2Fixture** fixtures;
+	int32 count;
+	int32 capacity;
+	uint16 maskBits;
+};
+
+class b2QueryBatchTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		b2WorldQueryBatchWrapper wrapper;
+		wrapper.broadPhase = broadPhase;
+		wrapper.capacity = capacity;
+		wrapper.maskBits = maskBits;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			wrapper.fixtures = fixtures + i * capacity;
+			wrapper.count = 0;
+			broadPhase->Query(&wrapper, aabbs[i]);
+			counts[i] = wrapper.count;
+		}
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2AABB* aabbs;
+	b2Fixture** fixtures;
+	int32* counts;
+	int32 capacity;
+	uint16 maskBits;
+};
+
+void b2World::QueryAABBBatch(const b2AABB* aabbs, b2Fixture** fixtures, int32* counts,
+							 int32 count, int32 capacity, uint16 maskBits) const
+{
+	b2Assert(capacity >= 0);
+
+	b2QueryBatchTask task;
+	task.broadPhase = &m_contactManager.m_broadPhase;
+	task.aabbs = aabbs;
+	task.fixtures = fixtures;
+	task.counts = counts;
+	task.capacity = capacity;
+	task.maskBits = maskBits;
+
+	if (m_taskScheduler != NULL)
+	{
+		m_taskScheduler->ParallelFor(&task, count, b2_batchQueryRange);
+	}
+	else
+	{
+		task.Execute(0, count, 0);
+	}
+}
+
+struct b2WorldRayCastBatchWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		b2FixtureProxy* proxy = (b2FixtureProxy*)broadPhase->GetUserData(proxyId);
+		b2Fixture* fixture = proxy->fixture;
+
+		// Returning the current max fraction leaves the ray as it is, like -1 does.
+		if ((fixture->GetFilterData().categoryBits & maskBits) == 0)
+		{
+			return input.maxFraction;
+		}
+
+		b2RayCastOutput output;
+		bool hit = fixture->RayCast(&output, input, proxy->childIndex);
+
+		if (hit)
+		{
+			float32 fraction = output.fraction;
+			result->fixture = fixture;
+			result->point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+			result->normal = output.normal;
+			result->fraction = fraction;
+			return fraction;
+		}
+
+		return input.maxFraction;
+	}
+
+	const b2BroadPhase* broadPhase;
+	b2RayCastResult* result;
+	uint16 maskBits;
+};
+
+class b2RayCastBatchTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		b2WorldRayCastBatchWrapper wrapper;
+		wrapper.broadPhase = broadPhase;
+		wrapper.maskBits = maskBits;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2RayCastResult* result = results + i;
+			result->fixture = NULL;
+			result->point.SetZero();
+			result->normal.SetZero();
+			result->fraction = inputs[i].maxFraction;
+
+			wrapper.result = result;
+			broadPhase->RayCast(&wrapper, inputs[i]);
+		}
+	}
+
+	const b2BroadPhase* broadPhase;
+	const b2RayCastInput* inputs;
+	b2RayCastResult* results;
+	uint16 maskBits;
+};
+
+void b2World::RayCastBatch(const b2RayCastInput* inputs, b2RayCastResult* results, int32 count, uint16 maskBits) const
+{
+	b2RayCastBatchTask task;
+	task.broadPhase = &m_contactManager.m_broadPhase;
+	task.inputs = inputs;
+	task.results = results;
+	task.maskBits = maskBits;
+
+	if (m_taskScheduler != NULL)
+	{
+		m_taskScheduler->ParallelFor(&task, count, b2_batchQueryRange);
+	}
+	else
+	{
+		task.Execute(0, count, 0);
+	}
+}
+
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
 {
 	switch (fixture->GetType())
@@ -1256,6 +2372,22 @@ float32 b2World::GetTreeQuality() const
 	return m_contactManager.m_broadPhase.GetTreeQuality();
 }
 
+const b2BlockAllocatorStats& b2World::GetBlockAllocatorStats() const
+{
+	return m_blockAllocator.GetStats();
+}
+
+void b2World::RebuildBroadPhase()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase.RebuildTree();
+}
+
 void b2World::Dump()
 {
 	if ((m_flags & e_locked) == e_locked)
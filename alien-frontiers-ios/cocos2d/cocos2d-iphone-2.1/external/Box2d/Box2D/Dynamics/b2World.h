@@ -25,15 +25,31 @@
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/b2BodyState.h>
 
 struct b2AABB;
 struct b2BodyDef;
+struct b2FixtureDef;
+struct b2RayCastInput;
 struct b2Color;
 struct b2JointDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
 class b2Joint;
+class b2Snapshot;
+class b2Profiler;
+class b2TaskScheduler;
+class b2TOIQueue;
+
+/// The closest hit of a ray, see b2World::RayCastBatch.
+struct b2RayCastResult
+{
+	b2Fixture* fixture;	///< the fixture hit, NULL if the ray hit nothing
+	b2Vec2 point;		///< the point of initial intersection
+	b2Vec2 normal;		///< the normal vector at the point of intersection
+	float32 fraction;	///< the fraction along the ray
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -48,6 +64,26 @@ public:
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
 
+	/// Destroy all bodies, fixtures, joints and contacts at once. The memory of the
+	/// block allocator is released in O(chunk count). The settings, listeners and
+	/// task scheduler are kept. The destruction listener is not called.
+	/// @warning This function is locked during callbacks.
+	void Reset();
+
+	/// Save the state of the world into a snapshot: bodies, fixtures, joints, contacts
+	/// with their warm starting impulses, the broad-phase and the settings that affect
+	/// the simulation, such as gravity. The snapshot memory is reused.
+	/// Listeners, the task scheduler and the solver options are not saved.
+	/// @warning This function is locked during callbacks.
+	void Save(b2Snapshot* snapshot);
+
+	/// Replace everything in the world with a snapshot made by Save with the same
+	/// build of Box2D, possibly by another world. Stepping the restored world gives
+	/// the same results bit for bit as stepping the saved one. This calls Reset, so
+	/// the destruction listener is not called. User data is restored as saved.
+	/// @warning This function is locked during callbacks.
+	void Restore(const b2Snapshot& snapshot);
+
 	/// Register a destruction listener. The listener is owned by you and must
 	/// remain in scope.
 	void SetDestructionListener(b2DestructionListener* listener);
@@ -77,6 +113,22 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyBody(b2Body* body);
 
+	/// Create many bodies at once, like calling CreateBody and CreateFixture for
+	/// each. Body i gets the next fixtureCounts[i] fixtures of fixtureDefs, which
+	/// may be NULL along with fixtureCounts. The broad-phase proxies of all the
+	/// fixtures are added to each tree in one rebuild instead of one insertion
+	/// each, so this is much faster for spawning thousands of bodies.
+	/// @param bodies receives the new bodies.
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(b2Body** bodies, const b2BodyDef* defs, int32 count,
+					  const b2FixtureDef* fixtureDefs, const int32* fixtureCounts);
+
+	/// Destroy many bodies at once, like calling DestroyBody for each. The
+	/// broad-phase proxies of all the fixtures are removed together.
+	/// @warning This automatically deletes all associated shapes and joints.
+	/// @warning This function is locked during callbacks.
+	void DestroyBodies(b2Body** bodies, int32 count);
+
 	/// Create a joint to constrain bodies together. No reference to the definition
 	/// is retained. This may cause the connected bodies to cease colliding.
 	/// @warning This function is locked during callbacks.
@@ -121,6 +173,30 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Query many AABBs. The result of query i is the same as QueryAABB with aabbs[i]
+	/// and a callback that keeps the fixtures whose category bits share a bit with
+	/// maskBits. The queries are spread over the task scheduler threads.
+	/// @param aabbs the query boxes.
+	/// @param fixtures the fixtures of query i are written to fixtures + i * capacity,
+	/// in the order QueryAABB reports them.
+	/// @param counts the number of fixtures found by each query. This may exceed
+	/// capacity, in which case only the first capacity fixtures are written.
+	/// @param count the number of queries.
+	/// @param capacity the room for fixtures per query.
+	/// @param maskBits the fixture categories to report.
+	void QueryAABBBatch(const b2AABB* aabbs, b2Fixture** fixtures, int32* counts,
+						int32 count, int32 capacity, uint16 maskBits) const;
+
+	/// Ray-cast many rays and keep the closest hit of each. The result of ray i is the
+	/// same as RayCast from inputs[i].p1 to inputs[i].p2 with a callback that returns -1
+	/// for fixtures whose category bits share no bit with maskBits, and otherwise keeps
+	/// the hit and returns its fraction. The rays are spread over the task scheduler threads.
+	/// @param inputs the rays. The ray extends from p1 to p1 + maxFraction * (p2 - p1).
+	/// @param results one result per ray.
+	/// @param count the number of rays.
+	/// @param maskBits the fixture categories to hit.
+	void RayCastBatch(const b2RayCastInput* inputs, b2RayCastResult* results, int32 count, uint16 maskBits) const;
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -157,6 +233,46 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Enable/disable the wide contact solver. This solves the position
+	/// constraints of four contacts at a time using SIMD where available. The
+	/// velocity constraints still use the scalar solver. The order in which
+	/// position constraints are solved differs from the scalar solver, so
+	/// results are close but not identical.
+	void SetWideContactSolver(bool flag) { m_wideContactSolver = flag; }
+	bool GetWideContactSolver() const { return m_wideContactSolver; }
+
+	/// Enable/disable the wide joint solver. This groups the joints of an island
+	/// by type and solves four revolute or distance joints at a time using SIMD
+	/// where available. Results are close to the scalar solver but not identical.
+	void SetWideJointSolver(bool flag) { m_wideJointSolver = flag; }
+	bool GetWideJointSolver() const { return m_wideJointSolver; }
+
+	/// Enable/disable computing contact manifolds on the task scheduler threads.
+	/// Contact listener events are reported in the same order either way.
+	void SetParallelCollide(bool flag) { m_parallelCollide = flag; }
+	bool GetParallelCollide() const { return m_parallelCollide; }
+
+	/// Enable/disable keeping the position and velocity of all bodies in contiguous
+	/// arrays that the island solver works on directly. This saves gathering the
+	/// bodies of each island into temporary arrays. Results are identical either way.
+	/// @warning this should be called outside of a time step.
+	void SetBodyStateArrays(bool flag);
+	bool GetBodyStateArrays() const { return m_bodyStateArrays; }
+
+	/// Register a task scheduler to solve islands on several threads. The results
+	/// are the same as solving on the calling thread. Pass NULL to solve on the
+	/// calling thread. The world does not own the scheduler.
+	/// @warning this should be called outside of a time step.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+	b2TaskScheduler* GetTaskScheduler() const { return m_taskScheduler; }
+
+	/// Register a profiler to record zones, counters and narrow-phase times of
+	/// each step. This only records when Box2D is built with B2_PROFILER defined.
+	/// Pass NULL to stop recording. The world does not own the profiler.
+	/// @warning this should be called outside of a time step.
+	void SetProfiler(b2Profiler* profiler);
+	b2Profiler* GetProfiler() const { return m_profiler; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -179,6 +295,25 @@ public:
 	/// The minimum is 1.
 	float32 GetTreeQuality() const;
 
+	/// Get the memory statistics of the allocator used for bodies, fixtures, shapes,
+	/// joints and contacts.
+	const b2BlockAllocatorStats& GetBlockAllocatorStats() const;
+
+	/// Set the initial arena size of the per step stack allocators in bytes.
+	/// The arenas grow to the largest step seen, so this only saves the first
+	/// steps from falling back to b2Alloc. The default is b2_stackSize.
+	/// @warning This function is locked during callbacks.
+	void SetStackAllocatorSize(int32 size);
+
+	/// Get the memory statistics of the per step stack allocators. The capacity
+	/// and fallbacks are summed over the scheduler threads, the peak is the largest.
+	b2StackAllocatorStats GetStackAllocatorStats() const;
+
+	/// Rebuild the dynamic tree in one pass. Call this after creating a lot of
+	/// static geometry, such as a tile map. This does not affect contacts.
+	/// @warning This function is locked during callbacks.
+	void RebuildBroadPhase();
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 
@@ -219,8 +354,11 @@ private:
 	friend class b2ContactManager;
 	friend class b2Controller;
 
+	void LinkJoint(b2Joint* j);
+
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
+	void UpdateTOIQueue(b2TOIQueue* queue);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -228,10 +366,19 @@ private:
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	// One stack allocator per scheduler thread.
+	b2TaskScheduler* m_taskScheduler;
+	b2StackAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+	int32 m_stackSize;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
 
+	// Used when m_bodyStateArrays is set.
+	b2BodyState m_bodyState;
+
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
 
@@ -252,10 +399,15 @@ private:
 	bool m_warmStarting;
 	bool m_continuousPhysics;
 	bool m_subStepping;
+	bool m_wideContactSolver;
+	bool m_wideJointSolver;
+	bool m_parallelCollide;
+	bool m_bodyStateArrays;
 
 	bool m_stepComplete;
 
 	b2Profile m_profile;
+	b2Profiler* m_profiler;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -0,0 +1,488 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Rope/b2RopeBatch.h>
+#include <Box2D/Common/b2Draw.h>
+#include <Box2D/Common/b2Simd.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+#include <cstring>
+using namespace std;
+
+// The smallest number of ropes handed to another thread.
+static const int32 b2_ropeRange = 4;
+
+b2RopeBatch::b2RopeBatch()
+{
+	m_ropeCount = 0;
+	m_ropeCapacity = 0;
+	m_ropes = NULL;
+
+	m_slotCount = 0;
+	m_slotCapacity = 0;
+	float32** arrays[e_slotArrayCount];
+	GetSlotArrays(arrays);
+	for (int32 i = 0; i < e_slotArrayCount; ++i)
+	{
+		*arrays[i] = NULL;
+	}
+
+	m_angleCount = 0;
+	m_angleCapacity = 0;
+	m_as = NULL;
+
+	m_scheduler = NULL;
+}
+
+b2RopeBatch::~b2RopeBatch()
+{
+	float32** arrays[e_slotArrayCount];
+	GetSlotArrays(arrays);
+	for (int32 i = 0; i < e_slotArrayCount; ++i)
+	{
+		b2Free(*arrays[i]);
+	}
+
+	b2Free(m_as);
+	b2Free(m_ropes);
+}
+
+void b2RopeBatch::GetSlotArrays(float32** arrays[e_slotArrayCount])
+{
+	int32 n = 0;
+	for (int32 j = 0; j < 2; ++j)
+	{
+		arrays[n++] = &m_xs[j];
+		arrays[n++] = &m_ys[j];
+		arrays[n++] = &m_x0s[j];
+		arrays[n++] = &m_y0s[j];
+		arrays[n++] = &m_vxs[j];
+		arrays[n++] = &m_vys[j];
+		arrays[n++] = &m_ims[j];
+		arrays[n++] = &m_Ls[j];
+		arrays[n++] = &m_s1s[j];
+		arrays[n++] = &m_s2s[j];
+	}
+	b2Assert(n == e_slotArrayCount);
+}
+
+void b2RopeBatch::Reserve(int32 slotCapacity, int32 angleCapacity)
+{
+	if (slotCapacity > m_slotCapacity)
+	{
+		int32 capacity = b2Max(slotCapacity, 2 * m_slotCapacity);
+
+		float32** arrays[e_slotArrayCount];
+		GetSlotArrays(arrays);
+		for (int32 i = 0; i < e_slotArrayCount; ++i)
+		{
+			float32* oldArray = *arrays[i];
+			*arrays[i] = (float32*)b2Alloc(capacity * sizeof(float32));
+			if (oldArray != NULL)
+			{
+				memcpy(*arrays[i], oldArray, m_slotCount * sizeof(float32));
+				b2Free(oldArray);
+			}
+		}
+
+		m_slotCapacity = capacity;
+	}
+
+	if (angleCapacity > m_angleCapacity)
+	{
+		int32 capacity = b2Max(angleCapacity, 2 * m_angleCapacity);
+
+		float32* oldAngles = m_as;
+		m_as = (float32*)b2Alloc(capacity * sizeof(float32));
+		if (oldAngles != NULL)
+		{
+			memcpy(m_as, oldAngles, m_angleCount * sizeof(float32));
+			b2Free(oldAngles);
+		}
+
+		m_angleCapacity = capacity;
+	}
+}
+
+int32 b2RopeBatch::AddRope(const b2RopeDef* def)
+{
+	b2Assert(def->count >= 3);
+	int32 count = def->count;
+
+	// Leave one empty group after the last odd constraint.
+	int32 oddCount = (count - 1) / 2;
+	int32 slotCount = ((oddCount + b2_simdWidth - 1) & ~(b2_simdWidth - 1)) + b2_simdWidth;
+	int32 angleCount = count - 2;
+
+	if (m_ropeCount == m_ropeCapacity)
+	{
+		b2BatchRope* oldRopes = m_ropes;
+		m_ropeCapacity = b2Max(16, 2 * m_ropeCapacity);
+		m_ropes = (b2BatchRope*)b2Alloc(m_ropeCapacity * sizeof(b2BatchRope));
+		if (oldRopes != NULL)
+		{
+			memcpy(m_ropes, oldRopes, m_ropeCount * sizeof(b2BatchRope));
+			b2Free(oldRopes);
+		}
+	}
+
+	Reserve(m_slotCount + slotCount, m_angleCount + angleCount);
+
+	b2BatchRope* rope = m_ropes + m_ropeCount;
+	rope->count = count;
+	rope->slotStart = m_slotCount;
+	rope->slotCount = slotCount;
+	rope->angleStart = m_angleCount;
+	rope->gravity = def->gravity;
+	rope->damping = def->damping;
+	rope->k3 = def->k3;
+
+	// Unused slots hold resting vertices without mass and constraints without weight.
+	float32** arrays[e_slotArrayCount];
+	GetSlotArrays(arrays);
+	for (int32 i = 0; i < e_slotArrayCount; ++i)
+	{
+		memset(*arrays[i] + rope->slotStart, 0, slotCount * sizeof(float32));
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 j = i & 1;
+		int32 slot = rope->slotStart + (i >> 1);
+
+		m_xs[j][slot] = def->vertices[i].x;
+		m_ys[j][slot] = def->vertices[i].y;
+		m_x0s[j][slot] = def->vertices[i].x;
+		m_y0s[j][slot] = def->vertices[i].y;
+
+		float32 m = def->masses[i];
+		if (m > 0.0f)
+		{
+			m_ims[j][slot] = 1.0f / m;
+		}
+	}
+
+	for (int32 i = 0; i < count - 1; ++i)
+	{
+		int32 j = i & 1;
+		int32 slot = rope->slotStart + (i >> 1);
+
+		m_Ls[j][slot] = b2Distance(def->vertices[i], def->vertices[i + 1]);
+
+		float32 im1 = def->masses[i] > 0.0f ? 1.0f / def->masses[i] : 0.0f;
+		float32 im2 = def->masses[i + 1] > 0.0f ? 1.0f / def->masses[i + 1] : 0.0f;
+		if (im1 + im2 > 0.0f)
+		{
+			m_s1s[j][slot] = def->k2 * im1 / (im1 + im2);
+			m_s2s[j][slot] = def->k2 * im2 / (im1 + im2);
+		}
+	}
+
+	for (int32 i = 0; i < angleCount; ++i)
+	{
+		b2Vec2 d1 = def->vertices[i + 1] - def->vertices[i];
+		b2Vec2 d2 = def->vertices[i + 2] - def->vertices[i + 1];
+
+		float32 a = b2Cross(d1, d2);
+		float32 b = b2Dot(d1, d2);
+
+		m_as[rope->angleStart + i] = b2Atan2(a, b);
+	}
+
+	m_slotCount += slotCount;
+	m_angleCount += angleCount;
+	return m_ropeCount++;
+}
+
+void b2RopeBatch::Clear()
+{
+	m_ropeCount = 0;
+	m_slotCount = 0;
+	m_angleCount = 0;
+}
+
+int32 b2RopeBatch::GetVertexCount(int32 rope) const
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	return m_ropes[rope].count;
+}
+
+b2Vec2 b2RopeBatch::GetVertex(int32 rope, int32 index) const
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	b2Assert(0 <= index && index < m_ropes[rope].count);
+	int32 j = index & 1;
+	int32 slot = m_ropes[rope].slotStart + (index >> 1);
+	return b2Vec2(m_xs[j][slot], m_ys[j][slot]);
+}
+
+void b2RopeBatch::SetAngle(int32 rope, float32 angle)
+{
+	b2Assert(0 <= rope && rope < m_ropeCount);
+	const b2BatchRope* r = m_ropes + rope;
+	for (int32 i = 0; i < r->count - 2; ++i)
+	{
+		m_as[r->angleStart + i] = angle;
+	}
+}
+
+class b2RopeBatchTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		batch->SolveRopes(begin, end, h, iterations);
+	}
+
+	b2RopeBatch* batch;
+	float32 h;
+	int32 iterations;
+};
+
+void b2RopeBatch::Step(float32 h, int32 iterations)
+{
+	if (h == 0.0f || m_ropeCount == 0)
+	{
+		return;
+	}
+
+	if (m_scheduler != NULL)
+	{
+		b2RopeBatchTask task;
+		task.batch = this;
+		task.h = h;
+		task.iterations = iterations;
+		m_scheduler->ParallelFor(&task, m_ropeCount, b2_ropeRange);
+	}
+	else
+	{
+		SolveRopes(0, m_ropeCount, h, iterations);
+	}
+}
+
+// The ropes [begin, end) own a contiguous run of slots, so ranges of ropes can
+// be solved on different threads.
+void b2RopeBatch::SolveRopes(int32 begin, int32 end, float32 h, int32 iterations)
+{
+	int32 slotBegin = m_ropes[begin].slotStart;
+	int32 slotEnd = m_ropes[end - 1].slotStart + m_ropes[end - 1].slotCount;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		Integrate(m_ropes + i, h);
+	}
+
+	for (int32 i = 0; i < iterations; ++i)
+	{
+		SolveC2(slotBegin, slotEnd);
+
+		for (int32 j = begin; j < end; ++j)
+		{
+			SolveC3(m_ropes + j);
+		}
+
+		SolveC2(slotBegin, slotEnd);
+	}
+
+	b2FloatW inv_h = b2SplatW(1.0f / h);
+	for (int32 j = 0; j < 2; ++j)
+	{
+		for (int32 k = slotBegin; k < slotEnd; k += b2_simdWidth)
+		{
+			b2FloatW vx = b2MulW(inv_h, b2SubW(b2LoadW(m_xs[j] + k), b2LoadW(m_x0s[j] + k)));
+			b2FloatW vy = b2MulW(inv_h, b2SubW(b2LoadW(m_ys[j] + k), b2LoadW(m_y0s[j] + k)));
+			b2StoreW(m_vxs[j] + k, vx);
+			b2StoreW(m_vys[j] + k, vy);
+		}
+	}
+}
+
+void b2RopeBatch::Integrate(const b2BatchRope* rope, float32 h)
+{
+	b2FloatW zero = b2ZeroW();
+	b2FloatW hw = b2SplatW(h);
+	b2FloatW d = b2SplatW(expf(- h * rope->damping));
+	b2FloatW gx = b2SplatW(h * rope->gravity.x);
+	b2FloatW gy = b2SplatW(h * rope->gravity.y);
+
+	int32 slotEnd = rope->slotStart + rope->slotCount;
+	for (int32 j = 0; j < 2; ++j)
+	{
+		for (int32 k = rope->slotStart; k < slotEnd; k += b2_simdWidth)
+		{
+			b2FloatW x = b2LoadW(m_xs[j] + k);
+			b2FloatW y = b2LoadW(m_ys[j] + k);
+			b2StoreW(m_x0s[j] + k, x);
+			b2StoreW(m_y0s[j] + k, y);
+
+			// Only vertices with mass fall.
+			b2FloatW hasMass = b2GreaterW(b2LoadW(m_ims[j] + k), zero);
+			b2FloatW vx = b2AddW(b2LoadW(m_vxs[j] + k), b2BlendW(hasMass, gx, zero));
+			b2FloatW vy = b2AddW(b2LoadW(m_vys[j] + k), b2BlendW(hasMass, gy, zero));
+			vx = b2MulW(d, vx);
+			vy = b2MulW(d, vy);
+
+			b2StoreW(m_vxs[j] + k, vx);
+			b2StoreW(m_vys[j] + k, vy);
+			b2StoreW(m_xs[j] + k, b2AddW(x, b2MulW(hw, vx)));
+			b2StoreW(m_ys[j] + k, b2AddW(y, b2MulW(hw, vy)));
+		}
+	}
+}
+
+// Solve the constraints from the even vertices (red), then from the odd
+// vertices (black). Within a color no two constraints share a vertex.
+void b2RopeBatch::SolveC2(int32 slotBegin, int32 slotEnd)
+{
+	b2FloatW zero = b2ZeroW();
+	b2FloatW one = b2SplatW(1.0f);
+	b2FloatW epsilon = b2SplatW(b2_epsilon);
+
+	for (int32 j = 0; j < 2; ++j)
+	{
+		// Vertex 2k + 1 is in odd slot k and vertex 2k + 2 is in even slot k + 1.
+		float32* x1s = m_xs[j];
+		float32* y1s = m_ys[j];
+		float32* x2s = j == 0 ? m_xs[1] : m_xs[0] + 1;
+		float32* y2s = j == 0 ? m_ys[1] : m_ys[0] + 1;
+		const float32* Ls = m_Ls[j];
+		const float32* s1s = m_s1s[j];
+		const float32* s2s = m_s2s[j];
+
+		int32 end = j == 0 ? slotEnd : slotEnd - b2_simdWidth;
+		for (int32 k = slotBegin; k < end; k += b2_simdWidth)
+		{
+			b2FloatW x1 = b2LoadW(x1s + k);
+			b2FloatW y1 = b2LoadW(y1s + k);
+			b2FloatW x2 = b2LoadW(x2s + k);
+			b2FloatW y2 = b2LoadW(y2s + k);
+
+			b2FloatW dx = b2SubW(x2, x1);
+			b2FloatW dy = b2SubW(y2, y1);
+			b2FloatW L = b2SqrtW(b2DotW(dx, dy, dx, dy));
+
+			// Coincident vertices have no direction to push along.
+			b2FloatW invL = b2BlendW(b2GreaterEqualW(L, epsilon), b2DivW(one, b2MaxW(L, epsilon)), zero);
+			b2FloatW C = b2MulW(b2SubW(b2LoadW(Ls + k), L), invL);
+
+			b2FloatW c1 = b2MulW(b2LoadW(s1s + k), C);
+			b2FloatW c2 = b2MulW(b2LoadW(s2s + k), C);
+
+			b2StoreW(x1s + k, b2SubW(x1, b2MulW(c1, dx)));
+			b2StoreW(y1s + k, b2SubW(y1, b2MulW(c1, dy)));
+			b2StoreW(x2s + k, b2AddW(x2, b2MulW(c2, dx)));
+			b2StoreW(y2s + k, b2AddW(y2, b2MulW(c2, dy)));
+		}
+	}
+}
+
+void b2RopeBatch::SolveC3(const b2BatchRope* rope)
+{
+	float32* xs[2] = {m_xs[0] + rope->slotStart, m_xs[1] + rope->slotStart};
+	float32* ys[2] = {m_ys[0] + rope->slotStart, m_ys[1] + rope->slotStart};
+	const float32* ims[2] = {m_ims[0] + rope->slotStart, m_ims[1] + rope->slotStart};
+	const float32* as = m_as + rope->angleStart;
+
+	int32 count3 = rope->count - 2;
+
+	for (int32 i = 0; i < count3; ++i)
+	{
+		// Vertices i and i + 2 share a parity.
+		int32 j1 = i & 1, j2 = j1 ^ 1;
+		int32 k1 = i >> 1, k2 = (i + 1) >> 1, k3 = k1 + 1;
+
+		b2Vec2 p1(xs[j1][k1], ys[j1][k1]);
+		b2Vec2 p2(xs[j2][k2], ys[j2][k2]);
+		b2Vec2 p3(xs[j1][k3], ys[j1][k3]);
+
+		float32 m1 = ims[j1][k1];
+		float32 m2 = ims[j2][k2];
+		float32 m3 = ims[j1][k3];
+
+		b2Vec2 d1 = p2 - p1;
+		b2Vec2 d2 = p3 - p2;
+
+		float32 L1sqr = d1.LengthSquared();
+		float32 L2sqr = d2.LengthSquared();
+
+		if (L1sqr * L2sqr == 0.0f)
+		{
+			continue;
+		}
+
+		float32 a = b2Cross(d1, d2);
+		float32 b = b2Dot(d1, d2);
+
+		float32 angle = b2Atan2(a, b);
+
+		b2Vec2 Jd1 = (-1.0f / L1sqr) * d1.Skew();
+		b2Vec2 Jd2 = (1.0f / L2sqr) * d2.Skew();
+
+		b2Vec2 J1 = -Jd1;
+		b2Vec2 J2 = Jd1 - Jd2;
+		b2Vec2 J3 = Jd2;
+
+		float32 mass = m1 * b2Dot(J1, J1) + m2 * b2Dot(J2, J2) + m3 * b2Dot(J3, J3);
+		if (mass == 0.0f)
+		{
+			continue;
+		}
+
+		mass = 1.0f / mass;
+
+		float32 C = angle - as[i];
+
+		while (C > b2_pi)
+		{
+			angle -= 2 * b2_pi;
+			C = angle - as[i];
+		}
+
+		while (C < -b2_pi)
+		{
+			angle += 2.0f * b2_pi;
+			C = angle - as[i];
+		}
+
+		float32 impulse = - rope->k3 * mass * C;
+
+		p1 += (m1 * impulse) * J1;
+		p2 += (m2 * impulse) * J2;
+		p3 += (m3 * impulse) * J3;
+
+		xs[j1][k1] = p1.x;
+		ys[j1][k1] = p1.y;
+		xs[j2][k2] = p2.x;
+		ys[j2][k2] = p2.y;
+		xs[j1][k3] = p3.x;
+		ys[j1][k3] = p3.y;
+	}
+}
+
+void b2RopeBatch::Draw(b2Draw* draw) const
+{
+	b2Color c(0.4f, 0.5f, 0.7f);
+
+	for (int32 i = 0; i < m_ropeCount; ++i)
+	{
+		for (int32 j = 0; j < m_ropes[i].count - 1; ++j)
+		{
+			draw->DrawSegment(GetVertex(i, j), GetVertex(i, j + 1), c);
+		}
+	}
+}
@@ -0,0 +1,139 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_ROPE_BATCH_H
+#define B2_ROPE_BATCH_H
+
+#include <Box2D/Rope/b2Rope.h>
+
+class b2Draw;
+class b2TaskScheduler;
+
+/// Steps many ropes at once. The vertices of all ropes share structure of
+/// arrays buffers, with the even and odd vertices of each rope stored apart.
+/// The stretching constraints are solved in red-black order: first all that
+/// start at an even vertex, then all that start at an odd vertex. Neither set
+/// shares a vertex, so each is solved four constraints at a time using b2Simd.
+/// Bending is solved per rope as in b2Rope.
+class b2RopeBatch
+{
+public:
+	b2RopeBatch();
+	~b2RopeBatch();
+
+	/// Add a rope and return its index. The definition is copied.
+	int32 AddRope(const b2RopeDef* def);
+
+	/// Remove all ropes.
+	void Clear();
+
+	/// Step all ropes.
+	void Step(float32 timeStep, int32 iterations);
+
+	/// Split the ropes over the threads of a scheduler. Pass NULL to step
+	/// them on the calling thread.
+	void SetTaskScheduler(b2TaskScheduler* scheduler)
+	{
+		m_scheduler = scheduler;
+	}
+
+	///
+	int32 GetRopeCount() const
+	{
+		return m_ropeCount;
+	}
+
+	///
+	int32 GetVertexCount(int32 rope) const;
+
+	///
+	b2Vec2 GetVertex(int32 rope, int32 index) const;
+
+	///
+	void SetAngle(int32 rope, float32 angle);
+
+	///
+	void Draw(b2Draw* draw) const;
+
+private:
+
+	friend class b2RopeBatchTask;
+
+	struct b2BatchRope
+	{
+		int32 count;
+
+		// The slots [slotStart, slotStart + slotCount) of the slot arrays. The
+		// count is a multiple of b2_simdWidth. The odd constraints lie in all
+		// but the last b2_simdWidth slots, so solving them never reads past
+		// the rope.
+		int32 slotStart;
+		int32 slotCount;
+
+		int32 angleStart;
+
+		b2Vec2 gravity;
+		float32 damping;
+		float32 k3;
+	};
+
+	enum
+	{
+		e_slotArrayCount = 20
+	};
+
+	void Reserve(int32 slotCapacity, int32 angleCapacity);
+	void GetSlotArrays(float32** arrays[e_slotArrayCount]);
+
+	void SolveRopes(int32 begin, int32 end, float32 h, int32 iterations);
+	void Integrate(const b2BatchRope* rope, float32 h);
+	void SolveC2(int32 slotBegin, int32 slotEnd);
+	void SolveC3(const b2BatchRope* rope);
+
+	b2BatchRope* m_ropes;
+	int32 m_ropeCount;
+	int32 m_ropeCapacity;
+
+	// Vertex i of a rope is in slot slotStart + i / 2 of the even (0) or
+	// odd (1) array.
+	float32* m_xs[2];
+	float32* m_ys[2];
+	float32* m_x0s[2];
+	float32* m_y0s[2];
+	float32* m_vxs[2];
+	float32* m_vys[2];
+	float32* m_ims[2];
+
+	// The stretching constraint from vertex i to i + 1 is in the same slot as
+	// vertex i. The weights are k2 * im / (im1 + im2) and are zero for the
+	// unused slots, so those constraints do nothing.
+	float32* m_Ls[2];
+	float32* m_s1s[2];
+	float32* m_s2s[2];
+
+	int32 m_slotCount;
+	int32 m_slotCapacity;
+
+	float32* m_as;
+	int32 m_angleCount;
+	int32 m_angleCapacity;
+
+	b2TaskScheduler* m_scheduler;
+};
+
+#endif
@@ -406,6 +406,9 @@ int main(int argc, char** argv)
 	glui->add_checkbox("Warm Starting", &settings.enableWarmStarting);
 	glui->add_checkbox("Time of Impact", &settings.enableContinuous);
 	glui->add_checkbox("Sub-Stepping", &settings.enableSubStepping);
+	glui->add_checkbox("Wide Solver", &settings.enableWideContactSolver);
+	glui->add_checkbox("Wide Joints", &settings.enableWideJointSolver);
+	glui->add_checkbox("State Arrays", &settings.enableBodyStateArrays);
 
 	//glui->add_separator();
 
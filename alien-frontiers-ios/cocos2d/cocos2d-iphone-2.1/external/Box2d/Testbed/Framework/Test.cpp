@@ -291,6 +291,9 @@ void Test::Step(Settings* settings)
 	m_world->SetWarmStarting(settings->enableWarmStarting > 0);
 	m_world->SetContinuousPhysics(settings->enableContinuous > 0);
 	m_world->SetSubStepping(settings->enableSubStepping > 0);
+	m_world->SetWideContactSolver(settings->enableWideContactSolver > 0);
+	m_world->SetWideJointSolver(settings->enableWideJointSolver > 0);
+	m_world->SetBodyStateArrays(settings->enableBodyStateArrays > 0);
 
 	m_pointCount = 0;
 
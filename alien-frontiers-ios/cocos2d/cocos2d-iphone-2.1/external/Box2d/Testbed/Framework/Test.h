@@ -71,6 +71,9 @@ struct Settings
 		enableWarmStarting(1),
 		enableContinuous(1),
 		enableSubStepping(0),
+		enableWideContactSolver(0),
+		enableWideJointSolver(0),
+		enableBodyStateArrays(0),
 		pause(0),
 		singleStep(0)
 		{}
@@ -93,6 +96,9 @@ struct Settings
 	int32 enableWarmStarting;
 	int32 enableContinuous;
 	int32 enableSubStepping;
+	int32 enableWideContactSolver;
+	int32 enableWideJointSolver;
+	int32 enableBodyStateArrays;
 	int32 pause;
 	int32 singleStep;
 };
@@ -0,0 +1,132 @@
+/*
+* Copyright (c) 2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BULLET_STORM_H
+#define BULLET_STORM_H
+
+// Bullets are fired into box stacks every other step. Most of the step
+// time goes into finding and solving TOI events.
+class BulletStorm : public Test
+{
+public:
+
+	enum
+	{
+		e_columnCount = 6,
+		e_rowCount = 12,
+		e_maxBullets = 400
+	};
+
+	BulletStorm()
+	{
+		{
+			b2BodyDef bd;
+			b2Body* ground = m_world->CreateBody(&bd);
+
+			b2EdgeShape shape;
+			shape.Set(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+			ground->CreateFixture(&shape, 0.0f);
+
+			shape.Set(b2Vec2(-40.0f, 0.0f), b2Vec2(-40.0f, 30.0f));
+			ground->CreateFixture(&shape, 0.0f);
+
+			shape.Set(b2Vec2(40.0f, 0.0f), b2Vec2(40.0f, 30.0f));
+			ground->CreateFixture(&shape, 0.0f);
+		}
+
+		{
+			b2PolygonShape shape;
+			shape.SetAsBox(0.5f, 0.5f);
+
+			b2FixtureDef fd;
+			fd.shape = &shape;
+			fd.density = 1.0f;
+			fd.friction = 0.3f;
+
+			for (int32 j = 0; j < e_columnCount; ++j)
+			{
+				float32 x = -12.5f + 5.0f * j;
+
+				for (int32 i = 0; i < e_rowCount; ++i)
+				{
+					b2BodyDef bd;
+					bd.type = b2_dynamicBody;
+					bd.position.Set(x, 0.5f + 1.0f * i);
+					b2Body* body = m_world->CreateBody(&bd);
+					body->CreateFixture(&fd);
+				}
+			}
+		}
+
+		m_bulletCount = 0;
+	}
+
+	void Fire()
+	{
+		// Alternate the sides and sweep the heights without using random numbers,
+		// so the scene is the same in every run.
+		int32 i = m_bulletCount;
+		float32 side = (i & 1) ? 1.0f : -1.0f;
+		float32 y = 1.0f + 0.73f * float32(i % 16);
+
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.bullet = true;
+		bd.position.Set(-side * 38.0f, y);
+		bd.linearVelocity.Set(side * 200.0f, 0.0f);
+
+		b2Body* body = m_world->CreateBody(&bd);
+
+		if (i % 3 == 0)
+		{
+			b2PolygonShape shape;
+			shape.SetAsBox(0.1f, 0.1f);
+			body->CreateFixture(&shape, 20.0f);
+		}
+		else
+		{
+			b2CircleShape shape;
+			shape.m_radius = 0.1f;
+			body->CreateFixture(&shape, 20.0f);
+		}
+
+		++m_bulletCount;
+	}
+
+	void Step(Settings* settings)
+	{
+		if (settings->pause == 0 && m_bulletCount < e_maxBullets && m_stepCount % 2 == 0)
+		{
+			Fire();
+		}
+
+		Test::Step(settings);
+
+		m_debugDraw.DrawString(5, m_textLine, "bullets = %d", m_bulletCount);
+		m_textLine += 15;
+	}
+
+	static Test* Create()
+	{
+		return new BulletStorm;
+	}
+
+	int32 m_bulletCount;
+};
+
+#endif
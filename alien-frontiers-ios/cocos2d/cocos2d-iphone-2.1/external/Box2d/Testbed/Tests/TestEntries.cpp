@@ -27,6 +27,7 @@ using namespace std;
 #include "BodyTypes.h"
 #include "Breakable.h"
 #include "Bridge.h"
+#include "BulletStorm.h"
 #include "BulletTest.h"
 #include "Cantilever.h"
 #include "Car.h"
@@ -43,6 +44,7 @@ using namespace std;
 #include "EdgeShapes.h"
 #include "EdgeTest.h"
 #include "Gears.h"
+#include "ManyPyramids.h"
 #include "OneSidedPlatform.h"
 #include "Pinball.h"
 #include "PolyCollision.h"
@@ -88,11 +90,13 @@ TestEntry g_testEntries[] =
 	{"One-Sided Platform", OneSidedPlatform::Create},
 	{"Pinball", Pinball::Create},
 	{"Bullet Test", BulletTest::Create},
+	{"Bullet Storm", BulletStorm::Create},
 	{"Continuous Test", ContinuousTest::Create},
 	{"Time of Impact", TimeOfImpact::Create},
 	{"Ray-Cast", RayCast::Create},
 	{"Confined", Confined::Create},
 	{"Pyramid", Pyramid::Create},
+	{"Many Pyramids", ManyPyramids::Create},
 	{"Varying Restitution", VaryingRestitution::Create},
 	{"Theo Jansen's Walker", TheoJansen::Create},
 	{"Edge Shapes", EdgeShapes::Create},
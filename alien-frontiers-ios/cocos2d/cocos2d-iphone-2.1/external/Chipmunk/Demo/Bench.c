@@ -1,18 +1,21 @@
 #include "chipmunk.h"
 #include "ChipmunkDemo.h"
 
-#if 1
+// Number of threads the benchmarks are stepped with. 0 uses one thread per CPU.
+int bench_threads = 1;
+
+#if 0
 	#define BENCH_SPACE_NEW cpSpaceNew
 	#define BENCH_SPACE_FREE cpSpaceFree
 	#define BENCH_SPACE_STEP cpSpaceStep
 #else
-	#import "cpHastySpace.h"
+	#include "cpHastySpace.h"
 	
 	static cpSpace *
 	MakeHastySpace()
 	{
 		cpSpace *space = cpHastySpaceNew();
-		cpHastySpaceSetThreads(space, 0);
+		cpHastySpaceSetThreads(space, bench_threads);
 		return space;
 	}
 	
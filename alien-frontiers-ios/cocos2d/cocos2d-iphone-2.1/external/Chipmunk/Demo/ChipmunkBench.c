@@ -0,0 +1,418 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+	Headless runner for the scenes in Bench.c. It needs neither OpenGL nor GLUT
+	so it can be run from scripts and on build machines.
+	
+	Every scene is seeded with the same value and stepped a fixed number of times.
+	The results are written as JSON, and can be compared against the JSON from an
+	earlier run to catch regressions:
+		
+		chipmunk_bench -steps 1000 -o baseline.json
+		chipmunk_bench -steps 1000 -baseline baseline.json
+	
+	The comparison is printed to stderr, and the exit status is 1 if any scene's
+	median step time got slower than the tolerance allows or it allocates more
+	while stepping.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+	#include <windows.h>
+#endif
+
+#include "ChipmunkBenchAlloc.h"
+#include "chipmunk_private.h"
+#include "ChipmunkDemo.h"
+
+extern ChipmunkDemo bench_list[];
+extern int bench_count;
+extern int bench_threads;
+
+//MARK: Allocation Counting
+
+static unsigned long allocationCount = 0;
+
+void *
+ChipmunkBenchCalloc(size_t count, size_t size)
+{
+	allocationCount++;
+	return calloc(count, size);
+}
+
+void *
+ChipmunkBenchRealloc(void *ptr, size_t size)
+{
+	allocationCount++;
+	return realloc(ptr, size);
+}
+
+void
+ChipmunkBenchFree(void *ptr)
+{
+	free(ptr);
+}
+
+//MARK: Demo Stubs
+
+// Bench.c is shared with the demo app, which supplies these in ChipmunkDemo.c.
+// That file can't be linked without GLUT.
+
+static void shapeFreeWrap(cpSpace *space, cpShape *shape, void *unused){
+	cpSpaceRemoveShape(space, shape);
+	cpShapeFree(shape);
+}
+
+static void postShapeFree(cpShape *shape, cpSpace *space){
+	cpSpaceAddPostStepCallback(space, (cpPostStepFunc)shapeFreeWrap, shape, NULL);
+}
+
+static void constraintFreeWrap(cpSpace *space, cpConstraint *constraint, void *unused){
+	cpSpaceRemoveConstraint(space, constraint);
+	cpConstraintFree(constraint);
+}
+
+static void postConstraintFree(cpConstraint *constraint, cpSpace *space){
+	cpSpaceAddPostStepCallback(space, (cpPostStepFunc)constraintFreeWrap, constraint, NULL);
+}
+
+static void bodyFreeWrap(cpSpace *space, cpBody *body, void *unused){
+	cpSpaceRemoveBody(space, body);
+	cpBodyFree(body);
+}
+
+static void postBodyFree(cpBody *body, cpSpace *space){
+	cpSpaceAddPostStepCallback(space, (cpPostStepFunc)bodyFreeWrap, body, NULL);
+}
+
+void
+ChipmunkDemoFreeSpaceChildren(cpSpace *space)
+{
+	// Must remove these BEFORE freeing the body or you will access dangling pointers.
+	cpSpaceEachShape(space, (cpSpaceShapeIteratorFunc)postShapeFree, space);
+	cpSpaceEachConstraint(space, (cpSpaceConstraintIteratorFunc)postConstraintFree, space);
+	
+	cpSpaceEachBody(space, (cpSpaceBodyIteratorFunc)postBodyFree, space);
+}
+
+void ChipmunkDemoDefaultDrawImpl(cpSpace *space){}
+
+//MARK: Timing
+
+#ifdef WIN32
+
+static double GetMilliseconds(){
+	__int64 count, freq;
+	QueryPerformanceCounter((LARGE_INTEGER*)&count);
+	QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
+	
+	return 1000.0*(double)count/(double)freq;
+}
+
+#else
+
+#include <sys/time.h>
+
+static double GetMilliseconds(){
+	struct timeval time;
+	gettimeofday(&time, NULL);
+	
+	return (time.tv_sec*1000.0 + time.tv_usec/1000.0);
+}
+
+#endif
+
+//MARK: Running Scenes
+
+typedef struct SceneResult {
+	const char *name;
+	
+	double totalTime;
+	double minTime;
+	double medianTime;
+	double p99Time;
+	
+	double meanArbiters;
+	int maxArbiters;
+	
+	// cpBBTreeGetCost() of the shape indexes after the last step.
+	double staticTreeCost;
+	double activeTreeCost;
+	
+	unsigned long initAllocations;
+	unsigned long stepAllocations;
+} SceneResult;
+
+static const char *
+SceneName(ChipmunkDemo *demo)
+{
+	const char *prefix = "benchmark - ";
+	size_t length = strlen(prefix);
+	return (strncmp(demo->name, prefix, length) == 0 ? demo->name + length : demo->name);
+}
+
+static int
+CompareTimes(const void *a, const void *b)
+{
+	double ta = *(const double *)a, tb = *(const double *)b;
+	return (ta > tb) - (ta < tb);
+}
+
+static SceneResult
+RunScene(ChipmunkDemo *demo, int steps, unsigned int seed, double *times)
+{
+	SceneResult result = {SceneName(demo)};
+	
+	// The scenes scatter their bodies with rand().
+	srand(seed);
+	
+	unsigned long allocations = allocationCount;
+	cpSpace *space = demo->initFunc();
+	result.initAllocations = allocationCount - allocations;
+	
+	long arbiterSum = 0;
+	allocations = allocationCount;
+	
+	for(int i=0; i<steps; i++){
+		double start = GetMilliseconds();
+		demo->updateFunc(space);
+		times[i] = GetMilliseconds() - start;
+		
+		int arbiters = space->arbiters->num;
+		arbiterSum += arbiters;
+		if(arbiters > result.maxArbiters) result.maxArbiters = arbiters;
+	}
+	
+	result.stepAllocations = allocationCount - allocations;
+	result.staticTreeCost = cpBBTreeGetCost(space->staticShapes);
+	result.activeTreeCost = cpBBTreeGetCost(space->activeShapes);
+	demo->destroyFunc(space);
+	
+	for(int i=0; i<steps; i++) result.totalTime += times[i];
+	result.meanArbiters = (double)arbiterSum/(double)steps;
+	
+	qsort(times, steps, sizeof(double), CompareTimes);
+	result.minTime = times[0];
+	result.medianTime = (steps%2 ? times[steps/2] : 0.5*(times[steps/2 - 1] + times[steps/2]));
+	result.p99Time = times[(99*steps + 99)/100 - 1];
+	
+	return result;
+}
+
+static void
+WriteResults(FILE *file, SceneResult *results, int count, int steps, unsigned int seed)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"steps\": %d,\n", steps);
+	fprintf(file, "\t\"seed\": %u,\n", seed);
+	fprintf(file, "\t\"threads\": %d,\n", bench_threads);
+	fprintf(file, "\t\"scenes\": [\n");
+	
+	for(int i=0; i<count; i++){
+		SceneResult *r = results + i;
+		fprintf(file, "\t\t{\n");
+		fprintf(file, "\t\t\t\"name\": \"%s\",\n", r->name);
+		fprintf(file, "\t\t\t\"total_ms\": %.4f,\n", r->totalTime);
+		fprintf(file, "\t\t\t\"min_ms\": %.4f,\n", r->minTime);
+		fprintf(file, "\t\t\t\"median_ms\": %.4f,\n", r->medianTime);
+		fprintf(file, "\t\t\t\"p99_ms\": %.4f,\n", r->p99Time);
+		fprintf(file, "\t\t\t\"arbiters_mean\": %.2f,\n", r->meanArbiters);
+		fprintf(file, "\t\t\t\"arbiters_max\": %d,\n", r->maxArbiters);
+		fprintf(file, "\t\t\t\"static_tree_cost\": %.2f,\n", r->staticTreeCost);
+		fprintf(file, "\t\t\t\"active_tree_cost\": %.2f,\n", r->activeTreeCost);
+		fprintf(file, "\t\t\t\"allocations_init\": %lu,\n", r->initAllocations);
+		fprintf(file, "\t\t\t\"allocations_step\": %lu\n", r->stepAllocations);
+		fprintf(file, "\t\t}%s\n", (i + 1 < count ? "," : ""));
+	}
+	
+	fprintf(file, "\t]\n");
+	fprintf(file, "}\n");
+}
+
+//MARK: Baseline Comparison
+
+static char *
+ReadFile(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if(!file) return NULL;
+	
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	
+	char *data = (char *)malloc(length + 1);
+	size_t read = fread(data, 1, length, file);
+	data[read] = '\0';
+	fclose(file);
+	
+	return data;
+}
+
+// Only needs to read back the JSON written by WriteResults().
+static cpBool
+BaselineValue(const char *baseline, const char *name, const char *key, double *value)
+{
+	char pattern[256];
+	snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+	const char *scene = strstr(baseline, pattern);
+	if(!scene) return cpFalse;
+	
+	const char *end = strchr(scene, '}');
+	snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+	const char *field = strstr(scene, pattern);
+	if(!field || (end && field > end)) return cpFalse;
+	
+	*value = strtod(field + strlen(pattern), NULL);
+	return cpTrue;
+}
+
+static int
+CompareBaseline(const char *baseline, SceneResult *results, int count, double tolerance)
+{
+	int regressions = 0;
+	
+	for(int i=0; i<count; i++){
+		SceneResult *r = results + i;
+		double median, allocations, arbiters;
+		
+		if(!BaselineValue(baseline, r->name, "median_ms", &median)){
+			fprintf(stderr, "%-32s not in baseline\n", r->name);
+			continue;
+		}
+		
+		double change = (median > 0.0 ? 100.0*(r->medianTime - median)/median : 0.0);
+		cpBool slower = (change > tolerance);
+		fprintf(stderr, "%-32s median %8.4f ms -> %8.4f ms (%+6.1f%%)%s\n",
+			r->name, median, r->medianTime, change, (slower ? " REGRESSION" : "")
+		);
+		if(slower) regressions++;
+		
+		if(BaselineValue(baseline, r->name, "allocations_step", &allocations) && r->stepAllocations > allocations){
+			fprintf(stderr, "%-32s step allocations %.0f -> %lu REGRESSION\n", r->name, allocations, r->stepAllocations);
+			regressions++;
+		}
+		
+		// Different arbiter counts mean the simulation itself changed, so the times aren't comparable.
+		if(BaselineValue(baseline, r->name, "arbiters_max", &arbiters) && r->maxArbiters != (int)arbiters){
+			fprintf(stderr, "%-32s max arbiters changed %.0f -> %d\n", r->name, arbiters, r->maxArbiters);
+		}
+	}
+	
+	return regressions;
+}
+
+//MARK: Main
+
+static void
+PrintUsage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"\t-steps N         steps per scene (default 1000)\n"
+		"\t-seed N          random seed each scene is built with (default 1)\n"
+		"\t-threads N       threads to step with, 0 for one per CPU (default 1)\n"
+		"\t-scene NAME      only run the scenes whose name contains NAME\n"
+		"\t-o FILE          write the JSON results to FILE instead of stdout\n"
+		"\t-baseline FILE   compare the results against an earlier JSON file\n"
+		"\t-tolerance PCT   allowed median slowdown against the baseline (default 10)\n"
+		"\t-list            list the scenes and exit\n",
+		program
+	);
+}
+
+int
+main(int argc, const char **argv)
+{
+	int steps = 1000;
+	unsigned int seed = 1;
+	const char *filter = NULL;
+	const char *outputPath = NULL;
+	const char *baselinePath = NULL;
+	double tolerance = 10.0;
+	
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "-steps") == 0 && i + 1 < argc){
+			steps = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc){
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		} else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc){
+			bench_threads = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-scene") == 0 && i + 1 < argc){
+			filter = argv[++i];
+		} else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+			outputPath = argv[++i];
+		} else if(strcmp(argv[i], "-baseline") == 0 && i + 1 < argc){
+			baselinePath = argv[++i];
+		} else if(strcmp(argv[i], "-tolerance") == 0 && i + 1 < argc){
+			tolerance = atof(argv[++i]);
+		} else if(strcmp(argv[i], "-list") == 0){
+			for(int j=0; j<bench_count; j++) printf("%s\n", SceneName(bench_list + j));
+			return 0;
+		} else {
+			PrintUsage(argv[0]);
+			return 2;
+		}
+	}
+	
+	if(steps < 1){
+		fprintf(stderr, "-steps must be at least 1\n");
+		return 2;
+	}
+	
+	char *baseline = NULL;
+	if(baselinePath && !(baseline = ReadFile(baselinePath))){
+		fprintf(stderr, "Could not read baseline \"%s\"\n", baselinePath);
+		return 2;
+	}
+	
+	SceneResult *results = (SceneResult *)calloc(bench_count, sizeof(SceneResult));
+	double *times = (double *)calloc(steps, sizeof(double));
+	int count = 0;
+	
+	for(int i=0; i<bench_count; i++){
+		ChipmunkDemo *demo = bench_list + i;
+		if(filter && !strstr(SceneName(demo), filter)) continue;
+		
+		results[count++] = RunScene(demo, steps, seed, times);
+	}
+	
+	FILE *output = stdout;
+	if(outputPath && !(output = fopen(outputPath, "w"))){
+		fprintf(stderr, "Could not open \"%s\" for writing\n", outputPath);
+		return 2;
+	}
+	
+	WriteResults(output, results, count, steps, seed);
+	if(output != stdout) fclose(output);
+	
+	int regressions = (baseline ? CompareBaseline(baseline, results, count, tolerance) : 0);
+	
+	free(baseline);
+	free(results);
+	free(times);
+	
+	return (regressions ? 1 : 0);
+}
@@ -572,6 +572,7 @@ extern ChipmunkDemo Shatter;
 
 extern ChipmunkDemo bench_list[];
 extern int bench_count;
+extern int bench_threads;
 
 int
 main(int argc, const char **argv)
@@ -606,6 +607,7 @@ main(int argc, const char **argv)
 	demos = demo_list;
 	demoCount = sizeof(demo_list)/sizeof(ChipmunkDemo);
 	int trial = 0;
+	int scaling = 0;
 	
 	for(int i=0; i<argc; i++){
 		if(strcmp(argv[i], "-bench") == 0){
@@ -613,10 +615,24 @@ main(int argc, const char **argv)
 			demoCount = bench_count;
 		} else if(strcmp(argv[i], "-trial") == 0){
 			trial = 1;
+		} else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc){
+			bench_threads = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-scaling") == 0){
+			// Run the trials with 1, 2, 4... threads, up to the -threads count.
+			trial = 1;
+			scaling = 1;
 		}
 	}
 	
-	if(trial){
+	if(scaling){
+		int maxThreads = (bench_threads > 1 ? bench_threads : 4);
+		for(int threads=1; threads<=maxThreads; threads*=2){
+			printf("Threads = %d\n", threads);
+			bench_threads = threads;
+			for(int i=0; i<demoCount; i++) time_trial(i, 1000);
+		}
+		exit(0);
+	} else if(trial){
 //		sleep(1);
 		for(int i=0; i<demoCount; i++) time_trial(i, 1000);
 //		time_trial('d' - 'a', 10000);
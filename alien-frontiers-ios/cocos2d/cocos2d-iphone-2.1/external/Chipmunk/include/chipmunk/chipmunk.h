@@ -87,6 +87,7 @@ void cpMessage(const char *condition, const char *file, int line, int isError, i
 
 typedef struct cpArray cpArray;
 typedef struct cpHashSet cpHashSet;
+typedef struct cpContactBatches cpContactBatches;
 
 typedef struct cpBody cpBody;
 typedef struct cpShape cpShape;
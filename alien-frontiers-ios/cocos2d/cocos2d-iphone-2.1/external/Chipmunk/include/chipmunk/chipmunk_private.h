@@ -96,6 +96,38 @@ void cpBodyAddShape(cpBody *body, cpShape *shape);
 void cpBodyRemoveShape(cpBody *body, cpShape *shape);
 void cpBodyRemoveConstraint(cpBody *body, cpConstraint *constraint);
 
+// Solver coloring splits arbiters and constraints into colors where no two share a body.
+// Each body keeps a mask of the colors it's been given in solverColors, which must be cleared first.
+#define CP_SOLVER_COLOR_COUNT 32
+
+// Impulses never change a body with an infinite mass and moment, so any number
+// of the arbiters and constraints on one of them can be solved at the same time.
+static inline cpBool
+cpBodyNeedsSolverColor(cpBody *body)
+{
+	return (body->m_inv != 0.0f || body->i_inv != 0.0f);
+}
+
+// Give a pair of bodies the first color neither has yet.
+// Returns CP_SOLVER_COLOR_COUNT when they have used up all of the colors between them.
+static inline int
+cpBodyPairSolverColor(cpBody *a, cpBody *b)
+{
+	cpBool colorA = cpBodyNeedsSolverColor(a);
+	cpBool colorB = cpBodyNeedsSolverColor(b);
+	
+	unsigned int used = (colorA ? a->solverColors : 0) | (colorB ? b->solverColors : 0);
+	if(used == ~0u) return CP_SOLVER_COLOR_COUNT;
+	
+	int color = 0;
+	while(used & (1u << color)) color++;
+	
+	if(colorA) a->solverColors |= 1u << color;
+	if(colorB) b->solverColors |= 1u << color;
+	
+	return color;
+}
+
 
 //MARK: Shape/Collision Functions
 
@@ -179,6 +211,15 @@ cpPolyShapeContainsVertPartial(const cpPolyShape *poly, const cpVect v, const cp
 
 cpSpatialIndex *cpSpatialIndexInit(cpSpatialIndex *index, cpSpatialIndexClass *klass, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
 
+// cpSpatialIndexReindexQuery() for a cpBBTree, split up so the queries of the moved leaves can run on several threads.
+// cpBBTreeReindexBegin() updates the leaves and returns how many there are, or -1 if the index can't be split up.
+// cpBBTreeMarkLeaves() is then called once for each task, and the tasks must cover the leaves in order.
+// Different tasks may run at the same time. cpBBTreeReindexEnd() then calls func on the calling thread,
+// for the same pairs and in the same order as cpSpatialIndexReindexQuery().
+int cpBBTreeReindexBegin(cpSpatialIndex *index, int numTasks);
+void cpBBTreeMarkLeaves(cpSpatialIndex *index, int task, int start, int end);
+void cpBBTreeReindexEnd(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data);
+
 //MARK: Space Functions
 
 extern cpCollisionHandler cpDefaultCollisionHandler;
@@ -223,6 +264,12 @@ cpSpaceUncacheArbiter(cpSpace *space, cpArbiter *arb)
 void cpShapeUpdateFunc(cpShape *shape, void *unused);
 void cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space);
 
+// The two halves of cpSpaceCollideShapes() for steppers that run the narrow-phase elsewhere.
+// cpSpaceFilterShapePair() rejects pairs that can't collide and orders the shapes for cpCollideShapes().
+// cpSpaceUpdateArbiter() takes contacts that were pushed into the contact buffer and updates the pair's arbiter.
+cpBool cpSpaceFilterShapePair(cpSpace *space, cpShape **a, cpShape **b, cpCollisionHandler **handler, cpBool *sensor);
+void cpSpaceUpdateArbiter(cpSpace *space, cpShape *a, cpShape *b, cpCollisionHandler *handler, cpBool sensor, cpContact *contacts, int numContacts);
+
 
 
 //MARK: Arbiters
@@ -263,3 +310,11 @@ void cpArbiterUpdate(cpArbiter *arb, cpContact *contacts, int numContacts, struc
 void cpArbiterPreStep(cpArbiter *arb, cpFloat dt, cpFloat bias, cpFloat slop);
 void cpArbiterApplyCachedImpulse(cpArbiter *arb, cpFloat dt_coef);
 void cpArbiterApplyImpulse(cpArbiter *arb);
+
+// Solves the arbiters in SIMD batches where it's supported.
+// The batches hold their own copy of the accumulated impulses until cpContactBatchesStoreImpulses() is called.
+cpContactBatches *cpContactBatchesNew(void);
+void cpContactBatchesFree(cpContactBatches *batches);
+void cpContactBatchesBuild(cpContactBatches *batches, cpArray *arbiters);
+void cpContactBatchesApplyImpulse(cpContactBatches *batches);
+void cpContactBatchesStoreImpulses(cpContactBatches *batches);
@@ -40,8 +40,17 @@ normal_relative_velocity(cpBody *a, cpBody *b, cpVect r1, cpVect r2, cpVect n){
 	return cpvdot(relative_velocity(a, b, r1, r2), n);
 }
 
+// Impulses can't change a body with an infinite mass and moment, so the functions below don't write to one at all.
+// cpHastySpace relies on this to solve arbiters and constraints that share a static body on several threads at once.
+static inline cpBool
+body_is_fixed(cpBody *body){
+	return (body->m_inv == 0.0f && body->i_inv == 0.0f);
+}
+
 static inline void
 apply_impulse(cpBody *body, cpVect j, cpVect r){
+	if(body_is_fixed(body)) return;
+	
 	body->v = cpvadd(body->v, cpvmult(j, body->m_inv));
 	body->w += body->i_inv*cpvcross(r, j);
 }
@@ -56,10 +65,20 @@ apply_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 static inline void
 apply_bias_impulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(body_is_fixed(body)) return;
+	
 	body->CP_PRIVATE(v_bias) = cpvadd(body->CP_PRIVATE(v_bias), cpvmult(j, body->m_inv));
 	body->CP_PRIVATE(w_bias) += body->i_inv*cpvcross(r, j);
 }
 
+static inline void
+apply_angular_velocity(cpBody *body, cpFloat dw)
+{
+	if(body_is_fixed(body)) return;
+	
+	body->w += dw;
+}
+
 static inline void
 apply_bias_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 {
@@ -97,6 +97,8 @@ struct cpBody {
 	CP_PRIVATE(cpConstraint *constraintList);
 	
 	CP_PRIVATE(cpComponentNode node);
+	
+	CP_PRIVATE(unsigned int solverColors);
 };
 
 /// Allocate a cpBody.
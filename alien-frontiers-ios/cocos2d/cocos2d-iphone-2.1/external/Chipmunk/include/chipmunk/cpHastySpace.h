@@ -0,0 +1,49 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "chipmunk.h"
+
+/// @defgroup cpHastySpace cpHastySpace
+/// A cpSpace that splits the work of a step across a pool of worker threads.
+/// Bodies are integrated, shapes are updated and the narrow-phase collision detection is run in parallel.
+/// The arbiters and constraints are split into colors where no two of them share a body,
+/// and each color is solved in parallel.
+/// The results don't depend on the number of threads, but differ slightly from cpSpaceStep()
+/// because the solver visits the arbiters and constraints in a different order.
+/// Callbacks are only ever called from the thread that calls cpHastySpaceStep().
+/// Body velocity and position functions are called from the worker threads.
+/// @{
+
+/// Allocate and initialize a cpHastySpace. It starts with a single thread.
+cpSpace *cpHastySpaceNew(void);
+/// Destroy and free a cpHastySpace. Must be used instead of cpSpaceFree().
+void cpHastySpaceFree(cpSpace *space);
+
+/// Set the number of threads used to step the space, including the calling thread.
+/// Pass 0 to use one thread per CPU. Threads aren't available on Windows and the space always uses one there.
+void cpHastySpaceSetThreads(cpSpace *space, unsigned long threads);
+/// Get the number of threads used to step the space.
+unsigned long cpHastySpaceGetThreads(cpSpace *space);
+
+/// Step the space forward in time by @c dt using the worker threads.
+void cpHastySpaceStep(cpSpace *space, cpFloat dt);
+
+/// @}
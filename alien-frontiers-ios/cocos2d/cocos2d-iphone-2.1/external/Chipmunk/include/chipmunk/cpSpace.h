@@ -67,6 +67,11 @@ struct cpSpace {
 	/// Disabled by default for a small performance boost. Enabled implicitly when the sleeping feature is enabled.
 	cpBool enableContactGraph;
 	
+	/// Solve the arbiters in SIMD batches of arbiters that don't share a body.
+	/// This changes the order the arbiters are solved in, so the results are not identical to the default solver.
+	/// Disabled by default. Only used by cpSpaceStep(), and only on targets with SIMD support.
+	cpBool batchContacts;
+	
 	/// User definable data pointer.
 	/// Generally this points to your game's controller or game state
 	/// class so you can access it when given a cpSpace reference in a callback.
@@ -92,6 +97,7 @@ struct cpSpace {
 	CP_PRIVATE(cpHashSet *cachedArbiters);
 	CP_PRIVATE(cpArray *pooledArbiters);
 	CP_PRIVATE(cpArray *constraints);
+	CP_PRIVATE(cpContactBatches *contactBatches);
 	
 	CP_PRIVATE(cpArray *allocatedBuffers);
 	CP_PRIVATE(int locked);
@@ -136,6 +142,7 @@ CP_DefineSpaceStructProperty(cpFloat, collisionSlop, CollisionSlop)
 CP_DefineSpaceStructProperty(cpFloat, collisionBias, CollisionBias)
 CP_DefineSpaceStructProperty(cpTimestamp, collisionPersistence, CollisionPersistence)
 CP_DefineSpaceStructProperty(cpBool, enableContactGraph, EnableContactGraph)
+CP_DefineSpaceStructProperty(cpBool, batchContacts, BatchContacts)
 CP_DefineSpaceStructProperty(cpDataPointer, data, UserData)
 CP_DefineSpaceStructGetter(cpBody*, staticBody, StaticBody)
 CP_DefineSpaceStructGetter(cpFloat, CP_PRIVATE(curr_dt), CurrentTimeStep)
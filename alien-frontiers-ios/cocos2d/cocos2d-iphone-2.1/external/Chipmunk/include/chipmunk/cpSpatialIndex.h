@@ -93,7 +93,12 @@ cpSpatialIndex* cpBBTreeInit(cpBBTree *tree, cpSpatialIndexBBFunc bbfunc, cpSpat
 cpSpatialIndex* cpBBTreeNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
 
 /// Perform a static top down optimization of the tree.
+/// The tree is rebuilt using the surface area heuristic.
+/// Trees also do this on their own when they are reindexed and their cost has grown too much.
 void cpBBTreeOptimize(cpSpatialIndex *index);
+/// Get the surface area heuristic cost of the tree relative to the size of its root.
+/// Lower is better. Useful for seeing how much the tree has degraded since it was last optimized.
+cpFloat cpBBTreeGetCost(cpSpatialIndex *index);
 
 /// Bounding box tree velocity callback function.
 /// This function should return an estimate for the object's velocity.
@@ -43,8 +43,8 @@ applyCachedImpulse(cpGearJoint *joint, cpFloat dt_coef)
 	cpBody *b = joint->constraint.b;
 	
 	cpFloat j = joint->jAcc*dt_coef;
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv*joint->ratio_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static void
@@ -65,8 +65,8 @@ applyImpulse(cpGearJoint *joint, cpFloat dt)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv*joint->ratio_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static cpFloat
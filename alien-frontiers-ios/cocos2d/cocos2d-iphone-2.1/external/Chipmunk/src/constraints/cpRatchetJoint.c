@@ -60,8 +60,8 @@ applyCachedImpulse(cpRatchetJoint *joint, cpFloat dt_coef)
 	cpBody *b = joint->constraint.b;
 	
 	cpFloat j = joint->jAcc*dt_coef;
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static void
@@ -85,8 +85,8 @@ applyImpulse(cpRatchetJoint *joint, cpFloat dt)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static cpFloat
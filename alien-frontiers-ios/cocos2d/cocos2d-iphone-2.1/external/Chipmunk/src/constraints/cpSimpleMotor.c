@@ -39,8 +39,8 @@ applyCachedImpulse(cpSimpleMotor *joint, cpFloat dt_coef)
 	cpBody *b = joint->constraint.b;
 	
 	cpFloat j = joint->jAcc*dt_coef;
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static void
@@ -61,8 +61,8 @@ applyImpulse(cpSimpleMotor *joint, cpFloat dt)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_velocity(a, -j*a->i_inv);
+	apply_angular_velocity(b, j*b->i_inv);
 }
 
 static cpFloat
@@ -21,6 +21,7 @@
 
 #include "stdlib.h"
 #include "stdio.h"
+#include "string.h"
 
 #include "chipmunk_private.h"
 
@@ -28,6 +29,7 @@ static inline cpSpatialIndexClass *Klass();
 
 typedef struct Node Node;
 typedef struct Pair Pair;
+typedef struct MarkTask MarkTask;
 
 struct cpBBTree {
 	cpSpatialIndex spatialIndex;
@@ -41,6 +43,17 @@ struct cpBBTree {
 	cpArray *allocatedBuffers;
 	
 	cpTimestamp stamp;
+	
+	// Set when leaves are added, removed or moved. Cleared when the cost is checked.
+	cpBool modified;
+	unsigned int optimizeTicks;
+	// Cost of the tree right after it was last rebuilt, 0 if it never was.
+	cpFloat optimizedCost;
+	
+	// Leaves and tasks of a split reindex. See cpBBTreeReindexBegin().
+	cpArray *markLeaves;
+	MarkTask *markTasks;
+	int numMarkTasks, maxMarkTasks;
 };
 
 struct Node {
@@ -476,6 +489,108 @@ MarkSubtree(Node *subtree, MarkContext *context)
 	}
 }
 
+//MARK: Mark Records
+
+// Marking can be split so the queries of the moved leaves run on several threads.
+// Each task records what MarkLeaf() would do for its range of leaves without touching the pairs.
+// The records are then replayed on one thread in the same order MarkSubtree() would visit the leaves.
+
+// PairInsert(leaf, other)
+#define MARK_PAIR_LEAF_FIRST 1
+// PairInsert(other, leaf)
+#define MARK_PAIR_OTHER_FIRST 2
+// func(leaf->obj, other->obj)
+#define MARK_QUERY 4
+
+typedef struct MarkRecord {
+	Node *leaf, *other;
+	int flags;
+} MarkRecord;
+
+struct MarkTask {
+	// Leaves [start, recorded) have their records, leaves [recorded, end) didn't fit.
+	int start, end, recorded;
+	
+	MarkRecord *records;
+	int count, max;
+	cpBool full;
+};
+
+// Same as MarkLeafQuery(), but records the results. Returns cpFalse if the task ran out of room.
+static cpBool
+RecordLeafQuery(Node *subtree, Node *leaf, cpBool left, MarkTask *task)
+{
+	if(cpBBIntersects(leaf->bb, subtree->bb)){
+		if(NodeIsLeaf(subtree)){
+			if(task->count == task->max){
+				task->full = cpTrue;
+				return cpFalse;
+			}
+			
+			MarkRecord *record = task->records + task->count++;
+			record->leaf = leaf;
+			record->other = subtree;
+			if(left){
+				record->flags = MARK_PAIR_LEAF_FIRST;
+			} else {
+				record->flags = MARK_QUERY | (subtree->STAMP < leaf->STAMP ? MARK_PAIR_OTHER_FIRST : 0);
+			}
+		} else {
+			return (
+				RecordLeafQuery(subtree->A, leaf, left, task) &&
+				RecordLeafQuery(subtree->B, leaf, left, task)
+			);
+		}
+	}
+	
+	return cpTrue;
+}
+
+// Same as MarkLeaf() for a moved leaf, but records the results.
+static cpBool
+RecordLeaf(Node *leaf, Node *staticRoot, MarkTask *task)
+{
+	if(staticRoot && !RecordLeafQuery(staticRoot, leaf, cpFalse, task)) return cpFalse;
+	
+	for(Node *node = leaf; node->parent; node = node->parent){
+		if(node == node->parent->A){
+			if(!RecordLeafQuery(node->parent->B, leaf, cpTrue, task)) return cpFalse;
+		} else {
+			if(!RecordLeafQuery(node->parent->A, leaf, cpFalse, task)) return cpFalse;
+		}
+	}
+	
+	return cpTrue;
+}
+
+static void
+ReplayRecord(MarkRecord *record, MarkContext *context)
+{
+	int flags = record->flags;
+	if(flags & MARK_PAIR_LEAF_FIRST) PairInsert(record->leaf, record->other, context->tree);
+	if(flags & MARK_PAIR_OTHER_FIRST) PairInsert(record->other, record->leaf, context->tree);
+	if(flags & MARK_QUERY) context->func(record->leaf->obj, record->other->obj, context->data);
+}
+
+static void
+MarkTasksFree(cpBBTree *tree)
+{
+	for(int i=0; i<tree->maxMarkTasks; i++) cpfree(tree->markTasks[i].records);
+	cpfree(tree->markTasks);
+	if(tree->markLeaves) cpArrayFree(tree->markLeaves);
+}
+
+static void
+CollectLeaves(Node *subtree, cpArray *leaves)
+{
+	if(NodeIsLeaf(subtree)){
+		cpArrayPush(leaves, subtree);
+	} else {
+		CollectLeaves(subtree->A, leaves);
+		CollectLeaves(subtree->B, leaves);
+	}
+}
+
 //MARK: Leaf Functions
 
 static Node *
@@ -506,6 +621,7 @@ LeafUpdate(Node *leaf, cpBBTree *tree)
 		
 		PairsClear(leaf, tree);
 		leaf->STAMP = GetMasterTree(tree)->stamp;
+		tree->modified = cpTrue;
 		
 		return cpTrue;
 	}
@@ -568,6 +684,14 @@ cpBBTreeInit(cpBBTree *tree, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *static
 	
 	tree->stamp = 0;
 	
+	tree->modified = cpFalse;
+	tree->optimizeTicks = 0;
+	tree->optimizedCost = 0.0f;
+	
+	tree->markLeaves = NULL;
+	tree->markTasks = NULL;
+	tree->numMarkTasks = tree->maxMarkTasks = 0;
+	
 	return (cpSpatialIndex *)tree;
 }
 
@@ -595,6 +719,8 @@ cpBBTreeDestroy(cpBBTree *tree)
 	
 	if(tree->allocatedBuffers) cpArrayFreeEach(tree->allocatedBuffers, cpfree);
 	cpArrayFree(tree->allocatedBuffers);
+	
+	MarkTasksFree(tree);
 }
 
 //MARK: Insert/Remove
@@ -610,6 +736,8 @@ cpBBTreeInsert(cpBBTree *tree, void *obj, cpHashValue hashid)
 	leaf->STAMP = GetMasterTree(tree)->stamp;
 	LeafAddPairs(leaf, tree);
 	IncrementStamp(tree);
+	
+	tree->modified = cpTrue;
 }
 
 static void
@@ -620,6 +748,8 @@ cpBBTreeRemove(cpBBTree *tree, void *obj, cpHashValue hashid)
 	tree->root = SubtreeRemove(tree->root, leaf, tree);
 	PairsClear(leaf, tree);
 	NodeRecycle(tree, leaf);
+	
+	tree->modified = cpTrue;
 }
 
 static cpBool
@@ -630,13 +760,27 @@ cpBBTreeContains(cpBBTree *tree, void *obj, cpHashValue hashid)
 
 //MARK: Reindex
 
+static void OptimizeIfNeeded(cpBBTree *tree);
+
 static void
-cpBBTreeReindexQuery(cpBBTree *tree, cpSpatialIndexQueryFunc func, void *data)
+UpdateLeaves(cpBBTree *tree)
 {
-	if(!tree->root) return;
+	// Rebuild the trees before marking if they have degraded.
+	// None of the leaves are stamped with the current stamp yet, so the pairs are unaffected.
+	OptimizeIfNeeded(tree);
+	cpBBTree *staticTree = GetTree(tree->spatialIndex.staticIndex);
+	if(staticTree) OptimizeIfNeeded(staticTree);
 	
 	// LeafUpdate() may modify tree->root. Don't cache it.
 	cpHashSetEach(tree->leaves, (cpHashSetIteratorFunc)LeafUpdate, tree);
+}
+
+static void
+cpBBTreeReindexQuery(cpBBTree *tree, cpSpatialIndexQueryFunc func, void *data)
+{
+	if(!tree->root) return;
+	
+	UpdateLeaves(tree);
 	
 	cpSpatialIndex *staticIndex = tree->spatialIndex.staticIndex;
 	Node *staticRoot = (staticIndex && staticIndex->klass == Klass() ? ((cpBBTree *)staticIndex)->root : NULL);
@@ -648,6 +792,112 @@ cpBBTreeReindexQuery(cpBBTree *tree, cpSpatialIndexQueryFunc func, void *data)
 	IncrementStamp(tree);
 }
 
+int
+cpBBTreeReindexBegin(cpSpatialIndex *index, int numTasks)
+{
+	cpBBTree *tree = GetTree(index);
+	if(!tree) return -1;
+	
+	// The records only cover static leaves from another tree.
+	cpSpatialIndex *staticIndex = tree->spatialIndex.staticIndex;
+	if(staticIndex && !GetTree(staticIndex)) return -1;
+	
+	if(numTasks > tree->maxMarkTasks){
+		tree->markTasks = (MarkTask *)cprealloc(tree->markTasks, numTasks*sizeof(MarkTask));
+		memset(tree->markTasks + tree->maxMarkTasks, 0, (numTasks - tree->maxMarkTasks)*sizeof(MarkTask));
+		tree->maxMarkTasks = numTasks;
+	}
+	
+	tree->numMarkTasks = numTasks;
+	for(int i=0; i<numTasks; i++){
+		MarkTask *task = tree->markTasks + i;
+		task->start = task->end = task->recorded = 0;
+		task->count = 0;
+		task->full = cpFalse;
+	}
+	
+	if(!tree->markLeaves) tree->markLeaves = cpArrayNew(0);
+	tree->markLeaves->num = 0;
+	
+	if(!tree->root) return 0;
+	
+	UpdateLeaves(tree);
+	CollectLeaves(tree->root, tree->markLeaves);
+	
+	return tree->markLeaves->num;
+}
+
+void
+cpBBTreeMarkLeaves(cpSpatialIndex *index, int taskIndex, int start, int end)
+{
+	cpBBTree *tree = GetTree(index);
+	MarkTask *task = tree->markTasks + taskIndex;
+	task->start = task->recorded = start;
+	task->end = end;
+	
+	Node *staticRoot = GetRootIfTree(tree->spatialIndex.staticIndex);
+	cpTimestamp stamp = GetMasterTree(tree)->stamp;
+	Node **leaves = (Node **)tree->markLeaves->arr;
+	
+	for(int i=start; i<end; i++){
+		Node *leaf = leaves[i];
+		if(leaf->STAMP == stamp){
+			// Drop the partial records of a leaf that doesn't fit. It's marked when the records are replayed instead.
+			int count = task->count;
+			if(!RecordLeaf(leaf, staticRoot, task)){
+				task->count = count;
+				break;
+			}
+		}
+		
+		task->recorded = i + 1;
+	}
+}
+
+void
+cpBBTreeReindexEnd(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpBBTree *tree = GetTree(index);
+	if(!tree->root) return;
+	
+	cpSpatialIndex *staticIndex = tree->spatialIndex.staticIndex;
+	Node *staticRoot = GetRootIfTree(staticIndex);
+	MarkContext context = {tree, staticRoot, func, data};
+	
+	cpTimestamp stamp = GetMasterTree(tree)->stamp;
+	Node **leaves = (Node **)tree->markLeaves->arr;
+	int numLeaves = tree->markLeaves->num;
+	
+	int i = 0;
+	for(int t=0; t<tree->numMarkTasks; t++){
+		MarkTask *task = tree->markTasks + t;
+		if(task->start == task->end) continue;
+		cpAssertHard(task->start == i, "Internal Error: The mark tasks must cover the leaves in order.");
+		
+		MarkRecord *record = task->records;
+		for(; i<task->end; i++){
+			Node *leaf = leaves[i];
+			if(i < task->recorded && leaf->STAMP == stamp){
+				for(; record < task->records + task->count && record->leaf == leaf; record++) ReplayRecord(record, &context);
+			} else {
+				MarkLeaf(leaf, &context);
+			}
+		}
+		
+		// Make room for next time.
+		if(task->full){
+			task->max = (task->max ? 2*task->max : CP_BUFFER_BYTES/sizeof(MarkRecord));
+			task->records = (MarkRecord *)cprealloc(task->records, task->max*sizeof(MarkRecord));
+		}
+	}
+	
+	for(; i<numLeaves; i++) MarkLeaf(leaves[i], &context);
+	
+	if(staticIndex && !staticRoot) cpSpatialIndexCollideStatic((cpSpatialIndex *)tree, staticIndex, func, data);
+	
+	IncrementStamp(tree);
+}
+
 static void
 cpBBTreeReindex(cpBBTree *tree)
 {
@@ -724,9 +974,18 @@ static inline cpSpatialIndexClass *Klass(){return &klass;}
 
 //MARK: Tree Optimization
 
-static int
-cpfcompare(const cpFloat *a, const cpFloat *b){
-	return (*a < *b ? -1 : (*b < *a ? 1 : 0));
+// How many reindexes to wait between checking the cost of a modified tree.
+#define OPTIMIZE_INTERVAL 32
+// Rebuild the tree when its cost grows by this much since the last rebuild.
+#define OPTIMIZE_THRESHOLD 1.25f
+// Number of bins per axis used when building the tree.
+#define SAH_BINS 16
+
+// The surface area heuristic uses the perimeter in 2D. (Half of it, but only ratios matter)
+static inline cpFloat
+cpBBPerimeter(cpBB bb)
+{
+	return (bb.r - bb.l) + (bb.t - bb.b);
 }
 
 static void
@@ -735,6 +994,73 @@ fillNodeArray(Node *node, Node ***cursor){
 	(*cursor)++;
 }
 
+static inline cpFloat
+NodeCentroid(Node *node, cpBool splitX)
+{
+	return (splitX ? node->bb.l + node->bb.r : node->bb.b + node->bb.t);
+}
+
+static inline int
+CentroidBin(cpFloat c, cpFloat min, cpFloat scale)
+{
+	int bin = (int)((c - min)*scale);
+	return (bin < SAH_BINS ? bin : SAH_BINS - 1);
+}
+
+typedef struct Split {
+	cpBool splitX;
+	int bin;
+	cpFloat cost;
+} Split;
+
+// Find the cheapest split between the centroid bins along one axis.
+static void
+FindSplit(Node **nodes, int count, cpBool splitX, cpFloat min, cpFloat max, Split *best)
+{
+	if(max <= min) return;
+	cpFloat scale = SAH_BINS/(max - min);
+	
+	int counts[SAH_BINS] = {0};
+	cpBB bbs[SAH_BINS];
+	
+	for(int i=0; i<count; i++){
+		Node *node = nodes[i];
+		int bin = CentroidBin(NodeCentroid(node, splitX), min, scale);
+		bbs[bin] = (counts[bin] ? cpBBMerge(bbs[bin], node->bb) : node->bb);
+		counts[bin]++;
+	}
+	
+	// Sweep from the right to get the cost of everything to the right of each split.
+	cpFloat rightCosts[SAH_BINS];
+	cpBB bb = {0.0f, 0.0f, 0.0f, 0.0f};
+	int n = 0;
+	for(int i=SAH_BINS - 1; i>0; i--){
+		if(counts[i]){
+			bb = (n ? cpBBMerge(bb, bbs[i]) : bbs[i]);
+			n += counts[i];
+		}
+		
+		rightCosts[i] = (n ? n*cpBBPerimeter(bb) : INFINITY);
+	}
+	
+	// Sweep from the left. Splits with nothing on one side have an infinite cost.
+	n = 0;
+	for(int i=0; i<SAH_BINS - 1; i++){
+		if(counts[i]){
+			bb = (n ? cpBBMerge(bb, bbs[i]) : bbs[i]);
+			n += counts[i];
+		}
+		
+		cpFloat cost = (n ? n*cpBBPerimeter(bb) : INFINITY) + rightCosts[i + 1];
+		if(cost < best->cost){
+			best->splitX = splitX;
+			best->bin = i;
+			best->cost = cost;
+		}
+	}
+}
+
+// Build a tree from the nodes by splitting them where the surface area heuristic says is cheapest.
 static Node *
 partitionNodes(cpBBTree *tree, Node **nodes, int count)
 {
@@ -744,53 +1070,37 @@ partitionNodes(cpBBTree *tree, Node **nodes, int count)
 		return NodeNew(tree, nodes[0], nodes[1]);
 	}
 	
-	// Find the AABB for these nodes
-	cpBB bb = nodes[0]->bb;
-	for(int i=1; i<count; i++) bb = cpBBMerge(bb, nodes[i]->bb);
-	
-	// Split it on it's longest axis
-	cpBool splitWidth = (bb.r - bb.l > bb.t - bb.b);
-	
-	// Sort the bounds and use the median as the splitting point
-	cpFloat *bounds = (cpFloat *)cpcalloc(count*2, sizeof(cpFloat));
-	if(splitWidth){
-		for(int i=0; i<count; i++){
-			bounds[2*i + 0] = nodes[i]->bb.l;
-			bounds[2*i + 1] = nodes[i]->bb.r;
-		}
-	} else {
-		for(int i=0; i<count; i++){
-			bounds[2*i + 0] = nodes[i]->bb.b;
-			bounds[2*i + 1] = nodes[i]->bb.t;
-		}
+	// Find the bounds of the centroids
+	cpBB bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+	for(int i=0; i<count; i++){
+		cpFloat x = NodeCentroid(nodes[i], cpTrue), y = NodeCentroid(nodes[i], cpFalse);
+		bounds = cpBBNew(cpfmin(bounds.l, x), cpfmin(bounds.b, y), cpfmax(bounds.r, x), cpfmax(bounds.t, y));
 	}
 	
-	qsort(bounds, count*2, sizeof(cpFloat), (int (*)(const void *, const void *))cpfcompare);
-	cpFloat split = (bounds[count - 1] + bounds[count])*0.5f; // use the medain as the split
-	cpfree(bounds);
-
-	// Generate the child BBs
-	cpBB a = bb, b = bb;
-	if(splitWidth) a.r = b.l = split; else a.t = b.b = split;
+	Split best = {cpFalse, 0, INFINITY};
+	FindSplit(nodes, count, cpTrue, bounds.l, bounds.r, &best);
+	FindSplit(nodes, count, cpFalse, bounds.b, bounds.t, &best);
 	
 	// Partition the nodes
 	int right = count;
-	for(int left=0; left < right;){
-		Node *node = nodes[left];
-		if(cpBBMergedArea(node->bb, b) < cpBBMergedArea(node->bb, a)){
-//		if(cpBBProximity(node->bb, b) < cpBBProximity(node->bb, a)){
-			right--;
-			nodes[left] = nodes[right];
-			nodes[right] = node;
-		} else {
-			left++;
+	if(best.cost < INFINITY){
+		cpFloat min = (best.splitX ? bounds.l : bounds.b);
+		cpFloat max = (best.splitX ? bounds.r : bounds.t);
+		cpFloat scale = SAH_BINS/(max - min);
+		
+		for(int left=0; left < right;){
+			Node *node = nodes[left];
+			if(CentroidBin(NodeCentroid(node, best.splitX), min, scale) > best.bin){
+				right--;
+				nodes[left] = nodes[right];
+				nodes[right] = node;
+			} else {
+				left++;
+			}
 		}
-	}
-	
-	if(right == count){
-		Node *node = NULL;
-		for(int i=0; i<count; i++) node = SubtreeInsert(node, nodes[i], tree);
-		return node;
+	} else {
+		// The centroids are all in the same place. Just split the nodes in half.
+		right = count/2;
 	}
 	
 	// Recurse and build the node!
@@ -800,6 +1110,65 @@ partitionNodes(cpBBTree *tree, Node **nodes, int count)
 	);
 }
 
+static cpFloat
+SubtreeCost(Node *subtree)
+{
+	if(NodeIsLeaf(subtree)){
+		return 0.0f;
+	} else {
+		return cpBBPerimeter(subtree->bb) + SubtreeCost(subtree->A) + SubtreeCost(subtree->B);
+	}
+}
+
+static cpFloat
+TreeCost(cpBBTree *tree)
+{
+	Node *root = tree->root;
+	if(!root || NodeIsLeaf(root)) return 0.0f;
+	
+	cpFloat perimeter = cpBBPerimeter(root->bb);
+	return (perimeter > 0.0f ? SubtreeCost(root)/perimeter : 0.0f);
+}
+
+static void
+TreeRebuild(cpBBTree *tree)
+{
+	Node *root = tree->root;
+	if(!root) return;
+	
+	int count = cpBBTreeCount(tree);
+	Node **nodes = (Node **)cpcalloc(count, sizeof(Node *));
+	Node **cursor = nodes;
+	
+	cpHashSetEach(tree->leaves, (cpHashSetIteratorFunc)fillNodeArray, &cursor);
+	
+	SubtreeRecycle(tree, root);
+	tree->root = partitionNodes(tree, nodes, count);
+	tree->root->parent = NULL;
+	cpfree(nodes);
+	
+	tree->modified = cpFalse;
+	tree->optimizedCost = TreeCost(tree);
+}
+
+// Called at the start of each reindex.
+// A tree that was never rebuilt (such as a static tree that was just filled) is rebuilt right away.
+// Otherwise the cost of a modified tree is checked every OPTIMIZE_INTERVAL reindexes.
+static void
+OptimizeIfNeeded(cpBBTree *tree)
+{
+	if(!tree->modified) return;
+	if(tree->optimizedCost > 0.0f && ++tree->optimizeTicks < OPTIMIZE_INTERVAL) return;
+	
+	tree->modified = cpFalse;
+	tree->optimizeTicks = 0;
+	
+	cpFloat cost = TreeCost(tree);
+	if(cost == 0.0f) return;
+	
+	if(tree->optimizedCost == 0.0f || cost > tree->optimizedCost*OPTIMIZE_THRESHOLD) TreeRebuild(tree);
+}
+
 //static void
 //cpBBTreeOptimizeIncremental(cpBBTree *tree, int passes)
 //{
@@ -827,19 +1196,18 @@ cpBBTreeOptimize(cpSpatialIndex *index)
 		return;
 	}
 	
-	cpBBTree *tree = (cpBBTree *)index;
-	Node *root = tree->root;
-	if(!root) return;
-	
-	int count = cpBBTreeCount(tree);
-	Node **nodes = (Node **)cpcalloc(count, sizeof(Node *));
-	Node **cursor = nodes;
-	
-	cpHashSetEach(tree->leaves, (cpHashSetIteratorFunc)fillNodeArray, &cursor);
+	TreeRebuild((cpBBTree *)index);
+}
+
+cpFloat
+cpBBTreeGetCost(cpSpatialIndex *index)
+{
+	if(index->klass != &klass){
+		cpAssertWarn(cpFalse, "Ignoring cpBBTreeGetCost() call to non-tree spatial index.");
+		return 0.0f;
+	}
 	
-	SubtreeRecycle(tree, root);
-	tree->root = partitionNodes(tree, nodes, count);
-	cpfree(nodes);
+	return TreeCost((cpBBTree *)index);
 }
 
 //MARK: Debug Draw
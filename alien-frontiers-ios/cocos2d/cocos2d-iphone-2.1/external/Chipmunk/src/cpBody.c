@@ -46,6 +46,7 @@ cpBodyInit(cpBody *body, cpFloat m, cpFloat i)
 	
 	cpComponentNode node = {NULL, NULL, 0.0f};
 	body->node = node;
+	body->solverColors = 0;
 	
 	body->p = cpvzero;
 	body->v = cpvzero;
@@ -0,0 +1,441 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "chipmunk_private.h"
+
+// Set CP_BATCH_CONTACTS to 0 to always solve the arbiters one at a time.
+#ifndef CP_BATCH_CONTACTS
+	#define CP_BATCH_CONTACTS 1
+#endif
+
+// The NEON lanes have not been built or tested on ARM yet, so they are off unless CP_BATCH_CONTACTS_NEON is set to 1.
+#ifndef CP_BATCH_CONTACTS_NEON
+	#define CP_BATCH_CONTACTS_NEON 0
+#endif
+
+//MARK: SIMD Lanes
+
+#if CP_BATCH_CONTACTS && defined(__AVX__)
+	#include <immintrin.h>
+	
+	#if CP_USE_DOUBLES
+		#define CP_LANES 4
+		typedef __m256d cpLane;
+		#define cpLaneLoad _mm256_loadu_pd
+		#define cpLaneStore _mm256_storeu_pd
+		#define cpLaneSet _mm256_set1_pd
+		#define cpLaneAdd _mm256_add_pd
+		#define cpLaneSub _mm256_sub_pd
+		#define cpLaneMul _mm256_mul_pd
+		#define cpLaneMin _mm256_min_pd
+		#define cpLaneMax _mm256_max_pd
+	#else
+		#define CP_LANES 8
+		typedef __m256 cpLane;
+		#define cpLaneLoad _mm256_loadu_ps
+		#define cpLaneStore _mm256_storeu_ps
+		#define cpLaneSet _mm256_set1_ps
+		#define cpLaneAdd _mm256_add_ps
+		#define cpLaneSub _mm256_sub_ps
+		#define cpLaneMul _mm256_mul_ps
+		#define cpLaneMin _mm256_min_ps
+		#define cpLaneMax _mm256_max_ps
+	#endif
+#elif CP_BATCH_CONTACTS && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#include <emmintrin.h>
+	
+	#if CP_USE_DOUBLES
+		#define CP_LANES 2
+		typedef __m128d cpLane;
+		#define cpLaneLoad _mm_loadu_pd
+		#define cpLaneStore _mm_storeu_pd
+		#define cpLaneSet _mm_set1_pd
+		#define cpLaneAdd _mm_add_pd
+		#define cpLaneSub _mm_sub_pd
+		#define cpLaneMul _mm_mul_pd
+		#define cpLaneMin _mm_min_pd
+		#define cpLaneMax _mm_max_pd
+	#else
+		#define CP_LANES 4
+		typedef __m128 cpLane;
+		#define cpLaneLoad _mm_loadu_ps
+		#define cpLaneStore _mm_storeu_ps
+		#define cpLaneSet _mm_set1_ps
+		#define cpLaneAdd _mm_add_ps
+		#define cpLaneSub _mm_sub_ps
+		#define cpLaneMul _mm_mul_ps
+		#define cpLaneMin _mm_min_ps
+		#define cpLaneMax _mm_max_ps
+	#endif
+#elif CP_BATCH_CONTACTS && CP_BATCH_CONTACTS_NEON && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (!CP_USE_DOUBLES || defined(__aarch64__))
+	#include <arm_neon.h>
+	
+	#if CP_USE_DOUBLES
+		#define CP_LANES 2
+		typedef float64x2_t cpLane;
+		#define cpLaneLoad vld1q_f64
+		#define cpLaneStore vst1q_f64
+		#define cpLaneSet vdupq_n_f64
+		#define cpLaneAdd vaddq_f64
+		#define cpLaneSub vsubq_f64
+		#define cpLaneMul vmulq_f64
+		#define cpLaneMin vminq_f64
+		#define cpLaneMax vmaxq_f64
+	#else
+		#define CP_LANES 4
+		typedef float32x4_t cpLane;
+		#define cpLaneLoad vld1q_f32
+		#define cpLaneStore vst1q_f32
+		#define cpLaneSet vdupq_n_f32
+		#define cpLaneAdd vaddq_f32
+		#define cpLaneSub vsubq_f32
+		#define cpLaneMul vmulq_f32
+		#define cpLaneMin vminq_f32
+		#define cpLaneMax vmaxq_f32
+	#endif
+#else
+	// No SIMD support, every arbiter is solved with cpArbiterApplyImpulse().
+	#define CP_LANES 1
+#endif
+
+//MARK: Batches
+
+// One contact from each arbiter in a batch.
+// Lanes for arbiters with fewer contacts are zeroed, which makes all of their impulses zero.
+typedef struct cpContactLanes {
+	cpFloat r1x[CP_LANES], r1y[CP_LANES];
+	cpFloat r2x[CP_LANES], r2y[CP_LANES];
+	cpFloat nx[CP_LANES], ny[CP_LANES];
+	cpFloat nMass[CP_LANES], tMass[CP_LANES];
+	cpFloat bias[CP_LANES], bounce[CP_LANES];
+	cpFloat jnAcc[CP_LANES], jtAcc[CP_LANES], jBias[CP_LANES];
+} cpContactLanes;
+
+// CP_LANES arbiters from the same color, so no two of them share a body with a finite mass.
+typedef struct cpContactBatch {
+	cpArbiter *arbiters[CP_LANES];
+	cpBody *a[CP_LANES], *b[CP_LANES];
+	int numContacts;
+	
+	cpFloat u[CP_LANES];
+	cpFloat surface_vrx[CP_LANES], surface_vry[CP_LANES];
+	cpFloat m_inv_a[CP_LANES], i_inv_a[CP_LANES];
+	cpFloat m_inv_b[CP_LANES], i_inv_b[CP_LANES];
+	
+	cpContactLanes contacts[CP_MAX_CONTACTS_PER_ARBITER];
+} cpContactBatch;
+
+struct cpContactBatches {
+	int numBatches, maxBatches;
+	cpContactBatch *batches;
+	
+	// Arbiters that didn't fill a batch, solved one at a time after the batches.
+	int numArbiters, maxArbiters;
+	cpArbiter **arbiters;
+	
+	int maxSorted, maxKeys;
+	cpArbiter **sorted;
+	int *keys;
+};
+
+static void *
+GrowBuffer(void *ptr, int *max, int count, size_t size)
+{
+	if(count > *max){
+		*max = (count > 2*(*max) ? count : 2*(*max));
+		ptr = cprealloc(ptr, (*max)*size);
+	}
+	
+	return ptr;
+}
+
+cpContactBatches *
+cpContactBatchesNew(void)
+{
+	return (cpContactBatches *)cpcalloc(1, sizeof(cpContactBatches));
+}
+
+void
+cpContactBatchesFree(cpContactBatches *batches)
+{
+	if(batches){
+		cpfree(batches->batches);
+		cpfree(batches->arbiters);
+		cpfree(batches->sorted);
+		cpfree(batches->keys);
+		cpfree(batches);
+	}
+}
+
+#if CP_LANES > 1
+
+static void
+FillBatch(cpContactBatch *batch, cpArbiter **arbiters)
+{
+	memset(batch, 0, sizeof(cpContactBatch));
+	
+	for(int l=0; l<CP_LANES; l++){
+		cpArbiter *arb = arbiters[l];
+		cpBody *a = arb->body_a;
+		cpBody *b = arb->body_b;
+		
+		batch->arbiters[l] = arb;
+		batch->a[l] = a;
+		batch->b[l] = b;
+		if(arb->numContacts > batch->numContacts) batch->numContacts = arb->numContacts;
+		
+		batch->u[l] = arb->u;
+		batch->surface_vrx[l] = arb->surface_vr.x;
+		batch->surface_vry[l] = arb->surface_vr.y;
+		batch->m_inv_a[l] = a->m_inv;
+		batch->i_inv_a[l] = a->i_inv;
+		batch->m_inv_b[l] = b->m_inv;
+		batch->i_inv_b[l] = b->i_inv;
+		
+		for(int i=0; i<arb->numContacts; i++){
+			cpContact *con = &arb->contacts[i];
+			cpContactLanes *lanes = &batch->contacts[i];
+			
+			lanes->r1x[l] = con->r1.x; lanes->r1y[l] = con->r1.y;
+			lanes->r2x[l] = con->r2.x; lanes->r2y[l] = con->r2.y;
+			lanes->nx[l] = con->n.x; lanes->ny[l] = con->n.y;
+			lanes->nMass[l] = con->nMass;
+			lanes->tMass[l] = con->tMass;
+			lanes->bias[l] = con->bias;
+			lanes->bounce[l] = con->bounce;
+			lanes->jnAcc[l] = con->jnAcc;
+			lanes->jtAcc[l] = con->jtAcc;
+			lanes->jBias[l] = con->jBias;
+		}
+	}
+}
+
+#endif
+
+void
+cpContactBatchesBuild(cpContactBatches *batches, cpArray *arbiters)
+{
+	int count = arbiters->num;
+	batches->numBatches = 0;
+	batches->numArbiters = 0;
+	batches->arbiters = (cpArbiter **)GrowBuffer(batches->arbiters, &batches->maxArbiters, count, sizeof(cpArbiter *));
+
+#if CP_LANES > 1
+	for(int i=0; i<count; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		arb->body_a->solverColors = 0;
+		arb->body_b->solverColors = 0;
+	}
+	
+	// Sort the arbiters by color, and by their contact count within a color
+	// so that the batches waste as few lanes as possible.
+	batches->sorted = (cpArbiter **)GrowBuffer(batches->sorted, &batches->maxSorted, count, sizeof(cpArbiter *));
+	batches->keys = (int *)GrowBuffer(batches->keys, &batches->maxKeys, count, sizeof(int));
+	
+	const int keysPerColor = CP_MAX_CONTACTS_PER_ARBITER + 1;
+	const int keyCount = (CP_SOLVER_COLOR_COUNT + 1)*keysPerColor;
+	int starts[(CP_SOLVER_COLOR_COUNT + 1)*(CP_MAX_CONTACTS_PER_ARBITER + 1) + 1] = {0};
+	
+	for(int i=0; i<count; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		int key = cpBodyPairSolverColor(arb->body_a, arb->body_b)*keysPerColor + arb->numContacts;
+		batches->keys[i] = key;
+		starts[key + 1]++;
+	}
+	
+	for(int i=0; i<keyCount; i++) starts[i + 1] += starts[i];
+	
+	int next[(CP_SOLVER_COLOR_COUNT + 1)*(CP_MAX_CONTACTS_PER_ARBITER + 1)];
+	memcpy(next, starts, sizeof(next));
+	for(int i=0; i<count; i++) batches->sorted[next[batches->keys[i]]++] = (cpArbiter *)arbiters->arr[i];
+	
+	// Pack full batches from each color. The leftovers and the arbiters that didn't fit in a color are solved one at a time.
+	batches->batches = (cpContactBatch *)GrowBuffer(batches->batches, &batches->maxBatches, count/CP_LANES, sizeof(cpContactBatch));
+	
+	for(int color=0; color<=CP_SOLVER_COLOR_COUNT; color++){
+		int start = starts[color*keysPerColor];
+		int end = starts[(color + 1)*keysPerColor];
+		
+		if(color < CP_SOLVER_COLOR_COUNT){
+			for(; start + CP_LANES <= end; start += CP_LANES){
+				FillBatch(&batches->batches[batches->numBatches++], batches->sorted + start);
+			}
+		}
+		
+		for(int i=start; i<end; i++) batches->arbiters[batches->numArbiters++] = batches->sorted[i];
+	}
+#else
+	memcpy(batches->arbiters, arbiters->arr, count*sizeof(cpArbiter *));
+	batches->numArbiters = count;
+#endif
+}
+
+#if CP_LANES > 1
+
+// Gathers the body velocities into lanes, runs cpArbiterApplyImpulse() on a contact from each lane
+// at a time, then scatters the velocities back. Lanes never share a body that the impulses change,
+// and the bodies that are shared have their unchanged velocities written back.
+static void
+BatchApplyImpulse(cpContactBatch *batch)
+{
+	cpFloat avx[CP_LANES], avy[CP_LANES], aw[CP_LANES];
+	cpFloat abx[CP_LANES], aby[CP_LANES], abw[CP_LANES];
+	cpFloat bvx[CP_LANES], bvy[CP_LANES], bw[CP_LANES];
+	cpFloat bbx[CP_LANES], bby[CP_LANES], bbw[CP_LANES];
+	
+	for(int l=0; l<CP_LANES; l++){
+		cpBody *a = batch->a[l];
+		cpBody *b = batch->b[l];
+		
+		avx[l] = a->v.x; avy[l] = a->v.y; aw[l] = a->w;
+		abx[l] = a->v_bias.x; aby[l] = a->v_bias.y; abw[l] = a->w_bias;
+		bvx[l] = b->v.x; bvy[l] = b->v.y; bw[l] = b->w;
+		bbx[l] = b->v_bias.x; bby[l] = b->v_bias.y; bbw[l] = b->w_bias;
+	}
+	
+	cpLane a_vx = cpLaneLoad(avx), a_vy = cpLaneLoad(avy), a_w = cpLaneLoad(aw);
+	cpLane a_vbx = cpLaneLoad(abx), a_vby = cpLaneLoad(aby), a_wb = cpLaneLoad(abw);
+	cpLane b_vx = cpLaneLoad(bvx), b_vy = cpLaneLoad(bvy), b_w = cpLaneLoad(bw);
+	cpLane b_vbx = cpLaneLoad(bbx), b_vby = cpLaneLoad(bby), b_wb = cpLaneLoad(bbw);
+	
+	cpLane a_m = cpLaneLoad(batch->m_inv_a), a_i = cpLaneLoad(batch->i_inv_a);
+	cpLane b_m = cpLaneLoad(batch->m_inv_b), b_i = cpLaneLoad(batch->i_inv_b);
+	cpLane friction = cpLaneLoad(batch->u);
+	cpLane svx = cpLaneLoad(batch->surface_vrx), svy = cpLaneLoad(batch->surface_vry);
+	cpLane zero = cpLaneSet(0.0f);
+	
+	for(int i=0; i<batch->numContacts; i++){
+		cpContactLanes *con = &batch->contacts[i];
+		cpLane nMass = cpLaneLoad(con->nMass);
+		cpLane nx = cpLaneLoad(con->nx), ny = cpLaneLoad(con->ny);
+		cpLane r1x = cpLaneLoad(con->r1x), r1y = cpLaneLoad(con->r1y);
+		cpLane r2x = cpLaneLoad(con->r2x), r2y = cpLaneLoad(con->r2y);
+		cpLane nr1y = cpLaneSub(zero, r1y), nr2y = cpLaneSub(zero, r2y);
+		
+		cpLane vb1x = cpLaneAdd(a_vbx, cpLaneMul(nr1y, a_wb));
+		cpLane vb1y = cpLaneAdd(a_vby, cpLaneMul(r1x, a_wb));
+		cpLane vb2x = cpLaneAdd(b_vbx, cpLaneMul(nr2y, b_wb));
+		cpLane vb2y = cpLaneAdd(b_vby, cpLaneMul(r2x, b_wb));
+		
+		cpLane vrx = cpLaneSub(cpLaneAdd(b_vx, cpLaneMul(nr2y, b_w)), cpLaneAdd(a_vx, cpLaneMul(nr1y, a_w)));
+		cpLane vry = cpLaneSub(cpLaneAdd(b_vy, cpLaneMul(r2x, b_w)), cpLaneAdd(a_vy, cpLaneMul(r1x, a_w)));
+		vrx = cpLaneAdd(vrx, svx);
+		vry = cpLaneAdd(vry, svy);
+		
+		cpLane vbn = cpLaneAdd(cpLaneMul(cpLaneSub(vb2x, vb1x), nx), cpLaneMul(cpLaneSub(vb2y, vb1y), ny));
+		cpLane vrn = cpLaneAdd(cpLaneMul(vrx, nx), cpLaneMul(vry, ny));
+		cpLane vrt = cpLaneAdd(cpLaneMul(vrx, cpLaneSub(zero, ny)), cpLaneMul(vry, nx));
+		
+		cpLane jbn = cpLaneMul(cpLaneSub(cpLaneLoad(con->bias), vbn), nMass);
+		cpLane jbnOld = cpLaneLoad(con->jBias);
+		cpLane jBias = cpLaneMax(cpLaneAdd(jbnOld, jbn), zero);
+		
+		cpLane jn = cpLaneMul(cpLaneSub(zero, cpLaneAdd(cpLaneLoad(con->bounce), vrn)), nMass);
+		cpLane jnOld = cpLaneLoad(con->jnAcc);
+		cpLane jnAcc = cpLaneMax(cpLaneAdd(jnOld, jn), zero);
+		
+		cpLane jtMax = cpLaneMul(friction, jnAcc);
+		cpLane jt = cpLaneMul(cpLaneSub(zero, vrt), cpLaneLoad(con->tMass));
+		cpLane jtOld = cpLaneLoad(con->jtAcc);
+		cpLane jtAcc = cpLaneMin(cpLaneMax(cpLaneAdd(jtOld, jt), cpLaneSub(zero, jtMax)), jtMax);
+		
+		cpLaneStore(con->jBias, jBias);
+		cpLaneStore(con->jnAcc, jnAcc);
+		cpLaneStore(con->jtAcc, jtAcc);
+		
+		// apply_bias_impulses() with j = n*(jBias - jbnOld)
+		cpLane djb = cpLaneSub(jBias, jbnOld);
+		cpLane jx = cpLaneMul(nx, djb), jy = cpLaneMul(ny, djb);
+		cpLane njx = cpLaneSub(zero, jx), njy = cpLaneSub(zero, jy);
+		
+		a_vbx = cpLaneAdd(a_vbx, cpLaneMul(njx, a_m));
+		a_vby = cpLaneAdd(a_vby, cpLaneMul(njy, a_m));
+		a_wb = cpLaneAdd(a_wb, cpLaneMul(a_i, cpLaneSub(cpLaneMul(r1x, njy), cpLaneMul(r1y, njx))));
+		b_vbx = cpLaneAdd(b_vbx, cpLaneMul(jx, b_m));
+		b_vby = cpLaneAdd(b_vby, cpLaneMul(jy, b_m));
+		b_wb = cpLaneAdd(b_wb, cpLaneMul(b_i, cpLaneSub(cpLaneMul(r2x, jy), cpLaneMul(r2y, jx))));
+		
+		// apply_impulses() with j = cpvrotate(n, cpv(jnAcc - jnOld, jtAcc - jtOld))
+		cpLane djn = cpLaneSub(jnAcc, jnOld), djt = cpLaneSub(jtAcc, jtOld);
+		jx = cpLaneSub(cpLaneMul(nx, djn), cpLaneMul(ny, djt));
+		jy = cpLaneAdd(cpLaneMul(nx, djt), cpLaneMul(ny, djn));
+		njx = cpLaneSub(zero, jx), njy = cpLaneSub(zero, jy);
+		
+		a_vx = cpLaneAdd(a_vx, cpLaneMul(njx, a_m));
+		a_vy = cpLaneAdd(a_vy, cpLaneMul(njy, a_m));
+		a_w = cpLaneAdd(a_w, cpLaneMul(a_i, cpLaneSub(cpLaneMul(r1x, njy), cpLaneMul(r1y, njx))));
+		b_vx = cpLaneAdd(b_vx, cpLaneMul(jx, b_m));
+		b_vy = cpLaneAdd(b_vy, cpLaneMul(jy, b_m));
+		b_w = cpLaneAdd(b_w, cpLaneMul(b_i, cpLaneSub(cpLaneMul(r2x, jy), cpLaneMul(r2y, jx))));
+	}
+	
+	cpLaneStore(avx, a_vx); cpLaneStore(avy, a_vy); cpLaneStore(aw, a_w);
+	cpLaneStore(abx, a_vbx); cpLaneStore(aby, a_vby); cpLaneStore(abw, a_wb);
+	cpLaneStore(bvx, b_vx); cpLaneStore(bvy, b_vy); cpLaneStore(bw, b_w);
+	cpLaneStore(bbx, b_vbx); cpLaneStore(bby, b_vby); cpLaneStore(bbw, b_wb);
+	
+	for(int l=0; l<CP_LANES; l++){
+		cpBody *a = batch->a[l];
+		cpBody *b = batch->b[l];
+		
+		a->v = cpv(avx[l], avy[l]); a->w = aw[l];
+		a->v_bias = cpv(abx[l], aby[l]); a->w_bias = abw[l];
+		b->v = cpv(bvx[l], bvy[l]); b->w = bw[l];
+		b->v_bias = cpv(bbx[l], bby[l]); b->w_bias = bbw[l];
+	}
+}
+
+#endif
+
+void
+cpContactBatchesApplyImpulse(cpContactBatches *batches)
+{
+#if CP_LANES > 1
+	for(int i=0; i<batches->numBatches; i++) BatchApplyImpulse(&batches->batches[i]);
+#endif
+
+	for(int i=0; i<batches->numArbiters; i++) cpArbiterApplyImpulse(batches->arbiters[i]);
+}
+
+void
+cpContactBatchesStoreImpulses(cpContactBatches *batches)
+{
+#if CP_LANES > 1
+	for(int i=0; i<batches->numBatches; i++){
+		cpContactBatch *batch = &batches->batches[i];
+		
+		for(int l=0; l<CP_LANES; l++){
+			cpArbiter *arb = batch->arbiters[l];
+			
+			for(int j=0; j<arb->numContacts; j++){
+				cpContact *con = &arb->contacts[j];
+				cpContactLanes *lanes = &batch->contacts[j];
+				
+				con->jnAcc = lanes->jnAcc[l];
+				con->jtAcc = lanes->jtAcc[l];
+				con->jBias = lanes->jBias[l];
+			}
+		}
+	}
+#endif
+}
@@ -19,36 +19,66 @@
  * SOFTWARE.
  */
  
+#include <string.h>
+
 #include "chipmunk_private.h"
-#include "prime.h"
+
+// cpHashSet is an open addressed Robin Hood hash table.
+// Each element is stored as close to its home slot as it can be, and an
+// element that is further from home takes the slot of one that is closer.
+// Elements are removed by shifting the ones that follow them back a slot,
+// so there are no tombstones.
+// The table doesn't wrap around. It has some extra slots past the end instead,
+// and more are added if an element needs to go further than that.
+// This also means cpHashSetEach() and cpHashSetFilter() can walk the table
+// backwards and have the function remove the current element.
+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+	#define HASH_BITS 64
+	#define HASH_MULTIPLIER ((cpHashValue)11400714819323198485ull)
+#else
+	#define HASH_BITS 32
+	#define HASH_MULTIPLIER ((cpHashValue)2654435769u)
+#endif
+
+#define MIN_SIZE_BITS 4
 
 typedef struct cpHashSetBin {
 	void *elt;
 	cpHashValue hash;
-	struct cpHashSetBin *next;
+	// Distance from the element's home slot plus one, or 0 if the bin is empty.
+	unsigned int probe;
 } cpHashSetBin;
 
 struct cpHashSet {
 	unsigned int entries, size;
+	// The table has size home slots followed by (capacity - size) overflow slots.
+	unsigned int sizeBits, capacity;
 	
 	cpHashSetEqlFunc eql;
 	void *default_value;
 	
-	cpHashSetBin **table;
-	cpHashSetBin *pooledBins;
-	
-	cpArray *allocatedBuffers;
+	cpHashSetBin *table;
 };
 
+static inline unsigned int
+HomeSlot(cpHashValue hash, unsigned int sizeBits)
+{
+	// Fibonacci hashing. The hash pairs of aligned pointers have their low bits clear, so use the high ones.
+	return (unsigned int)((hash*HASH_MULTIPLIER) >> (HASH_BITS - sizeBits));
+}
+
+static inline unsigned int
+OverflowSlots(unsigned int sizeBits)
+{
+	return 2*sizeBits;
+}
+
 void
 cpHashSetFree(cpHashSet *set)
 {
 	if(set){
 		cpfree(set->table);
-		
-		cpArrayFreeEach(set->allocatedBuffers, cpfree);
-		cpArrayFree(set->allocatedBuffers);
-		
 		cpfree(set);
 	}
 }
@@ -58,16 +88,18 @@ cpHashSetNew(int size, cpHashSetEqlFunc eqlFunc)
 {
 	cpHashSet *set = (cpHashSet *)cpcalloc(1, sizeof(cpHashSet));
 	
-	set->size = next_prime(size);
+	unsigned int sizeBits = MIN_SIZE_BITS;
+	while((1u << sizeBits) < (unsigned int)size) sizeBits++;
+	
+	set->sizeBits = sizeBits;
+	set->size = 1u << sizeBits;
+	set->capacity = set->size + OverflowSlots(sizeBits);
 	set->entries = 0;
 	
 	set->eql = eqlFunc;
 	set->default_value = NULL;
 	
-	set->table = (cpHashSetBin **)cpcalloc(set->size, sizeof(cpHashSetBin *));
-	set->pooledBins = NULL;
-	
-	set->allocatedBuffers = cpArrayNew(0);
+	set->table = (cpHashSetBin *)cpcalloc(set->capacity, sizeof(cpHashSetBin));
 	
 	return set;
 }
@@ -78,69 +110,64 @@ cpHashSetSetDefaultValue(cpHashSet *set, void *default_value)
 	set->default_value = default_value;
 }
 
-static int
-setIsFull(cpHashSet *set)
+// Insert a bin that isn't in the table yet, moving aside the bins that are closer to home.
+// Adds more overflow slots if a bin is pushed off the end of the table.
+static void
+PlaceBin(cpHashSetBin **table, unsigned int *capacity, unsigned int sizeBits, cpHashSetBin bin)
 {
-	return (set->entries >= set->size);
+	unsigned int idx = HomeSlot(bin.hash, sizeBits);
+	
+	for(bin.probe = 1;; idx++, bin.probe++){
+		if(idx == (*capacity)){
+			unsigned int newCapacity = (*capacity) + OverflowSlots(sizeBits);
+			(*table) = (cpHashSetBin *)cprealloc(*table, newCapacity*sizeof(cpHashSetBin));
+			memset((*table) + (*capacity), 0, (newCapacity - (*capacity))*sizeof(cpHashSetBin));
+			(*capacity) = newCapacity;
+		}
+		
+		cpHashSetBin *slot = (*table) + idx;
+		
+		if(slot->probe == 0){
+			(*slot) = bin;
+			return;
+		} else if(slot->probe < bin.probe){
+			cpHashSetBin tmp = (*slot);
+			(*slot) = bin;
+			bin = tmp;
+		}
+	}
 }
 
 static void
-cpHashSetResize(cpHashSet *set)
+cpHashSetResize(cpHashSet *set, unsigned int sizeBits)
 {
-	// Get the next approximate doubled prime.
-	unsigned int newSize = next_prime(set->size + 1);
-	// Allocate a new table.
-	cpHashSetBin **newTable = (cpHashSetBin **)cpcalloc(newSize, sizeof(cpHashSetBin *));
-	
-	// Iterate over the chains.
-	for(unsigned int i=0; i<set->size; i++){
-		// Rehash the bins into the new table.
-		cpHashSetBin *bin = set->table[i];
-		while(bin){
-			cpHashSetBin *next = bin->next;
-			
-			cpHashValue idx = bin->hash%newSize;
-			bin->next = newTable[idx];
-			newTable[idx] = bin;
-			
-			bin = next;
-		}
+	unsigned int capacity = (1u << sizeBits) + OverflowSlots(sizeBits);
+	cpHashSetBin *table = (cpHashSetBin *)cpcalloc(capacity, sizeof(cpHashSetBin));
+	
+	for(unsigned int i=0; i<set->capacity; i++){
+		if(set->table[i].probe) PlaceBin(&table, &capacity, sizeBits, set->table[i]);
 	}
 	
 	cpfree(set->table);
 	
-	set->table = newTable;
-	set->size = newSize;
-}
-
-static inline void
-recycleBin(cpHashSet *set, cpHashSetBin *bin)
-{
-	bin->next = set->pooledBins;
-	set->pooledBins = bin;
-	bin->elt = NULL;
+	set->table = table;
+	set->capacity = capacity;
+	set->sizeBits = sizeBits;
+	set->size = 1u << sizeBits;
 }
 
-static cpHashSetBin *
-getUnusedBin(cpHashSet *set)
+static inline cpHashSetBin *
+FindBin(cpHashSet *set, cpHashValue hash, void *ptr)
 {
-	cpHashSetBin *bin = set->pooledBins;
+	unsigned int idx = HomeSlot(hash, set->sizeBits);
 	
-	if(bin){
-		set->pooledBins = bin->next;
-		return bin;
-	} else {
-		// Pool is exhausted, make more
-		int count = CP_BUFFER_BYTES/sizeof(cpHashSetBin);
-		cpAssertHard(count, "Internal Error: Buffer size is too small.");
-		
-		cpHashSetBin *buffer = (cpHashSetBin *)cpcalloc(1, CP_BUFFER_BYTES);
-		cpArrayPush(set->allocatedBuffers, buffer);
-		
-		// push all but the first one, return it instead
-		for(int i=1; i<count; i++) recycleBin(set, buffer + i);
-		return buffer;
+	// Once the bins are closer to their home than ptr would be, it can't be in the table.
+	for(unsigned int probe = 1; idx < set->capacity && probe <= set->table[idx].probe; idx++, probe++){
+		cpHashSetBin *bin = set->table + idx;
+		if(bin->hash == hash && set->eql(ptr, bin->elt)) return bin;
 	}
+	
+	return NULL;
 }
 
 int
@@ -152,51 +179,48 @@ cpHashSetCount(cpHashSet *set)
 void *
 cpHashSetInsert(cpHashSet *set, cpHashValue hash, void *ptr, void *data, cpHashSetTransFunc trans)
 {
-	cpHashValue idx = hash%set->size;
-	
 	// Find the bin with the matching element.
-	cpHashSetBin *bin = set->table[idx];
-	while(bin && !set->eql(ptr, bin->elt))
-		bin = bin->next;
+	cpHashSetBin *found = FindBin(set, hash, ptr);
+	if(found) return found->elt;
 	
 	// Create it if necessary.
-	if(!bin){
-		bin = getUnusedBin(set);
-		bin->hash = hash;
-		bin->elt = (trans ? trans(ptr, data) : data);
-		
-		bin->next = set->table[idx];
-		set->table[idx] = bin;
-		
-		set->entries++;
-		if(setIsFull(set)) cpHashSetResize(set);
+	void *elt = (trans ? trans(ptr, data) : data);
+	cpHashSetBin bin = {elt, hash, 0};
+	PlaceBin(&set->table, &set->capacity, set->sizeBits, bin);
+	
+	// Keep the table at most 3/4 full so the probes stay short.
+	set->entries++;
+	if(4*set->entries > 3*set->size) cpHashSetResize(set, set->sizeBits + 1);
+	
+	return elt;
+}
+
+// Remove the bin at idx by shifting back the bins after it until one is empty or already at home.
+static void
+RemoveBin(cpHashSet *set, unsigned int idx)
+{
+	cpHashSetBin *table = set->table;
+	unsigned int end = set->capacity;
+	
+	for(; idx + 1 < end && table[idx + 1].probe > 1; idx++){
+		table[idx] = table[idx + 1];
+		table[idx].probe--;
 	}
 	
-	return bin->elt;
+	table[idx].probe = 0;
+	table[idx].elt = NULL;
+	set->entries--;
 }
 
 void *
 cpHashSetRemove(cpHashSet *set, cpHashValue hash, void *ptr)
 {
-	cpHashValue idx = hash%set->size;
-	
-	cpHashSetBin **prev_ptr = &set->table[idx];
-	cpHashSetBin *bin = set->table[idx];
-	
-	// Find the bin
-	while(bin && !set->eql(ptr, bin->elt)){
-		prev_ptr = &bin->next;
-		bin = bin->next;
-	}
+	cpHashSetBin *bin = FindBin(set, hash, ptr);
 	
 	// Remove it if it exists.
 	if(bin){
-		// Update the previous linked list pointer
-		(*prev_ptr) = bin->next;
-		set->entries--;
-		
 		void *elt = bin->elt;
-		recycleBin(set, bin);
+		RemoveBin(set, (unsigned int)(bin - set->table));
 		
 		return elt;
 	}
@@ -206,48 +230,26 @@ cpHashSetRemove(cpHashSet *set, cpHashValue hash, void *ptr)
 
 void *
 cpHashSetFind(cpHashSet *set, cpHashValue hash, void *ptr)
-{	
-	cpHashValue idx = hash%set->size;
-	cpHashSetBin *bin = set->table[idx];
-	while(bin && !set->eql(ptr, bin->elt))
-		bin = bin->next;
-		
+{
+	cpHashSetBin *bin = FindBin(set, hash, ptr);
 	return (bin ? bin->elt : set->default_value);
 }
 
 void
 cpHashSetEach(cpHashSet *set, cpHashSetIteratorFunc func, void *data)
 {
-	for(unsigned int i=0; i<set->size; i++){
-		cpHashSetBin *bin = set->table[i];
-		while(bin){
-			cpHashSetBin *next = bin->next;
-			func(bin->elt, data);
-			bin = next;
-		}
+	// Walk backwards so removing the current element only shifts back bins that were already visited.
+	for(unsigned int i=set->capacity; i-- > 0;){
+		cpHashSetBin *bin = set->table + i;
+		if(bin->probe) func(bin->elt, data);
 	}
 }
 
 void
 cpHashSetFilter(cpHashSet *set, cpHashSetFilterFunc func, void *data)
 {
-	for(unsigned int i=0; i<set->size; i++){
-		// The rest works similarly to cpHashSetRemove() above.
-		cpHashSetBin **prev_ptr = &set->table[i];
-		cpHashSetBin *bin = set->table[i];
-		while(bin){
-			cpHashSetBin *next = bin->next;
-			
-			if(func(bin->elt, data)){
-				prev_ptr = &bin->next;
-			} else {
-				(*prev_ptr) = next;
-
-				set->entries--;
-				recycleBin(set, bin);
-			}
-			
-			bin = next;
-		}
+	for(unsigned int i=set->capacity; i-- > 0;){
+		cpHashSetBin *bin = set->table + i;
+		if(bin->probe && !func(bin->elt, data)) RemoveBin(set, i);
 	}
 }
@@ -0,0 +1,685 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "chipmunk_private.h"
+#include "cpHastySpace.h"
+
+#ifdef _WIN32
+	#define CP_HASTY_THREADS 0
+#else
+	#define CP_HASTY_THREADS 1
+	#include <pthread.h>
+	#include <sched.h>
+	#include <unistd.h>
+#endif
+
+#define MAX_THREADS 16
+
+// Arbiters and constraints that don't fit in the colors are solved by the calling thread alone.
+#define COLOR_COUNT CP_SOLVER_COLOR_COUNT
+#define OVERFLOW_COLOR COLOR_COUNT
+
+typedef struct cpHastySpace cpHastySpace;
+
+typedef struct cpHastyWorker {
+	cpHastySpace *hasty;
+	int index;
+	
+	// The barrier sense and the last work generation the worker ran.
+	int sense;
+	unsigned long generation;
+} cpHastyWorker;
+
+typedef void (*cpHastyWorkFunc)(cpHastyWorker *worker);
+
+// A shape pair that passed the broadphase, along with its narrow-phase result.
+typedef struct cpHastyPair {
+	cpShape *a, *b;
+	cpCollisionHandler *handler;
+	cpBool sensor;
+	
+	int numContacts;
+	cpContact contacts[CP_MAX_CONTACTS_PER_ARBITER];
+} cpHastyPair;
+
+struct cpHastySpace {
+	cpSpace space;
+	
+	int numThreads;
+	cpHastyWorker workers[MAX_THREADS];
+	cpHastyWorkFunc work;
+
+#if CP_HASTY_THREADS
+	pthread_t threads[MAX_THREADS];
+	pthread_mutex_t mutex;
+	pthread_cond_t workCond;
+	pthread_cond_t doneCond;
+	unsigned long generation;
+	int pending;
+	cpBool exiting;
+	
+	int barrierCount;
+	int barrierSense;
+#endif
+
+	// Step parameters shared with the workers.
+	cpFloat dt, dt_coef, slop, biasCoef, damping;
+	
+	cpArray *shapes;
+	int numLeaves;
+	
+	cpHastyPair *pairs;
+	int numPairs, maxPairs;
+	
+	// The arbiters and constraints sorted by color.
+	// Color i is [starts[i], starts[i + 1]) and the overflow color comes last.
+	cpArbiter **coloredArbiters;
+	int maxColoredArbiters;
+	int arbiterStarts[COLOR_COUNT + 2];
+	
+	cpConstraint **coloredConstraints;
+	int maxColoredConstraints;
+	int constraintStarts[COLOR_COUNT + 2];
+	
+	int *colors;
+	int maxColors;
+};
+
+//MARK: Thread Pool
+
+static void
+WorkerRange(cpHastyWorker *worker, int count, int *start, int *end)
+{
+	int numThreads = worker->hasty->numThreads;
+	*start = count*worker->index/numThreads;
+	*end = count*(worker->index + 1)/numThreads;
+}
+
+#if CP_HASTY_THREADS
+
+static void
+WorkerBarrier(cpHastyWorker *worker)
+{
+	cpHastySpace *hasty = worker->hasty;
+	if(hasty->numThreads == 1) return;
+	
+	int sense = worker->sense = !worker->sense;
+	if(__atomic_add_fetch(&hasty->barrierCount, 1, __ATOMIC_ACQ_REL) == hasty->numThreads){
+		__atomic_store_n(&hasty->barrierCount, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&hasty->barrierSense, sense, __ATOMIC_RELEASE);
+	} else {
+		// Spin for a little while before giving up the CPU.
+		for(int i=0; __atomic_load_n(&hasty->barrierSense, __ATOMIC_ACQUIRE) != sense; i++){
+			if(i > 1000) sched_yield();
+		}
+	}
+}
+
+static void *
+WorkerThread(void *context)
+{
+	cpHastyWorker *worker = (cpHastyWorker *)context;
+	cpHastySpace *hasty = worker->hasty;
+	
+	pthread_mutex_lock(&hasty->mutex);
+	
+	for(;;){
+		while(hasty->generation == worker->generation && !hasty->exiting){
+			pthread_cond_wait(&hasty->workCond, &hasty->mutex);
+		}
+		
+		if(hasty->exiting) break;
+		
+		worker->generation = hasty->generation;
+		cpHastyWorkFunc work = hasty->work;
+		pthread_mutex_unlock(&hasty->mutex);
+		
+		work(worker);
+		
+		pthread_mutex_lock(&hasty->mutex);
+		if(--hasty->pending == 0) pthread_cond_signal(&hasty->doneCond);
+	}
+	
+	pthread_mutex_unlock(&hasty->mutex);
+	return NULL;
+}
+
+// Run the work function on every thread. The calling thread is worker 0.
+static void
+RunWorkers(cpHastySpace *hasty, cpHastyWorkFunc work)
+{
+	if(hasty->numThreads == 1){
+		work(&hasty->workers[0]);
+		return;
+	}
+	
+	pthread_mutex_lock(&hasty->mutex);
+	hasty->work = work;
+	hasty->pending = hasty->numThreads - 1;
+	hasty->generation++;
+	pthread_cond_broadcast(&hasty->workCond);
+	pthread_mutex_unlock(&hasty->mutex);
+	
+	work(&hasty->workers[0]);
+	
+	pthread_mutex_lock(&hasty->mutex);
+	while(hasty->pending) pthread_cond_wait(&hasty->doneCond, &hasty->mutex);
+	pthread_mutex_unlock(&hasty->mutex);
+}
+
+static void
+StopThreads(cpHastySpace *hasty)
+{
+	pthread_mutex_lock(&hasty->mutex);
+	hasty->exiting = cpTrue;
+	pthread_cond_broadcast(&hasty->workCond);
+	pthread_mutex_unlock(&hasty->mutex);
+	
+	for(int i=1; i<hasty->numThreads; i++) pthread_join(hasty->threads[i], NULL);
+	
+	hasty->exiting = cpFalse;
+	hasty->numThreads = 1;
+}
+
+static void
+StartThreads(cpHastySpace *hasty, int numThreads)
+{
+	hasty->numThreads = numThreads;
+	
+	for(int i=0; i<numThreads; i++){
+		hasty->workers[i].sense = hasty->barrierSense;
+		hasty->workers[i].generation = hasty->generation;
+	}
+	
+	for(int i=1; i<numThreads; i++){
+		pthread_create(&hasty->threads[i], NULL, WorkerThread, &hasty->workers[i]);
+	}
+}
+
+static int
+CPUCount(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0 ? (int)count : 1);
+}
+
+#else
+
+static void WorkerBarrier(cpHastyWorker *worker){}
+
+static void
+RunWorkers(cpHastySpace *hasty, cpHastyWorkFunc work)
+{
+	work(&hasty->workers[0]);
+}
+
+static void StopThreads(cpHastySpace *hasty){}
+static void StartThreads(cpHastySpace *hasty, int numThreads){}
+static int CPUCount(void){return 1;}
+
+#endif
+
+//MARK: Memory Management Functions
+
+static void *
+GrowBuffer(void *ptr, int *max, int count, size_t size)
+{
+	if(count > *max){
+		*max = (count > 2*(*max) ? count : 2*(*max));
+		ptr = cprealloc(ptr, (*max)*size);
+	}
+	
+	return ptr;
+}
+
+cpSpace *
+cpHastySpaceNew(void)
+{
+	cpHastySpace *hasty = (cpHastySpace *)cpcalloc(1, sizeof(cpHastySpace));
+	cpSpaceInit(&hasty->space);
+	
+	hasty->numThreads = 1;
+	for(int i=0; i<MAX_THREADS; i++){
+		hasty->workers[i].hasty = hasty;
+		hasty->workers[i].index = i;
+	}
+
+#if CP_HASTY_THREADS
+	pthread_mutex_init(&hasty->mutex, NULL);
+	pthread_cond_init(&hasty->workCond, NULL);
+	pthread_cond_init(&hasty->doneCond, NULL);
+#endif
+
+	hasty->shapes = cpArrayNew(0);
+	
+	return &hasty->space;
+}
+
+void
+cpHastySpaceFree(cpSpace *space)
+{
+	if(space){
+		cpHastySpace *hasty = (cpHastySpace *)space;
+		StopThreads(hasty);
+
+#if CP_HASTY_THREADS
+		pthread_mutex_destroy(&hasty->mutex);
+		pthread_cond_destroy(&hasty->workCond);
+		pthread_cond_destroy(&hasty->doneCond);
+#endif
+
+		cpArrayFree(hasty->shapes);
+		cpfree(hasty->pairs);
+		cpfree(hasty->coloredArbiters);
+		cpfree(hasty->coloredConstraints);
+		cpfree(hasty->colors);
+		
+		cpSpaceDestroy(space);
+		cpfree(hasty);
+	}
+}
+
+void
+cpHastySpaceSetThreads(cpSpace *space, unsigned long threads)
+{
+	cpHastySpace *hasty = (cpHastySpace *)space;
+	cpAssertHard(!space->locked, "The number of threads cannot be changed during a step.");
+	
+	int numThreads = (threads == 0 ? CPUCount() : (int)(threads < MAX_THREADS ? threads : MAX_THREADS));
+	if(numThreads > MAX_THREADS) numThreads = MAX_THREADS;
+	
+	if(numThreads != hasty->numThreads){
+		StopThreads(hasty);
+		StartThreads(hasty, numThreads);
+	}
+}
+
+unsigned long
+cpHastySpaceGetThreads(cpSpace *space)
+{
+	return ((cpHastySpace *)space)->numThreads;
+}
+
+//MARK: Coloring
+
+static inline void
+ResetColors(cpBody *a, cpBody *b)
+{
+	a->solverColors = 0;
+	b->solverColors = 0;
+}
+
+// Sort the items by their color into sorted and fill in the start of each color.
+static void
+SortByColor(void **items, int count, int *colors, void **sorted, int *starts)
+{
+	int counts[COLOR_COUNT + 1] = {0};
+	for(int i=0; i<count; i++) counts[colors[i]]++;
+	
+	starts[0] = 0;
+	for(int i=0; i<=COLOR_COUNT; i++) starts[i + 1] = starts[i] + counts[i];
+	
+	int next[COLOR_COUNT + 1];
+	memcpy(next, starts, sizeof(next));
+	for(int i=0; i<count; i++) sorted[next[colors[i]]++] = items[i];
+}
+
+static void
+ColorArbitersAndConstraints(cpHastySpace *hasty)
+{
+	cpArray *arbiters = hasty->space.arbiters;
+	cpArray *constraints = hasty->space.constraints;
+	
+	hasty->coloredArbiters = (cpArbiter **)GrowBuffer(hasty->coloredArbiters, &hasty->maxColoredArbiters, arbiters->num, sizeof(cpArbiter *));
+	hasty->coloredConstraints = (cpConstraint **)GrowBuffer(hasty->coloredConstraints, &hasty->maxColoredConstraints, constraints->num, sizeof(cpConstraint *));
+	hasty->colors = (int *)GrowBuffer(hasty->colors, &hasty->maxColors, arbiters->num + constraints->num, sizeof(int));
+	
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		ResetColors(arb->body_a, arb->body_b);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		ResetColors(constraint->a, constraint->b);
+	}
+	
+	int *arbiterColors = hasty->colors;
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		arbiterColors[i] = cpBodyPairSolverColor(arb->body_a, arb->body_b);
+	}
+	
+	int *constraintColors = hasty->colors + arbiters->num;
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		constraintColors[i] = cpBodyPairSolverColor(constraint->a, constraint->b);
+	}
+	
+	SortByColor(arbiters->arr, arbiters->num, arbiterColors, (void **)hasty->coloredArbiters, hasty->arbiterStarts);
+	SortByColor(constraints->arr, constraints->num, constraintColors, (void **)hasty->coloredConstraints, hasty->constraintStarts);
+}
+
+//MARK: Work Functions
+
+static void
+IntegratePositions(cpHastyWorker *worker)
+{
+	cpHastySpace *hasty = worker->hasty;
+	int start, end;
+	
+	cpArray *bodies = hasty->space.bodies;
+	cpFloat dt = hasty->dt;
+	WorkerRange(worker, bodies->num, &start, &end);
+	for(int i=start; i<end; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		body->position_func(body, dt);
+	}
+	
+	WorkerBarrier(worker);
+	
+	cpArray *shapes = hasty->shapes;
+	WorkerRange(worker, shapes->num, &start, &end);
+	for(int i=start; i<end; i++){
+		cpShapeUpdateFunc((cpShape *)shapes->arr[i], NULL);
+	}
+}
+
+static void
+MarkLeaves(cpHastyWorker *worker)
+{
+	cpHastySpace *hasty = worker->hasty;
+	int start, end;
+	
+	WorkerRange(worker, hasty->numLeaves, &start, &end);
+	cpBBTreeMarkLeaves(hasty->space.activeShapes, worker->index, start, end);
+}
+
+static void
+CollidePairs(cpHastyWorker *worker)
+{
+	cpHastySpace *hasty = worker->hasty;
+	int start, end;
+	
+	WorkerRange(worker, hasty->numPairs, &start, &end);
+	for(int i=start; i<end; i++){
+		cpHastyPair *pair = hasty->pairs + i;
+		pair->numContacts = cpCollideShapes(pair->a, pair->b, pair->contacts);
+	}
+}
+
+static void
+ApplyCachedImpulses(cpHastyWorker *worker, int color)
+{
+	cpHastySpace *hasty = worker->hasty;
+	cpFloat dt_coef = hasty->dt_coef;
+	
+	int arbiterStart = hasty->arbiterStarts[color];
+	int numArbiters = hasty->arbiterStarts[color + 1] - arbiterStart;
+	int constraintStart = hasty->constraintStarts[color];
+	int count = numArbiters + hasty->constraintStarts[color + 1] - constraintStart;
+	
+	int start, end;
+	if(color == OVERFLOW_COLOR){
+		start = 0;
+		end = (worker->index == 0 ? count : 0);
+	} else {
+		WorkerRange(worker, count, &start, &end);
+	}
+	
+	for(int i=start; i<end; i++){
+		if(i < numArbiters){
+			cpArbiterApplyCachedImpulse(hasty->coloredArbiters[arbiterStart + i], dt_coef);
+		} else {
+			cpConstraint *constraint = hasty->coloredConstraints[constraintStart + i - numArbiters];
+			constraint->klass->applyCachedImpulse(constraint, dt_coef);
+		}
+	}
+}
+
+static void
+ApplyImpulses(cpHastyWorker *worker, int color)
+{
+	cpHastySpace *hasty = worker->hasty;
+	cpFloat dt = hasty->dt;
+	
+	int arbiterStart = hasty->arbiterStarts[color];
+	int numArbiters = hasty->arbiterStarts[color + 1] - arbiterStart;
+	int constraintStart = hasty->constraintStarts[color];
+	int count = numArbiters + hasty->constraintStarts[color + 1] - constraintStart;
+	
+	int start, end;
+	if(color == OVERFLOW_COLOR){
+		start = 0;
+		end = (worker->index == 0 ? count : 0);
+	} else {
+		WorkerRange(worker, count, &start, &end);
+	}
+	
+	for(int i=start; i<end; i++){
+		if(i < numArbiters){
+			cpArbiterApplyImpulse(hasty->coloredArbiters[arbiterStart + i]);
+		} else {
+			cpConstraint *constraint = hasty->coloredConstraints[constraintStart + i - numArbiters];
+			constraint->klass->applyImpulse(constraint, dt);
+		}
+	}
+}
+
+static inline cpBool
+ColorIsEmpty(cpHastySpace *hasty, int color)
+{
+	return (
+		hasty->arbiterStarts[color] == hasty->arbiterStarts[color + 1] &&
+		hasty->constraintStarts[color] == hasty->constraintStarts[color + 1]
+	);
+}
+
+static void
+Solve(cpHastyWorker *worker)
+{
+	cpHastySpace *hasty = worker->hasty;
+	cpSpace *space = &hasty->space;
+	int start, end;
+	
+	// Prestep the arbiters.
+	cpArray *arbiters = space->arbiters;
+	cpFloat dt = hasty->dt;
+	cpFloat slop = hasty->slop;
+	cpFloat biasCoef = hasty->biasCoef;
+	WorkerRange(worker, arbiters->num, &start, &end);
+	for(int i=start; i<end; i++){
+		cpArbiterPreStep((cpArbiter *)arbiters->arr[i], dt, slop, biasCoef);
+	}
+	
+	WorkerBarrier(worker);
+	
+	// Prestep the constraints on the calling thread. The preSolve callbacks can
+	// do anything and some constraints apply impulses in their prestep.
+	if(worker->index == 0){
+		cpArray *constraints = space->constraints;
+		for(int i=0; i<constraints->num; i++){
+			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+			
+			cpConstraintPreSolveFunc preSolve = constraint->preSolve;
+			if(preSolve) preSolve(constraint, space);
+			
+			constraint->klass->preStep(constraint, dt);
+		}
+	}
+	
+	WorkerBarrier(worker);
+	
+	// Integrate velocities.
+	cpArray *bodies = space->bodies;
+	cpFloat damping = hasty->damping;
+	cpVect gravity = space->gravity;
+	WorkerRange(worker, bodies->num, &start, &end);
+	for(int i=start; i<end; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		body->velocity_func(body, gravity, damping, dt);
+	}
+	
+	WorkerBarrier(worker);
+	
+	// Apply cached impulses
+	for(int color=0; color<=OVERFLOW_COLOR; color++){
+		if(ColorIsEmpty(hasty, color)) continue;
+		
+		ApplyCachedImpulses(worker, color);
+		WorkerBarrier(worker);
+	}
+	
+	// Run the impulse solver.
+	for(int i=0; i<space->iterations; i++){
+		for(int color=0; color<=OVERFLOW_COLOR; color++){
+			if(ColorIsEmpty(hasty, color)) continue;
+			
+			ApplyImpulses(worker, color);
+			WorkerBarrier(worker);
+		}
+	}
+}
+
+//MARK: Collision Detection Functions
+
+// Callback from the spatial index. Only collects the pairs so their narrow-phase can be run in parallel.
+static void
+CollectPair(cpShape *a, cpShape *b, cpHastySpace *hasty)
+{
+	cpCollisionHandler *handler;
+	cpBool sensor;
+	if(!cpSpaceFilterShapePair(&hasty->space, &a, &b, &handler, &sensor)) return;
+	
+	hasty->pairs = (cpHastyPair *)GrowBuffer(hasty->pairs, &hasty->maxPairs, hasty->numPairs + 1, sizeof(cpHastyPair));
+	
+	cpHastyPair *pair = hasty->pairs + hasty->numPairs++;
+	pair->a = a;
+	pair->b = b;
+	pair->handler = handler;
+	pair->sensor = sensor;
+}
+
+static void
+CollectShape(cpShape *shape, cpArray *shapes)
+{
+	cpArrayPush(shapes, shape);
+}
+
+//MARK: Step
+
+void
+cpHastySpaceStep(cpSpace *space, cpFloat dt)
+{
+	// don't step if the timestep is 0!
+	if(dt == 0.0f) return;
+	
+	cpHastySpace *hasty = (cpHastySpace *)space;
+	
+	space->stamp++;
+	
+	cpFloat prev_dt = space->curr_dt;
+	space->curr_dt = dt;
+	hasty->dt = dt;
+	
+	cpArray *arbiters = space->arbiters;
+	
+	// Reset and empty the arbiter lists.
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		arb->state = cpArbiterStateNormal;
+		
+		// If both bodies are awake, unthread the arbiter from the contact graph.
+		if(!cpBodyIsSleeping(arb->body_a) && !cpBodyIsSleeping(arb->body_b)){
+			cpArbiterUnthread(arb);
+		}
+	}
+	arbiters->num = 0;
+	
+	cpSpaceLock(space); {
+		// Integrate positions and update the shapes.
+		hasty->shapes->num = 0;
+		cpSpatialIndexEach(space->activeShapes, (cpSpatialIndexIteratorFunc)CollectShape, hasty->shapes);
+		RunWorkers(hasty, IntegratePositions);
+		
+		// Find colliding pairs.
+		cpSpacePushFreshContactBuffer(space);
+		hasty->numPairs = 0;
+		hasty->numLeaves = cpBBTreeReindexBegin(space->activeShapes, hasty->numThreads);
+		if(hasty->numLeaves >= 0){
+			// The tree queries run on the workers, then the pairs are collected in order.
+			RunWorkers(hasty, MarkLeaves);
+			cpBBTreeReindexEnd(space->activeShapes, (cpSpatialIndexQueryFunc)CollectPair, hasty);
+		} else {
+			cpSpatialIndexReindexQuery(space->activeShapes, (cpSpatialIndexQueryFunc)CollectPair, hasty);
+		}
+		RunWorkers(hasty, CollidePairs);
+		
+		// Update the arbiters in the same order as cpSpaceStep().
+		for(int i=0; i<hasty->numPairs; i++){
+			cpHastyPair *pair = hasty->pairs + i;
+			int numContacts = pair->numContacts;
+			if(!numContacts) continue;
+			
+			cpContact *contacts = cpContactBufferGetArray(space);
+			memcpy(contacts, pair->contacts, numContacts*sizeof(cpContact));
+			cpSpacePushContacts(space, numContacts);
+			
+			cpSpaceUpdateArbiter(space, pair->a, pair->b, pair->handler, pair->sensor, contacts, numContacts);
+		}
+	} cpSpaceUnlock(space, cpFalse);
+	
+	// Rebuild the contact graph (and detect sleeping components if sleeping is enabled)
+	cpSpaceProcessComponents(space, dt);
+	
+	cpSpaceLock(space); {
+		// Clear out old cached arbiters and call separate callbacks
+		cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter, space);
+		
+		ColorArbitersAndConstraints(hasty);
+		
+		// Prestep, integrate velocities and run the impulse solver.
+		hasty->slop = space->collisionSlop;
+		hasty->biasCoef = 1.0f - cpfpow(space->collisionBias, dt);
+		hasty->damping = cpfpow(space->damping, dt);
+		hasty->dt_coef = (prev_dt == 0.0f ? 0.0f : dt/prev_dt);
+		RunWorkers(hasty, Solve);
+		
+		// Run the constraint post-solve callbacks
+		cpArray *constraints = space->constraints;
+		for(int i=0; i<constraints->num; i++){
+			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+			
+			cpConstraintPostSolveFunc postSolve = constraint->postSolve;
+			if(postSolve) postSolve(constraint, space);
+		}
+		
+		// run the post-solve callbacks
+		for(int i=0; i<arbiters->num; i++){
+			cpArbiter *arb = (cpArbiter *) arbiters->arr[i];
+			
+			cpCollisionHandler *handler = arb->handler;
+			handler->postSolve(arb, space, handler->data);
+		}
+	} cpSpaceUnlock(space, cpTrue);
+}
@@ -113,6 +113,7 @@ cpSpaceInit(cpSpace *space)
 	space->sleepTimeThreshold = INFINITY;
 	space->idleSpeedThreshold = 0.0f;
 	space->enableContactGraph = cpFalse;
+	space->batchContacts = cpFalse;
 	
 	space->arbiters = cpArrayNew(0);
 	space->pooledArbiters = cpArrayNew(0);
@@ -121,6 +122,7 @@ cpSpaceInit(cpSpace *space)
 	space->cachedArbiters = cpHashSetNew(0, (cpHashSetEqlFunc)arbiterSetEql);
 	
 	space->constraints = cpArrayNew(0);
+	space->contactBatches = cpContactBatchesNew();
 	
 	space->defaultHandler = cpDefaultCollisionHandler;
 	space->collisionHandlers = cpHashSetNew(0, (cpHashSetEqlFunc)handlerSetEql);
@@ -154,6 +156,7 @@ cpSpaceDestroy(cpSpace *space)
 	cpArrayFree(space->rousedBodies);
 	
 	cpArrayFree(space->constraints);
+	cpContactBatchesFree(space->contactBatches);
 	
 	cpHashSetFree(space->cachedArbiters);
 	
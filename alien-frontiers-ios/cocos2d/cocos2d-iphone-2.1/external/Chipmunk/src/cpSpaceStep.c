@@ -218,31 +218,47 @@ queryReject(cpShape *a, cpShape *b)
 	);
 }
 
-// Callback from the spatial hash.
-void
-cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space)
+cpBool
+cpSpaceFilterShapePair(cpSpace *space, cpShape **a, cpShape **b, cpCollisionHandler **handler, cpBool *sensor)
 {
 	// Reject any of the simple cases
-	if(queryReject(a,b)) return;
+	if(queryReject(*a, *b)) return cpFalse;
 	
-	cpCollisionHandler *handler = cpSpaceLookupHandler(space, a->collision_type, b->collision_type);
+	*handler = cpSpaceLookupHandler(space, (*a)->collision_type, (*b)->collision_type);
 	
-	cpBool sensor = a->sensor || b->sensor;
-	if(sensor && handler == &cpDefaultCollisionHandler) return;
+	*sensor = (*a)->sensor || (*b)->sensor;
+	if(*sensor && *handler == &cpDefaultCollisionHandler) return cpFalse;
 	
 	// Shape 'a' should have the lower shape type. (required by cpCollideShapes() )
-	if(a->klass->type > b->klass->type){
-		cpShape *temp = a;
-		a = b;
-		b = temp;
+	if((*a)->klass->type > (*b)->klass->type){
+		cpShape *temp = *a;
+		*a = *b;
+		*b = temp;
 	}
 	
+	return cpTrue;
+}
+
+// Callback from the spatial hash.
+void
+cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space)
+{
+	cpCollisionHandler *handler;
+	cpBool sensor;
+	if(!cpSpaceFilterShapePair(space, &a, &b, &handler, &sensor)) return;
+	
 	// Narrow-phase collision detection.
 	cpContact *contacts = cpContactBufferGetArray(space);
 	int numContacts = cpCollideShapes(a, b, contacts);
 	if(!numContacts) return; // Shapes are not colliding.
 	cpSpacePushContacts(space, numContacts);
 	
+	cpSpaceUpdateArbiter(space, a, b, handler, sensor, contacts, numContacts);
+}
+
+void
+cpSpaceUpdateArbiter(cpSpace *space, cpShape *a, cpShape *b, cpCollisionHandler *handler, cpBool sensor, cpContact *contacts, int numContacts)
+{
 	// Get an arbiter from space->arbiterSet for the two shapes.
 	// This is where the persistant contact magic comes from.
 	cpShape *shape_pair[] = {a, b};
@@ -406,14 +422,30 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 		}
 		
 		// Run the impulse solver.
-		for(int i=0; i<space->iterations; i++){
-			for(int j=0; j<arbiters->num; j++){
-				cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j]);
-			}
+		if(space->batchContacts){
+			cpContactBatches *batches = space->contactBatches;
+			cpContactBatchesBuild(batches, arbiters);
+			
+			for(int i=0; i<space->iterations; i++){
+				cpContactBatchesApplyImpulse(batches);
 				
-			for(int j=0; j<constraints->num; j++){
-				cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-				constraint->klass->applyImpulse(constraint, dt);
+				for(int j=0; j<constraints->num; j++){
+					cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
+					constraint->klass->applyImpulse(constraint, dt);
+				}
+			}
+			
+			cpContactBatchesStoreImpulses(batches);
+		} else {
+			for(int i=0; i<space->iterations; i++){
+				for(int j=0; j<arbiters->num; j++){
+					cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j]);
+				}
+					
+				for(int j=0; j<constraints->num; j++){
+					cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
+					constraint->klass->applyImpulse(constraint, dt);
+				}
 			}
 		}
 		